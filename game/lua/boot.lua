@@ -1,7 +1,10 @@
 log.info("Game started!")
 
 local world = stormkit.world
-local player_texture = stormkit.resources:load_image("./textures/player_tileset.png")
+-- the sprite shows up once the texture is uploaded, the placeholder is drawn until then
+local player_texture = stormkit.resources:load_image_async("./textures/player_tileset.png", function(_, success)
+    if not success then log.error("Failed to load player texture!") end
+end)
 
 local function make_player()
     local sprite_rect = math.fbounding_rect.new(0, 0, 16, 22)
@@ -12,6 +15,10 @@ local function make_player()
     return player
 end
 
+-- on hot reload this chunk runs again up to here, the locals above are recreated for this run only and the scene built
+-- below is kept as is, shared helpers meant to be redefined live in their own modules
+if stormkit.reloading then return end
+
 local player = make_player()
 
 local test = world:make_entity()
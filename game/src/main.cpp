@@ -14,7 +14,8 @@ using namespace stormkit::literals;
 namespace stdfs = std::filesystem;
 
 #ifndef LUA_DIR
-static constexpr auto LUA_DIR = "../share/lua";
+// read from assets.skpack, packed next to the binary
+static constexpr auto LUA_DIR = "lua";
 #endif
 
 ////////////////////////////////////////
@@ -16,7 +16,7 @@ target("game", function()
     --
     add_packages("libjpeg-turbo")
 
-    add_deps("stormkit::engine")
+    add_deps("stormkit::engine", "stormkit::pack")
 
     add_packages("slang")
 
@@ -30,5 +30,15 @@ target("game", function()
         end
     end)
 
+    after_build(function(target)
+        -- scripts and textures are packed next to the binary, lua_dir must then be "lua"
+        local pack = target:dep("stormkit::pack")
+        local output = path.join(target:targetdir(), "assets.skpack")
+        local args = { path.join(os.projectdir(), "game"), output, "lua", "textures" }
+        -- release builds only ship the compiled scripts
+        if not get_config("devmode") then table.insert(args, 1, "--bytecode") end
+        os.vrunv(pack:targetfile(), args)
+    end)
+
     if get_config("devmode") then set_rundir("$(projectdir)/game") end
 end)
@@ -5,6 +5,10 @@
 export module stormkit.engine;
 
 export import :core;
+export import :vfs;
+export import :lua_profiler;
+export import :simulation_clock;
+export import :snapshot;
 export import :renderer;
 export import :ecs;
 export import :pipeline_2d;
@@ -17,11 +17,19 @@ import stormkit;
 
 import :core;
 import :dirty;
+import :ecs.entity_sparse_set;
+
+export import :renderer.render_queue;
+export import :pipeline_2d.sprite_transforms;
+export import :pipeline_2d.sprite_grid;
 
 export namespace stormkit::engine::pipeline_2d {
+    /// The sprite quad span [0, 1]², it is scaled by the texture bounds extent and scale, rotated, then translated.
     struct TransformComponent {
+        /// world position of the top left corner of the sprite, the origin of the scale and the rotation
         math::fvec2 position = { 0.f, 0.f };
-        math::fvec2 scale    = { 0.f, 0.f };
+        math::fvec2 scale    = { 1.f, 1.f };
+        /// x hold the rotation angle in radians around the z axis
         math::fvec2 rotate   = { 0.f, 0.f };
 
         static constexpr auto component_name() noexcept -> std::string_view { return "TransformComponent"; }
@@ -34,19 +42,103 @@ export namespace stormkit::engine::pipeline_2d {
 
         math::fbounding_rect texture_bounds = {};
 
+        /// sprites are drawn layer by layer, then inside a layer opaque sprites first grouped by texture,
+        /// then translucent sprites from the highest depth to the lowest
+        u8   layer       = 0;
+        f32  depth       = 0.f;
+        bool translucent = true;
+
         static constexpr auto component_name() noexcept -> std::string_view { return "StaticSpriteComponent"; }
 
         static constexpr auto type() noexcept -> entities::ComponentType { return hash(component_name()); }
     };
 
+    /// Frames are read from the texture of the StaticSpriteComponent of the entity, the first one at texture_bounds
+    /// and each next one frame_stride pixels further. The frame is selected in the vertex shader so a running
+    /// animation cost no upload.
+    struct AnimatedSpriteComponent {
+        u32         frame_count    = 1;
+        math::fvec2 frame_stride   = { 0.f, 0.f };
+        f32         frame_duration = 0.1f;
+        /// time on the animation_time() clock at which the first frame is shown
+        f32         start_time     = 0.f;
+
+        static constexpr auto component_name() noexcept -> std::string_view { return "AnimatedSpriteComponent"; }
+
+        static constexpr auto type() noexcept -> entities::ComponentType { return hash(component_name()); }
+    };
+
+    /// Render data of the sprites copied at the end of a simulation step, the frame building read it instead of the world
+    struct SpriteSnapshot {
+        struct Sprite {
+            entities::Entity                       e;
+            /// transform at the previous snapshot, the frames are interpolated from it
+            TransformComponent                     previous;
+            TransformComponent                     transform;
+            StaticSpriteComponent                  sprite;
+            std::optional<AnimatedSpriteComponent> animated;
+        };
+
+        std::vector<Sprite> sprites;
+        /// index of the simulation step it was extracted from
+        u64                 tick  = 0;
+        /// time stepped since the previous snapshot, several ticks when the simulation caught up during a frame
+        fsecond             delta = {};
+    };
+
+    /// Fill the snapshots, keep the transforms of the previous tick. Run as an extract system, on the thread pool.
+    class STORMKIT_ENGINE_API SpriteExtractor {
+      public:
+        /// delta is the time stepped since the previous extract()
+        auto extract(entities::EntityManager&          world,
+                     std::span<const entities::Entity> entities,
+                     fsecond                           delta,
+                     SpriteSnapshot&                   out) noexcept -> void;
+
+        /// sprites having an AnimatedSpriteComponent, set again each time the entities of the animated sprite system
+        /// change, so extract() doesn't look for the component on every sprite
+        auto set_animated(const entities::Entities& entities) noexcept -> void;
+
+      private:
+        // transforms of the previous extract(), and the ones of the current one, swapped so their storage is reused
+        EntitySparseSet<TransformComponent> m_previous;
+        EntitySparseSet<TransformComponent> m_current;
+        EntitySparseSet<std::monostate>     m_animated;
+        u64                                 m_tick = 0;
+    };
+
+    /// seconds elapsed since the first call, the clock given to the sprite shaders
+    STORMKIT_ENGINE_API auto animation_time() noexcept -> f32;
+
+    /// Draws recorded in the sprite raster pass before the sprites, so they end up under them (e.g. the tilemap).
+    /// A second raster task would clear the backbuffer again, so other renderers share this pass instead.
+    struct BackgroundDraws {
+        std::vector<FrameBuilder::ResourceID>                                     buffers;
+        std::function<void(const FrameResourcesAccessor&, gpu::CommandBuffer&)> record;
+    };
+
     class STORMKIT_ENGINE_API SpriteRenderSystem {
         struct PrivateTag {};
 
       public:
         struct Sprite {
             entities::Entity e;
-            gpu::ImageView   texture;
-            gpu::Sampler     sampler;
+            u16              texture;
+        };
+
+        /// CPU culling query the sprite grid and upload the visible sprites each time the camera move,
+        /// GPU culling upload every sprite when they change and cull them in compute tasks feeding indirect draws
+        enum class CullingMode : u8 {
+            CPU,
+            GPU,
+        };
+
+        /// with GPU culling visible and culled are read back from the GPU, buffering_count() frames late
+        struct Statistics {
+            u32 sprites = 0;
+            u32 visible = 0;
+            u32 culled  = 0;
+            u32 batches = 0;
         };
 
         SpriteRenderSystem(PrivateTag) noexcept;
@@ -62,33 +154,78 @@ export namespace stormkit::engine::pipeline_2d {
                            const gpu::RasterPipelineState& initial_state,
                            const gpu::DescriptorSetLayout& camera_descriptor_set) noexcept -> gpu::Expected<SpriteRenderSystem>;
 
-        auto update(entities::EntityManager& world, fsecond delta, const entities::Entities&) noexcept -> void;
+        /// alpha is the position of the frame between the previous and the last tick of the snapshot
+        auto update(const SpriteSnapshot& snapshot, f32 alpha) noexcept -> void;
 
         auto on_message_received(const Renderer&           renderer,
                                  entities::EntityManager&  world,
                                  const entities::Message&  message,
                                  const entities::Entities& entities) noexcept -> void;
 
-        auto insert_tasks(const Application&        application,
-                          FrameBuilder&             graph,
-                          FrameBuilder::ResourceID  backbuffer_id,
-                          FrameBuilder::ResourceID  camera_buffer_id,
-                          const gpu::DescriptorSet& camera_descriptor_set,
-                          u32                       camera_current_offset) noexcept -> void;
+        auto insert_tasks(const Application&          application,
+                          FrameBuilder&               graph,
+                          FrameBuilder::ResourceID    backbuffer_id,
+                          FrameBuilder::ResourceID    camera_buffer_id,
+                          const gpu::DescriptorSet&   camera_descriptor_set,
+                          u32                         camera_current_offset,
+                          const math::fbounding_rect& camera_bounds,
+                          BackgroundDraws             background = {}) noexcept -> void;
+
+        /// dense, indexed by sprite slot
+        auto sprites() const noexcept -> std::span<const Sprite>;
+        auto statistics() const noexcept -> const Statistics&;
 
-        auto sprites() const noexcept -> const std::vector<Sprite>&;
+        auto set_culling_mode(CullingMode mode) noexcept -> void;
+        auto culling_mode() const noexcept -> CullingMode;
 
       private:
         auto do_init(const Renderer&, const gpu::RasterPipelineState&, const gpu::DescriptorSetLayout&) noexcept
           -> gpu::Expected<void>;
 
+        struct IndirectDraws {
+            FrameBuilder::ResourceID commands_buffer_id;
+            u32                      commands_offset;
+            u32                      sprites_offset;
+        };
+
+        auto do_init_gpu_culling(const Renderer&, const gpu::DescriptorSetLayout&) noexcept -> gpu::Expected<void>;
+
         auto update_task(const Application&, FrameBuilder&, FrameBuilder::ResourceID) noexcept -> void;
+        auto cull(const math::fbounding_rect&) noexcept -> void;
+        auto sort_visible() noexcept -> void;
+        auto prepare_gpu_culling() noexcept -> bool;
+        auto build_instances() noexcept -> void;
+        auto patch_instances() noexcept -> void;
+        /// whether a moved sprite entered or left the culled view
+        auto visibility_changed() const noexcept -> bool;
+        /// last is the slot moved into slot by the removal
+        auto remove_instance(u32 slot, u32 last) noexcept -> void;
+        auto build_cull_input() noexcept -> void;
+        auto upload_cull_input_task(const Application&, FrameBuilder&, FrameBuilder::ResourceID) noexcept -> void;
+        auto cull_task(const Application&,
+                       FrameBuilder&,
+                       FrameBuilder::ResourceID,
+                       FrameBuilder::ResourceID,
+                       FrameBuilder::ResourceID,
+                       const gpu::DescriptorSet&,
+                       u32) noexcept -> std::pair<FrameBuilder::ResourceID, IndirectDraws>;
+        auto read_back_statistics(u32) noexcept -> void;
+        auto texture_index(const Renderer&, TextureID) noexcept -> u16;
+        auto release_texture_index(u16) noexcept -> void;
+        auto refresh_textures(const Renderer&) noexcept -> void;
+        auto release_texture_bindings(usize buffering_count) noexcept -> void;
+        /// an atlas is only viewed on its first level
+        auto bind_texture(const Renderer&, TextureID, const gpu::Image&, bool atlas) noexcept
+          -> std::pair<Heap<gpu::ImageView>, Heap<gpu::DescriptorSet>>;
+        auto rebind_texture(const Renderer&, u16, const gpu::Image&) noexcept -> void;
         auto render_static_sprite_task(FrameBuilder&,
                                        FrameBuilder::ResourceID,
                                        FrameBuilder::ResourceID,
                                        FrameBuilder::ResourceID,
                                        const gpu::DescriptorSet&,
-                                       u32) noexcept -> void;
+                                       u32,
+                                       BackgroundDraws,
+                                       std::optional<IndirectDraws> = std::nullopt) noexcept -> void;
 
         struct {
             DeferInit<gpu::Shader> vertex_shader;
@@ -96,6 +233,7 @@ export namespace stormkit::engine::pipeline_2d {
 
             DeferInit<gpu::DescriptorSetLayout> descriptor_layout;
             DeferInit<gpu::DescriptorSet>       descriptor_set;
+            DeferInit<gpu::DescriptorSetLayout> texture_descriptor_layout;
 
             DeferInit<gpu::PipelineLayout> pipeline_layout;
             DeferInit<gpu::Pipeline>       pipeline;
@@ -106,11 +244,114 @@ export namespace stormkit::engine::pipeline_2d {
 
             DeferInit<gpu::Buffer> buffer;
             u32                    current_offset = 0;
+            u32                    instance_count = 0;
         } m_sprite_data;
 
-        using Sprites = Dirtyable<std::vector<Sprite>>;
+        struct {
+            DeferInit<gpu::Shader> cull_shader;
+            DeferInit<gpu::Shader> compact_shader;
+
+            DeferInit<gpu::DescriptorPool>      descriptor_pool;
+            DeferInit<gpu::DescriptorSetLayout> descriptor_layout;
+            DeferInit<gpu::DescriptorSet>       descriptor_set;
+            DeferInit<gpu::DescriptorSet>       render_descriptor_set;
+
+            DeferInit<gpu::PipelineLayout> pipeline_layout;
+            DeferInit<gpu::Pipeline>       cull_pipeline;
+            DeferInit<gpu::Pipeline>       compact_pipeline;
+
+            DeferInit<gpu::Buffer> input_buffer;
+            DeferInit<gpu::Buffer> prefixes_buffer;
+            DeferInit<gpu::Buffer> chunk_counts_buffer;
+            DeferInit<gpu::Buffer> visible_buffer;
+            DeferInit<gpu::Buffer> commands_buffer;
+            DeferInit<gpu::Buffer> stats_buffer;
+
+            // instances culled by the last frame of each region, until its statistics are read back
+            std::vector<std::optional<u32>> stats_instances;
+            // drawIndirectFirstInstance is available
+            bool                            supported = false;
+
+            FrameDirtyable<std::vector<u32>> input        = FrameDirtyable<std::vector<u32>>::create();
+            u32                              input_offset = 0;
+            // instances are laid out in submission order of every sprite
+            bool                             built        = false;
+        } m_gpu_cull_data;
+
+        struct Texture {
+            TextureID                id;
+            Ref<const gpu::Image>    image;
+            Heap<gpu::ImageView>     view;
+            Heap<gpu::DescriptorSet> descriptor_set;
+            math::fvec2              inverse_extent;
+            // sprites using this index, the entry is recycled once it drops to zero
+            u32                      references = 0;
+            // a sprite sample only part of it, its smaller levels would blend the neighbouring frames
+            bool                     atlas      = false;
+        };
+
+        struct {
+            DeferInit<gpu::DescriptorPool> descriptor_pool;
+            DeferInit<gpu::Sampler>        sampler;
+
+            // deque keep descriptor sets at the same address for the render tasks in flight
+            std::deque<Texture>     textures;
+            HashMap<TextureID, u16> indices;
+            std::vector<u16>        free_indices;
+            // found to be atlases by the last update, bound again on their first level
+            std::vector<u16>        new_atlases;
+
+            struct Retired {
+                Heap<gpu::ImageView>     view;
+                Heap<gpu::DescriptorSet> descriptor_set;
+                u64                      frame;
+            };
+
+            // bindings replaced by a reloaded image, kept alive for the frames in flight then given back to the pool
+            std::deque<Retired> retired;
+            u64                 frame    = 0;
+            u32                 revision = 0;
+        } m_texture_data;
+
+        // removing a sprite move the last one into its slot, the parallel arrays below follow the same swaps
+        using Sprites = Dirtyable<EntitySparseSet<Sprite>>;
+
+        Sprites                         m_sprites = Sprites::create_dirty();
+        SpriteTransforms                m_transforms;
+        std::vector<u64>                m_sort_keys;
+        std::vector<std::array<f32, 4>> m_uv_rects;
+
+        struct Animation {
+            std::array<f32, 4> frames     = { 0.f, 0.f, 1.f, 0.f };
+            f32                start_time = 0.f;
+
+            constexpr auto operator==(const Animation&) const noexcept -> bool = default;
+        };
+
+        std::vector<Animation> m_animations;
+
+        // sprites in submission order, each frame in flight get the ranges it miss
+        static constexpr auto NO_INSTANCE = std::numeric_limits<u32>::max();
+
+        RangeDirtyable<std::vector<SpriteInstance>> m_instances = RangeDirtyable<std::vector<SpriteInstance>>::create();
+        std::vector<u32>                            m_instance_of_slot;
+        // slots which only moved since the instances were built
+        std::vector<u32>                            m_moved_slots;
+        // instances of removed sprites left as empty quads until the next rebuild compact them
+        u32                                         m_hidden_instances = 0;
 
-        Sprites m_sprites = Sprites::create_dirty();
+        SpriteGrid           m_grid;
+        math::fbounding_rect m_camera_bounds = {};
+
+        std::vector<entities::Entity> m_visible_entities;
+        std::vector<u32>              m_visible_slots;
+        SpriteTransforms              m_visible_transforms;
+
+        RenderQueue            m_render_queue;
+        std::vector<DrawBatch> m_batches;
+
+        Statistics  m_statistics;
+        CullingMode m_culling_mode = CullingMode::CPU;
     };
 } // namespace stormkit::engine::pipeline_2d
 
@@ -123,7 +364,7 @@ namespace stormkit::engine::pipeline_2d {
     //////////////////////////////////////
     STORMKIT_FORCE_INLINE
     inline SpriteRenderSystem::SpriteRenderSystem(PrivateTag) noexcept
-        : m_sprites { Dirtyable<std::vector<Sprite>>::create_dirty() } {
+        : m_sprites { Sprites::create_dirty() } {
     }
 
     //////////////////////////////////////
@@ -143,8 +384,33 @@ namespace stormkit::engine::pipeline_2d {
     //////////////////////////////////////
     //////////////////////////////////////
     STORMKIT_FORCE_INLINE
-    inline auto SpriteRenderSystem::sprites() const noexcept -> const std::vector<Sprite>& {
-        return m_sprites.read();
+    inline auto SpriteRenderSystem::sprites() const noexcept -> std::span<const Sprite> {
+        return m_sprites.read().values();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SpriteRenderSystem::statistics() const noexcept -> const Statistics& {
+        return m_statistics;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SpriteRenderSystem::set_culling_mode(CullingMode mode) noexcept -> void {
+        if (m_culling_mode == mode) return;
+
+        m_culling_mode        = mode;
+        m_gpu_cull_data.built = false;
+        m_sprites.mark_dirty();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SpriteRenderSystem::culling_mode() const noexcept -> CullingMode {
+        return m_culling_mode;
     }
 
     //////////////////////////////////////
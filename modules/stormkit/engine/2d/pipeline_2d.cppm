@@ -18,8 +18,11 @@ import stormkit;
 import :core;
 import :renderer;
 import :dirty;
+import :snapshot;
 import :ecs.sprite_render_system;
 
+export import :pipeline_2d.tilemap;
+
 namespace stdr = std::ranges;
 
 export namespace stormkit::engine {
@@ -30,7 +33,7 @@ export namespace stormkit::engine {
         static constexpr auto layout_binding() -> gpu::DescriptorSetLayoutBinding {
             return { .binding          = 0,
                      .type             = gpu::DescriptorType::UNIFORM_BUFFER_DYNAMIC,
-                     .stages           = gpu::ShaderStageFlag::VERTEX,
+                     .stages           = gpu::ShaderStageFlag::VERTEX | gpu::ShaderStageFlag::COMPUTE,
                      .descriptor_count = 1 };
         }
     };
@@ -58,10 +61,25 @@ export namespace stormkit::engine {
 
         auto update_framegraph(const Application& application, FrameBuilder& graph) noexcept -> void;
 
+        auto set_camera_position(const math::fvec2& position) noexcept -> void;
+        [[nodiscard]]
+        auto camera_position() const noexcept -> const math::fvec2&;
+        /// world space rectangle seen by the camera
+        [[nodiscard]]
+        auto camera_bounds() const noexcept -> math::fbounding_rect;
+
+        [[nodiscard]]
+        auto sprite_statistics() const noexcept -> pipeline_2d::SpriteRenderSystem::Statistics;
+
+        auto set_sprite_culling_mode(pipeline_2d::SpriteRenderSystem::CullingMode mode) noexcept -> void;
+
+        [[nodiscard]]
+        auto tilemap() noexcept -> Locked<DeferInit<pipeline_2d::TilemapRenderer>>&;
+
       private:
         auto do_init(Application&) noexcept -> gpu::Expected<void>;
 
-        auto update_task(const Renderer&, FrameBuilder&, FrameBuilder::ResourceID) noexcept -> void;
+        auto update_task(FrameBuilder&, FrameBuilder::ResourceID, u32) noexcept -> void;
 
         Ref<const Locked<entities::EntityManager>> m_world;
 
@@ -79,13 +97,19 @@ export namespace stormkit::engine {
         struct _ViewData {
             Camera         camera;
             math::fextent2 viewport;
+            math::fvec2    position = { 0.f, 0.f };
         };
 
-        using ViewData = Dirtyable<_ViewData>;
+        using ViewData = FrameDirtyable<_ViewData>;
 
         ViewData m_view;
 
         Locked<DeferInit<pipeline_2d::SpriteRenderSystem>> m_sprite_render_system;
+        Locked<DeferInit<pipeline_2d::TilemapRenderer>>    m_tilemap_renderer;
+
+        // written by the extract system, read by the frame building, neither take the world lock
+        pipeline_2d::SpriteExtractor                m_sprite_extractor;
+        SnapshotBuffer<pipeline_2d::SpriteSnapshot> m_sprite_snapshots;
     };
 
     inline constexpr auto PIPELINE_2D_LOGGER = log::Module { "2d pipeline" };
@@ -130,4 +154,56 @@ namespace stormkit::engine {
         Try(sprite_renderer->do_init(application));
         Return sprite_renderer;
     }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Pipeline2D::set_camera_position(const math::fvec2& position) noexcept -> void {
+        auto& view       = m_view.write();
+        view.position    = position;
+        view.camera.view = math::translate(math::fmat4::identity(), math::fvec3 { -position.x, -position.y, 0.f });
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Pipeline2D::camera_position() const noexcept -> const math::fvec2& {
+        return m_view.read().position;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Pipeline2D::camera_bounds() const noexcept -> math::fbounding_rect {
+        const auto& view = m_view.read();
+
+        auto bounds   = math::fbounding_rect {};
+        bounds.left   = view.position.x;
+        bounds.top    = view.position.y;
+        bounds.right  = view.position.x + view.viewport.width;
+        bounds.bottom = view.position.y + view.viewport.height;
+
+        return bounds;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Pipeline2D::sprite_statistics() const noexcept -> pipeline_2d::SpriteRenderSystem::Statistics {
+        return m_sprite_render_system.read()->statistics();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Pipeline2D::set_sprite_culling_mode(pipeline_2d::SpriteRenderSystem::CullingMode mode) noexcept -> void {
+        m_sprite_render_system.write()->set_culling_mode(mode);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Pipeline2D::tilemap() noexcept -> Locked<DeferInit<pipeline_2d::TilemapRenderer>>& {
+        return m_tilemap_renderer;
+    }
 } // namespace stormkit::engine
@@ -0,0 +1,118 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:pipeline_2d.sprite_grid;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine::pipeline_2d {
+    /// Uniform grid over sprite bounds, cells are hashed so the grid is unbounded.
+    class STORMKIT_ENGINE_API SpriteGrid {
+      public:
+        static constexpr auto DEFAULT_CELL_SIZE = 256.f;
+
+        explicit SpriteGrid(f32 cell_size = DEFAULT_CELL_SIZE) noexcept;
+        ~SpriteGrid() noexcept;
+
+        SpriteGrid(const SpriteGrid&)                    = delete;
+        auto operator=(const SpriteGrid&) -> SpriteGrid& = delete;
+
+        SpriteGrid(SpriteGrid&&) noexcept;
+        auto operator=(SpriteGrid&&) noexcept -> SpriteGrid&;
+
+        /// insert e or move it if its bounds now cover other cells
+        auto update(entities::Entity e, const math::fbounding_rect& bounds) noexcept -> void;
+        auto remove(entities::Entity e) noexcept -> void;
+        auto clear() noexcept -> void;
+
+        /// append every entity whose cells overlap rect to out, each entity is reported once
+        auto query(const math::fbounding_rect& rect, std::vector<entities::Entity>& out) const noexcept -> void;
+
+        [[nodiscard]]
+        auto size() const noexcept -> usize;
+        [[nodiscard]]
+        auto cell_size() const noexcept -> f32;
+
+      private:
+        struct CellRange {
+            i32 min_x = 0;
+            i32 min_y = 0;
+            i32 max_x = -1;
+            i32 max_y = -1;
+
+            constexpr auto operator==(const CellRange&) const noexcept -> bool = default;
+        };
+
+        struct Entry {
+            entities::Entity e;
+            CellRange        cells;
+            mutable u32      query_stamp = 0;
+        };
+
+        auto to_cell_range(const math::fbounding_rect& bounds) const noexcept -> CellRange;
+        auto link(u32 entry, const CellRange& range) noexcept -> void;
+        auto unlink(u32 entry, const CellRange& range) noexcept -> void;
+
+        f32 m_cell_size;
+        f32 m_inv_cell_size;
+
+        HashMap<u64, std::vector<u32>> m_cells;
+        HashMap<entities::Entity, u32> m_entry_of;
+        std::vector<Entry>             m_entries;
+        std::vector<u32>               m_free_entries;
+        mutable u32                    m_query_stamp = 0;
+    };
+} // namespace stormkit::engine::pipeline_2d
+
+/////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+/////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine::pipeline_2d {
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SpriteGrid::SpriteGrid(f32 cell_size) noexcept
+        : m_cell_size { cell_size }, m_inv_cell_size { 1.f / cell_size } {
+        EXPECTS(cell_size > 0.f);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SpriteGrid::~SpriteGrid() noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SpriteGrid::SpriteGrid(SpriteGrid&&) noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SpriteGrid::operator=(SpriteGrid&&) noexcept -> SpriteGrid& = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SpriteGrid::size() const noexcept -> usize {
+        return std::ranges::size(m_entry_of);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SpriteGrid::cell_size() const noexcept -> f32 {
+        return m_cell_size;
+    }
+} // namespace stormkit::engine::pipeline_2d
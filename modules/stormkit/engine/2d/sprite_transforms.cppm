@@ -0,0 +1,121 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:pipeline_2d.sprite_transforms;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine::pipeline_2d {
+    /// Per sprite data consumed by quad_sprite.wgsl. The model transform is 2D affine, a corner of the unit quad is
+    /// placed at origin.xy + basis.xy * x + basis.zw * y, the full matrix is only rebuilt by the shaders.
+    struct alignas(16) SpriteInstance {
+        /// the two transformed axis of the quad, scaled by the sprite extent
+        std::array<f32, 4>  basis           = { 1.f, 0.f, 0.f, 1.f };
+        /// xy hold the translation, zw are padding
+        std::array<f32, 4>  origin          = {};
+        /// texture coordinates of the sprite, left, top, right, bottom in [0, 1]
+        std::array<f32, 4>  uv_rect         = { 0.f, 0.f, 1.f, 1.f };
+        /// uv offset between two frames, frame count and frame duration in seconds, see AnimatedSpriteComponent
+        std::array<f32, 4>  animation       = { 0.f, 0.f, 1.f, 0.f };
+        /// x hold the animation start time on the animation_time() clock
+        std::array<f32, 4>  animation_start = {};
+    };
+
+    /// Structure of arrays holding everything needed to build sprite model matrices,
+    /// each array is indexed by the sprite slot.
+    class STORMKIT_ENGINE_API SpriteTransforms {
+      public:
+        SpriteTransforms() noexcept;
+        ~SpriteTransforms() noexcept;
+
+        SpriteTransforms(const SpriteTransforms&)                    = delete;
+        auto operator=(const SpriteTransforms&) -> SpriteTransforms& = delete;
+
+        SpriteTransforms(SpriteTransforms&&) noexcept;
+        auto operator=(SpriteTransforms&&) noexcept -> SpriteTransforms&;
+
+        auto resize(usize count) noexcept -> void;
+        auto clear() noexcept -> void;
+        [[nodiscard]]
+        auto size() const noexcept -> usize;
+
+        /// move the last slot into index then drop the last slot
+        auto swap_remove(usize index) noexcept -> void;
+
+        /// copy the slots listed in indices from other, in order
+        auto gather(const SpriteTransforms& other, std::span<const u32> indices) noexcept -> void;
+
+        /// returns true if the slot changed
+        auto set(usize             index,
+                 const math::fvec2& position,
+                 const math::fvec2& scale,
+                 f32                rotation,
+                 const math::fvec2& extent) noexcept -> bool;
+
+        std::vector<f32> position_x;
+        std::vector<f32> position_y;
+        std::vector<f32> scale_x;
+        std::vector<f32> scale_y;
+        std::vector<f32> rotation;
+        std::vector<f32> rotation_cos;
+        std::vector<f32> rotation_sin;
+        std::vector<f32> width;
+        std::vector<f32> height;
+    };
+
+    /// Axis aligned bounds of the transformed quad of a sprite.
+    [[nodiscard]]
+    STORMKIT_ENGINE_API auto sprite_bounds(const SpriteTransforms& transforms, usize index) noexcept -> math::fbounding_rect;
+
+    /// Build the basis and origin of every sprite in transforms into out, out must be at least transforms.size() long.
+    /// Only these two fields are written, the kernel is bound by the bytes it store.
+    STORMKIT_ENGINE_API auto compute_sprite_instances(const SpriteTransforms& transforms, std::span<SpriteInstance> out) noexcept
+      -> void;
+
+    /// Name of the instruction set compute_sprite_instances use, picked at runtime on x86-64.
+    [[nodiscard]]
+    STORMKIT_ENGINE_API auto sprite_transforms_kernel_name() noexcept -> std::string_view;
+} // namespace stormkit::engine::pipeline_2d
+
+/////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+/////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine::pipeline_2d {
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SpriteTransforms::SpriteTransforms() noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SpriteTransforms::~SpriteTransforms() noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SpriteTransforms::SpriteTransforms(SpriteTransforms&&) noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SpriteTransforms::operator=(SpriteTransforms&&) noexcept -> SpriteTransforms& = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SpriteTransforms::size() const noexcept -> usize {
+        return std::ranges::size(position_x);
+    }
+} // namespace stormkit::engine::pipeline_2d
@@ -0,0 +1,363 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/platform_macro.hpp>
+#include <stormkit/core/try_expected.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:pipeline_2d.tilemap;
+
+import std;
+
+import stormkit;
+
+import :core;
+import :ecs.sprite_render_system;
+
+namespace stdfs = std::filesystem;
+
+export namespace stormkit::engine::pipeline_2d {
+    /// Tiles are stored by CHUNK_SIZE x CHUNK_SIZE chunks in a map file, only the chunks streamed around the camera
+    /// and the modified ones are kept in memory.
+    ///
+    /// The map file start with a header and the index of its chunks, followed by the run length encoded tiles
+    /// of each chunk, so a chunk is loaded with a single read.
+    class STORMKIT_ENGINE_API Tilemap {
+      public:
+        static constexpr auto CHUNK_SIZE       = 32;
+        static constexpr auto CHUNK_TILE_COUNT = usize { CHUNK_SIZE * CHUNK_SIZE };
+        /// tile n is the n - 1 tile of the tileset
+        static constexpr auto EMPTY_TILE       = u16 { 0 };
+
+        struct ChunkCoord {
+            i32 x = 0;
+            i32 y = 0;
+
+            constexpr auto operator==(const ChunkCoord&) const noexcept -> bool = default;
+        };
+
+        /// inclusive range of chunks
+        struct ChunkRange {
+            ChunkCoord min;
+            ChunkCoord max;
+
+            constexpr auto contains(const ChunkCoord& coord) const noexcept -> bool;
+        };
+
+        struct Chunk {
+            ChunkCoord                        coord;
+            std::array<u16, CHUNK_TILE_COUNT> tiles    = {};
+            /// bumped each time the chunk is loaded or modified, tell the renderer to bake it again
+            u32                               revision = 0;
+            /// modified chunks stay in memory until saved
+            bool                              modified = false;
+        };
+
+        Tilemap() noexcept;
+        ~Tilemap() noexcept;
+
+        Tilemap(const Tilemap&)                    = delete;
+        auto operator=(const Tilemap&) -> Tilemap& = delete;
+
+        Tilemap(Tilemap&&) noexcept;
+        auto operator=(Tilemap&&) noexcept -> Tilemap&;
+
+        /// drop the chunks in memory and read the index of the map file, a missing file open an empty map
+        auto open(const stdfs::path& path) noexcept -> bool;
+        auto save() noexcept -> bool;
+        auto save(const stdfs::path& path) noexcept -> bool;
+
+        auto set_tile(i32 x, i32 y, u16 tile) noexcept -> void;
+        auto tile(i32 x, i32 y) noexcept -> u16;
+        auto fill(i32 x, i32 y, u32 width, u32 height, u16 tile) noexcept -> void;
+
+        /// unload the unmodified chunks outside of range and request the ones of range present in the map file, they are
+        /// read and decoded on the thread pool and show up in chunks() from a later call once done
+        auto stream(const ChunkRange& range, ThreadPool& thread_pool) noexcept -> void;
+
+        [[nodiscard]]
+        auto chunks() const noexcept -> const HashMap<u64, Chunk>&;
+        [[nodiscard]]
+        auto path() const noexcept -> const stdfs::path&;
+
+        static constexpr auto chunk_key(const ChunkCoord& coord) noexcept -> u64;
+        static constexpr auto chunk_of(i32 x, i32 y) noexcept -> ChunkCoord;
+
+      private:
+        using Tiles = std::array<u16, CHUNK_TILE_COUNT>;
+
+        struct IndexEntry {
+            ChunkCoord coord;
+            u64        offset;
+            u32        size;
+        };
+
+        /// chunk read by the thread pool, std::nullopt if it couldn't be read or decoded
+        struct Loading {
+            ChunkCoord                        coord;
+            std::future<std::optional<Tiles>> tiles;
+        };
+
+        auto read_index(const stdfs::path& path) noexcept -> bool;
+        auto read_payload(const IndexEntry& entry) noexcept -> std::optional<std::vector<u16>>;
+        /// a chunk still loading on the thread pool is waited for, edits don't wait for the next stream()
+        auto find_or_load(const ChunkCoord& coord, bool create) noexcept -> Chunk*;
+        /// move the loaded chunks to m_chunks, wait for the ones still loading if wait is true
+        auto finish_loads(bool wait) noexcept -> void;
+        auto finish_load(u64 key, Loading& loading) noexcept -> void;
+
+        stdfs::path   m_path;
+        std::ifstream m_file;
+
+        HashMap<u64, IndexEntry> m_index;
+        HashMap<u64, Chunk>      m_chunks;
+        HashMap<u64, Loading>    m_loading;
+        u32                      m_revision = 0;
+    };
+
+    /// Bake each streamed chunk once in a slot of a GPU buffer, a chunk is then drawn by a single instanced draw
+    /// recorded in the sprite raster pass.
+    class STORMKIT_ENGINE_API TilemapRenderer {
+        struct PrivateTag {};
+
+      public:
+        TilemapRenderer(PrivateTag) noexcept;
+        ~TilemapRenderer() noexcept;
+
+        TilemapRenderer(const TilemapRenderer&)                    = delete;
+        auto operator=(const TilemapRenderer&) -> TilemapRenderer& = delete;
+
+        TilemapRenderer(TilemapRenderer&&) noexcept;
+        auto operator=(TilemapRenderer&&) noexcept -> TilemapRenderer&;
+
+        static auto create(const Renderer&                 renderer,
+                           const gpu::RasterPipelineState& initial_state,
+                           const gpu::DescriptorSetLayout& camera_descriptor_set) noexcept -> gpu::Expected<TilemapRenderer>;
+
+        /// tile_extent is the size in pixels of a tile in the texture, tile_size its size in the world
+        auto set_tileset(TextureID texture, const math::fextent2& tile_extent, const math::fextent2& tile_size) noexcept
+          -> void;
+
+        auto insert_tasks(const Application&          application,
+                          FrameBuilder&               graph,
+                          const gpu::DescriptorSet&   camera_descriptor_set,
+                          u32                         camera_current_offset,
+                          const math::fbounding_rect& camera_bounds) noexcept -> BackgroundDraws;
+
+        [[nodiscard]]
+        auto tilemap() noexcept -> Tilemap&;
+        [[nodiscard]]
+        auto tilemap() const noexcept -> const Tilemap&;
+
+      private:
+        auto do_init(const Renderer&, const gpu::RasterPipelineState&, const gpu::DescriptorSetLayout&) noexcept
+          -> gpu::Expected<void>;
+
+        auto chunk_range(const math::fbounding_rect&, i32 margin) const noexcept -> Tilemap::ChunkRange;
+        auto update_tileset(const Renderer&) noexcept -> void;
+        auto refresh_tileset(const Renderer&) noexcept -> void;
+        auto release_slots(usize buffering_count) noexcept -> void;
+        auto bake(const Tilemap::Chunk&) const noexcept -> std::vector<u32>;
+        auto upload_task(FrameBuilder&, FrameBuilder::ResourceID, std::vector<std::pair<u32, std::vector<u32>>>) noexcept
+          -> void;
+
+        struct {
+            DeferInit<gpu::Shader> vertex_shader;
+            DeferInit<gpu::Shader> fragment_shader;
+
+            DeferInit<gpu::DescriptorPool>      descriptor_pool;
+            DeferInit<gpu::DescriptorSetLayout> chunks_descriptor_layout;
+            DeferInit<gpu::DescriptorSet>       chunks_descriptor_set;
+            DeferInit<gpu::DescriptorSetLayout> tileset_descriptor_layout;
+
+            DeferInit<gpu::PipelineLayout> pipeline_layout;
+            DeferInit<gpu::Pipeline>       pipeline;
+
+            DeferInit<gpu::Buffer> chunks_buffer;
+        } m_render_data;
+
+        struct TilesetView {
+            TextureID                id;
+            Ref<const gpu::Image>    image;
+            gpu::ImageView           view;
+            // on the heap, the render tasks in flight hold it while the view is recycled
+            Heap<gpu::DescriptorSet> descriptor_set;
+            math::fextent2           extent;
+            // frame the view stopped being bound, it is recycled once the frames in flight are done
+            std::optional<u64>       retired = std::nullopt;
+        };
+
+        struct {
+            TextureID      texture     = INVALID_TEXTURE_ID;
+            math::fextent2 tile_extent = { 16.f, 16.f };
+            math::fextent2 tile_size   = { 16.f, 16.f };
+            math::fvec2    tile_uv     = { 0.f, 0.f };
+            u32            columns     = 1;
+            u32            revision    = 0;
+            u32            applied     = 0;
+            // ResourceStore::revision() seen last, a change may mean the tileset left its placeholder
+            u32       resources_revision = 0;
+            // texture referenced in the resource store
+            TextureID acquired           = INVALID_TEXTURE_ID;
+
+            DeferInit<gpu::Sampler> sampler;
+            // a retired view is recycled in place once the frames in flight are done
+            std::deque<TilesetView> views;
+            usize                   current = 0;
+        } m_tileset;
+
+        struct GpuChunk {
+            Tilemap::ChunkCoord coord;
+
+            u32 slot;
+            u32 revision;
+            u32 tileset_revision;
+            u32 tile_count;
+        };
+
+        Tilemap m_tilemap;
+
+        HashMap<u64, GpuChunk>          m_gpu_chunks;
+        std::vector<u32>                m_free_slots;
+        std::deque<std::pair<u32, u64>> m_retired_slots;
+        u64                             m_frame = 0;
+        // set while streamed chunks are left without a slot, to warn once when it happens
+        bool                            m_slots_exhausted = false;
+    };
+} // namespace stormkit::engine::pipeline_2d
+
+/////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+/////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine::pipeline_2d {
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline constexpr auto Tilemap::ChunkRange::contains(const ChunkCoord& coord) const noexcept -> bool {
+        return coord.x >= min.x and coord.x <= max.x and coord.y >= min.y and coord.y <= max.y;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline Tilemap::Tilemap() noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline Tilemap::~Tilemap() noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline Tilemap::Tilemap(Tilemap&&) noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Tilemap::operator=(Tilemap&&) noexcept -> Tilemap& = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Tilemap::save() noexcept -> bool {
+        return save(m_path);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Tilemap::chunks() const noexcept -> const HashMap<u64, Chunk>& {
+        return m_chunks;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Tilemap::path() const noexcept -> const stdfs::path& {
+        return m_path;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline constexpr auto Tilemap::chunk_key(const ChunkCoord& coord) noexcept -> u64 {
+        return (u64 { std::bit_cast<u32>(coord.x) } << 32u) | u64 { std::bit_cast<u32>(coord.y) };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline constexpr auto Tilemap::chunk_of(i32 x, i32 y) noexcept -> ChunkCoord {
+        // rounded toward negative infinity so negative tiles land in negative chunks
+        const auto floor_div = [](i32 value) static noexcept {
+            return value >= 0 ? value / CHUNK_SIZE : -((-value + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        };
+
+        return { floor_div(x), floor_div(y) };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline TilemapRenderer::TilemapRenderer(PrivateTag) noexcept {
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline TilemapRenderer::~TilemapRenderer() noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline TilemapRenderer::TilemapRenderer(TilemapRenderer&&) noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto TilemapRenderer::operator=(TilemapRenderer&&) noexcept -> TilemapRenderer& = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto TilemapRenderer::create(const Renderer&                 renderer,
+                                        const gpu::RasterPipelineState& initial_state,
+                                        const gpu::DescriptorSetLayout& camera_descriptor_set) noexcept
+      -> gpu::Expected<TilemapRenderer> {
+        auto out = TilemapRenderer { PrivateTag {} };
+        Try(out.do_init(renderer, initial_state, camera_descriptor_set));
+        Return out;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto TilemapRenderer::set_tileset(TextureID             texture,
+                                             const math::fextent2& tile_extent,
+                                             const math::fextent2& tile_size) noexcept -> void {
+        m_tileset.texture     = texture;
+        m_tileset.tile_extent = tile_extent;
+        m_tileset.tile_size   = tile_size;
+        m_tileset.revision   += 1;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto TilemapRenderer::tilemap() noexcept -> Tilemap& {
+        return m_tilemap;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto TilemapRenderer::tilemap() const noexcept -> const Tilemap& {
+        return m_tilemap;
+    }
+} // namespace stormkit::engine::pipeline_2d
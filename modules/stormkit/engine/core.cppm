@@ -20,8 +20,13 @@ import std;
 
 import stormkit;
 
+import :ecs.schema_components;
+import :ecs.system_scheduler;
 import :lua_engine;
+import :lua_profiler;
 import :renderer;
+import :simulation_clock;
+import :vfs;
 
 namespace stdfs = std::filesystem;
 
@@ -36,6 +41,8 @@ export namespace stormkit::engine {
 
       public:
         static constexpr auto DEFAULT_WINDOW_TITLE = "StormKit-Engine";
+        /// mounted on the working directory if found, see AssetPack::build()
+        static constexpr auto DEFAULT_ASSET_PACK   = "assets.skpack";
 
         template<typename T>
         using Expected          = std::expected<T, ApplicationError>;
@@ -63,6 +70,13 @@ export namespace stormkit::engine {
         auto world(this auto& self) noexcept -> decltype(auto);
         auto window(this auto& self) noexcept -> decltype(auto);
         auto lua_engine(this auto& self) noexcept -> decltype(auto);
+        auto vfs(this auto& self) noexcept -> decltype(auto);
+        auto lua_profiler(this auto& self) noexcept -> decltype(auto);
+        auto schemas(this auto& self) noexcept -> decltype(auto);
+        /// native systems stepped in parallel, from their declared component access
+        auto systems(this auto& self) noexcept -> decltype(auto);
+        /// fixed timestep of the native systems, alpha() is the interpolation of the frame being built
+        auto simulation(this auto& self) noexcept -> decltype(auto);
 
         auto run() -> void;
 
@@ -75,13 +89,15 @@ export namespace stormkit::engine {
         auto do_init(std::string_view, stdfs::path&&, const math::uextent2&, std::string&&) noexcept -> Expected<void>;
 
         auto render_thread(std::atomic_bool&, std::stop_token) noexcept -> void;
-        auto lua_thread(std::atomic_bool&, std::stop_token) noexcept -> void;
+        /// the atomic counts the simulation ticks, the script systems step once per wake up with the time of the new ticks
+        auto lua_thread(std::atomic_bool&, std::atomic<u64>&, std::stop_token) noexcept -> void;
 
         LOGGER_FUNC(m_application_logger);
 
         log::Module m_application_logger;
 
-        ThreadPool m_thread_pool;
+        ThreadPool        m_thread_pool;
+        VirtualFileSystem m_vfs;
 
         std::jthread m_render_thread;
         std::jthread m_lua_thread;
@@ -90,6 +106,10 @@ export namespace stormkit::engine {
         DeferInit<Renderer>             m_renderer;
         Locked<entities::EntityManager> m_world;
         DeferInit<LuaEngine>            m_lua_engine;
+        LuaProfiler                     m_lua_profiler;
+        SchemaRegistry                  m_schemas;
+        SystemScheduler                 m_systems;
+        SimulationClock                 m_simulation;
 
         BuildFrameClosure m_build_frame = monadic::noop();
     };
@@ -170,6 +190,41 @@ namespace stormkit::engine {
         return std::forward_like<decltype(self)>(*self.m_window);
     }
 
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Application::vfs(this auto& self) noexcept -> decltype(auto) {
+        return std::forward_like<decltype(self)>(self.m_vfs);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Application::lua_profiler(this auto& self) noexcept -> decltype(auto) {
+        return std::forward_like<decltype(self)>(self.m_lua_profiler);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Application::schemas(this auto& self) noexcept -> decltype(auto) {
+        return std::forward_like<decltype(self)>(self.m_schemas);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Application::systems(this auto& self) noexcept -> decltype(auto) {
+        return std::forward_like<decltype(self)>(self.m_systems);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Application::simulation(this auto& self) noexcept -> decltype(auto) {
+        return std::forward_like<decltype(self)>(self.m_simulation);
+    }
+
     ////////////////////////////////////////
     ////////////////////////////////////////
     STORMKIT_FORCE_INLINE
@@ -56,6 +56,102 @@ export namespace stormkit::engine {
         T               m_value;
         DirtyMarkerType m_dirty;
     };
+
+    /// Value copied to one GPU region per frame in flight. Each write bump the version of the value and each frame slot
+    /// remember the last version it received, a slot is then uploaded only when it is behind. A slot never synced is dirty.
+    template<typename T>
+    class FrameDirtyable {
+        struct PrivateTag {};
+
+      public:
+        template<typename... Args>
+        FrameDirtyable(PrivateTag, Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>);
+
+        ~FrameDirtyable() noexcept;
+
+        FrameDirtyable(const FrameDirtyable&)                    = delete;
+        auto operator=(const FrameDirtyable&) -> FrameDirtyable& = delete;
+
+        FrameDirtyable(FrameDirtyable&&) noexcept(meta::IsNoexceptMoveConstructible<T>);
+        auto operator=(FrameDirtyable&&) noexcept(meta::IsNoexceptMoveAssignable<T>) -> FrameDirtyable&;
+
+        template<typename... Args>
+        static auto create(Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>) -> FrameDirtyable<T>;
+
+        auto mark_dirty() noexcept -> void;
+        auto mark_synced(usize slot) noexcept -> void;
+        auto dirty(usize slot) const noexcept -> bool;
+        auto version() const noexcept -> u64;
+
+        auto write() noexcept -> T&;
+        auto read() const noexcept -> const T&;
+
+      private:
+        T                m_value;
+        u64              m_version = 1;
+        // 0 for never synced
+        std::vector<u64> m_synced;
+    };
+
+    /// Half open range of container indices [first, first + count).
+    struct DirtyRange {
+        usize first;
+        usize count;
+
+        constexpr auto operator==(const DirtyRange&) const noexcept -> bool = default;
+    };
+
+    /// Container copied to one GPU region per frame in flight, each frame slot accumulate the index ranges changed since
+    /// it was last synced so only them are uploaded to it. write() without index mark the whole container, so does a
+    /// slot never synced. Past MAX_RANGES ranges a slot keep their bounds.
+    template<typename T>
+    class RangeDirtyable {
+        struct PrivateTag {};
+
+      public:
+        using ValueType = std::ranges::range_value_t<T>;
+
+        static constexpr auto MAX_RANGES = 16_usize;
+
+        template<typename... Args>
+        RangeDirtyable(PrivateTag, Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>);
+
+        ~RangeDirtyable() noexcept;
+
+        RangeDirtyable(const RangeDirtyable&)                    = delete;
+        auto operator=(const RangeDirtyable&) -> RangeDirtyable& = delete;
+
+        RangeDirtyable(RangeDirtyable&&) noexcept(meta::IsNoexceptMoveConstructible<T>);
+        auto operator=(RangeDirtyable&&) noexcept(meta::IsNoexceptMoveAssignable<T>) -> RangeDirtyable&;
+
+        template<typename... Args>
+        static auto create(Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>) -> RangeDirtyable<T>;
+
+        auto mark_dirty() noexcept -> void;
+        auto mark_dirty(DirtyRange range) noexcept -> void;
+        auto mark_synced(usize slot) noexcept -> void;
+        auto dirty(usize slot) const noexcept -> bool;
+
+        /// sorted and disjoint, clamped to the current size
+        auto changes(usize slot) const noexcept -> std::vector<DirtyRange>;
+        /// smallest range holding every change of slot
+        auto bounds(usize slot) const noexcept -> std::optional<DirtyRange>;
+
+        auto write() noexcept -> T&;
+        auto write(usize index) noexcept -> ValueType&;
+        auto read() const noexcept -> const T&;
+
+      private:
+        struct Slot {
+            bool                    full = true;
+            std::vector<DirtyRange> ranges;
+        };
+
+        auto clamp(DirtyRange range) const noexcept -> std::optional<DirtyRange>;
+
+        T                 m_value;
+        std::vector<Slot> m_slots;
+    };
 } // namespace stormkit::engine
 
 /////////////////////////////////////////////////////////////////////
@@ -132,7 +228,7 @@ namespace stormkit::engine {
         STORMKIT_FORCE_INLINE
     inline auto Dirtyable<T, THREAD_SAFE>::create_dirty(Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>)
       -> Dirtyable<T, THREAD_SAFE> {
-        return Dirtyable { std::forward<Args>(args)..., false, PrivateTag {} };
+        return Dirtyable { std::forward<Args>(args)..., true, PrivateTag {} };
     }
 
     //////////////////////////////////////
@@ -219,4 +315,263 @@ namespace stormkit::engine {
     inline Dirtyable<T, THREAD_SAFE>::operator bool() const noexcept {
         return dirty();
     }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    template<typename... Args>
+    STORMKIT_FORCE_INLINE
+    inline FrameDirtyable<T>::FrameDirtyable(PrivateTag, Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>)
+        : m_value { std::forward<Args>(args)... } {
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline FrameDirtyable<T>::~FrameDirtyable() noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline FrameDirtyable<T>::FrameDirtyable(FrameDirtyable&&) noexcept(meta::IsNoexceptMoveConstructible<T>) = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto FrameDirtyable<T>::operator=(FrameDirtyable&&) noexcept(meta::IsNoexceptMoveAssignable<T>)
+      -> FrameDirtyable& = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    template<typename... Args>
+    STORMKIT_FORCE_INLINE
+    inline auto FrameDirtyable<T>::create(Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>)
+      -> FrameDirtyable<T> {
+        return FrameDirtyable { PrivateTag {}, std::forward<Args>(args)... };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto FrameDirtyable<T>::mark_dirty() noexcept -> void {
+        ++m_version;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto FrameDirtyable<T>::mark_synced(usize slot) noexcept -> void {
+        if (slot >= std::ranges::size(m_synced)) m_synced.resize(slot + 1, 0);
+        m_synced[slot] = m_version;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto FrameDirtyable<T>::dirty(usize slot) const noexcept -> bool {
+        return slot >= std::ranges::size(m_synced) or m_synced[slot] != m_version;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto FrameDirtyable<T>::version() const noexcept -> u64 {
+        return m_version;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto FrameDirtyable<T>::write() noexcept -> T& {
+        mark_dirty();
+        return m_value;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto FrameDirtyable<T>::read() const noexcept -> const T& {
+        return m_value;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    template<typename... Args>
+    STORMKIT_FORCE_INLINE
+    inline RangeDirtyable<T>::RangeDirtyable(PrivateTag, Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>)
+        : m_value { std::forward<Args>(args)... } {
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline RangeDirtyable<T>::~RangeDirtyable() noexcept = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline RangeDirtyable<T>::RangeDirtyable(RangeDirtyable&&) noexcept(meta::IsNoexceptMoveConstructible<T>) = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::operator=(RangeDirtyable&&) noexcept(meta::IsNoexceptMoveAssignable<T>)
+      -> RangeDirtyable& = default;
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    template<typename... Args>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::create(Args&&... args) noexcept(meta::IsNoexceptConstructible<T, Args...>)
+      -> RangeDirtyable<T> {
+        return RangeDirtyable { PrivateTag {}, std::forward<Args>(args)... };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::mark_dirty() noexcept -> void {
+        for (auto& slot : m_slots) {
+            slot.full = true;
+            slot.ranges.clear();
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::mark_dirty(DirtyRange range) noexcept -> void {
+        if (range.count == 0) return;
+
+        for (auto& slot : m_slots) {
+            if (slot.full) continue;
+
+            auto& ranges = slot.ranges;
+
+            // merge every range overlapping or touching the new one, they are contiguous in the sorted ranges
+            auto first = std::ranges::lower_bound(ranges, range.first, {}, [](const auto& r) static noexcept {
+                return r.first + r.count;
+            });
+            auto last  = first;
+            auto begin = range.first;
+            auto end   = range.first + range.count;
+            for (; last != std::ranges::end(ranges) and last->first <= end; ++last) {
+                begin = std::min(begin, last->first);
+                end   = std::max(end, last->first + last->count);
+            }
+            first = ranges.erase(first, last);
+            ranges.insert(first, DirtyRange { .first = begin, .count = end - begin });
+
+            if (std::ranges::size(ranges) > MAX_RANGES) {
+                const auto bounds_end = ranges.back().first + ranges.back().count;
+                ranges.erase(std::ranges::begin(ranges) + 1, std::ranges::end(ranges));
+                ranges.front().count = bounds_end - ranges.front().first;
+            }
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::mark_synced(usize slot) noexcept -> void {
+        if (slot >= std::ranges::size(m_slots)) m_slots.resize(slot + 1);
+
+        m_slots[slot].full = false;
+        m_slots[slot].ranges.clear();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::dirty(usize slot) const noexcept -> bool {
+        return bounds(slot).has_value();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::changes(usize slot) const noexcept -> std::vector<DirtyRange> {
+        auto out = std::vector<DirtyRange> {};
+        if (slot >= std::ranges::size(m_slots) or m_slots[slot].full) {
+            if (const auto range = clamp({ .first = 0, .count = std::ranges::size(m_value) }); range) out.emplace_back(*range);
+            return out;
+        }
+
+        for (const auto& range : m_slots[slot].ranges)
+            if (const auto clamped = clamp(range); clamped) out.emplace_back(*clamped);
+
+        return out;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::bounds(usize slot) const noexcept -> std::optional<DirtyRange> {
+        if (slot >= std::ranges::size(m_slots) or m_slots[slot].full)
+            return clamp({ .first = 0, .count = std::ranges::size(m_value) });
+
+        const auto& ranges = m_slots[slot].ranges;
+        if (std::ranges::empty(ranges)) return std::nullopt;
+
+        const auto first = ranges.front().first;
+        return clamp({ .first = first, .count = ranges.back().first + ranges.back().count - first });
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::write() noexcept -> T& {
+        mark_dirty();
+        return m_value;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::write(usize index) noexcept -> ValueType& {
+        mark_dirty({ .first = index, .count = 1 });
+        return m_value[index];
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::read() const noexcept -> const T& {
+        return m_value;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto RangeDirtyable<T>::clamp(DirtyRange range) const noexcept -> std::optional<DirtyRange> {
+        const auto size = std::ranges::size(m_value);
+        if (range.first >= size) return std::nullopt;
+
+        return DirtyRange { .first = range.first, .count = std::min(range.count, size - range.first) };
+    }
 } // namespace stormkit::engine
@@ -5,4 +5,8 @@
 export module stormkit.engine:ecs;
 
 export import :ecs.common_components;
+export import :ecs.entity_commands;
+export import :ecs.entity_sparse_set;
+export import :ecs.schema_components;
 export import :ecs.sprite_render_system;
+export import :ecs.system_scheduler;
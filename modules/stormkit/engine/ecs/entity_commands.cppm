@@ -0,0 +1,163 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:ecs.entity_commands;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    /// Entity made by an EntityCommands, it exists once the commands are applied. It is only valid for the commands which
+    /// made it and until they are applied or cleared, see EntityCommands::owns().
+    struct PendingEntity {
+        u32 index;
+        u32 commands;
+        u32 generation;
+    };
+
+    /// Structural changes recorded without touching the entity manager, then applied together under a single world lock.
+    /// The entities are made first, then the components are added and the entities destroyed, each in recording order.
+    /// The added and removed entities then reach the systems in the messages of the next step, as one batch.
+    class STORMKIT_ENGINE_API EntityCommands {
+      public:
+        using Target     = std::variant<entities::Entity, PendingEntity>;
+        using AddClosure = std::function<void(entities::EntityManager&, entities::Entity)>;
+
+        EntityCommands() noexcept;
+        ~EntityCommands() noexcept;
+
+        EntityCommands(const EntityCommands&)                    = delete;
+        auto operator=(const EntityCommands&) -> EntityCommands& = delete;
+
+        EntityCommands(EntityCommands&&) noexcept;
+        auto operator=(EntityCommands&&) noexcept -> EntityCommands&;
+
+        auto make_entity() noexcept -> PendingEntity;
+        auto destroy_entity(entities::Entity e) noexcept -> void;
+
+        template<entities::meta::IsComponentType T>
+        auto add_component(Target target, T component) noexcept -> void;
+        auto add_component(Target target, AddClosure add) noexcept -> void;
+
+        /// return the made entities, indexed by PendingEntity::index, and leave the commands empty
+        auto apply(entities::EntityManager& world) noexcept -> std::vector<entities::Entity>;
+        /// on_destroy is called before each entity is destroyed
+        auto apply(entities::EntityManager& world, FunctionRef<void(entities::Entity)> on_destroy) noexcept
+          -> std::vector<entities::Entity>;
+
+        auto clear() noexcept -> void;
+
+        /// pending was made by these commands since they were last applied or cleared
+        [[nodiscard]]
+        auto owns(PendingEntity pending) const noexcept -> bool;
+
+        [[nodiscard]]
+        auto size() const noexcept -> usize;
+        [[nodiscard]]
+        auto empty() const noexcept -> bool;
+
+      private:
+        struct Add {
+            Target     target;
+            AddClosure add;
+        };
+
+        // unique per EntityCommands, bumped each time the commands are applied or cleared
+        u32                           m_id         = 0;
+        u32                           m_generation = 0;
+        u32                           m_made       = 0;
+        std::vector<Add>              m_adds;
+        std::vector<entities::Entity> m_destroyed;
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline EntityCommands::~EntityCommands() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline EntityCommands::EntityCommands(EntityCommands&&) noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::operator=(EntityCommands&&) noexcept -> EntityCommands& = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::make_entity() noexcept -> PendingEntity {
+        return { .index = m_made++, .commands = m_id, .generation = m_generation };
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::destroy_entity(entities::Entity e) noexcept -> void {
+        m_destroyed.emplace_back(e);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<entities::meta::IsComponentType T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::add_component(Target target, T component) noexcept -> void {
+        add_component(target, [component = std::move(component)](auto& world, auto e) mutable noexcept {
+            world.add_component(e, std::move(component));
+        });
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::add_component(Target target, AddClosure add) noexcept -> void {
+        EXPECTS(not std::holds_alternative<PendingEntity>(target) or owns(std::get<PendingEntity>(target)));
+
+        m_adds.emplace_back(target, std::move(add));
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::apply(entities::EntityManager& world) noexcept -> std::vector<entities::Entity> {
+        return apply(world, [](auto) static noexcept {});
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::owns(PendingEntity pending) const noexcept -> bool {
+        return pending.commands == m_id and pending.generation == m_generation and pending.index < m_made;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::size() const noexcept -> usize {
+        return m_made + std::ranges::size(m_adds) + std::ranges::size(m_destroyed);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto EntityCommands::empty() const noexcept -> bool {
+        return size() == 0;
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,234 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/platform_macro.hpp>
+
+export module stormkit.engine:ecs.entity_sparse_set;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    /// Values packed in a dense array and indexed by entity, insertion, lookup and removal take constant time. A removed
+    /// value is replaced by the last one so the dense array never has holes, the indices of the other values stay stable.
+    /// The sparse side is allocated by pages, its size follow the highest entity inserted.
+    template<typename T>
+    class EntitySparseSet {
+      public:
+        static constexpr auto PAGE_SIZE = 1024_usize;
+        static constexpr auto NO_INDEX  = std::numeric_limits<u32>::max();
+
+        /// moved is the former index of the value now at index, equal to index when the last value was removed
+        struct Removed {
+            u32 index;
+            u32 moved;
+        };
+
+        EntitySparseSet() noexcept;
+        ~EntitySparseSet() noexcept;
+
+        EntitySparseSet(const EntitySparseSet&)                    = delete;
+        auto operator=(const EntitySparseSet&) -> EntitySparseSet& = delete;
+
+        EntitySparseSet(EntitySparseSet&&) noexcept;
+        auto operator=(EntitySparseSet&&) noexcept -> EntitySparseSet&;
+
+        /// index of the value, an already present entity keep its index and get the new value
+        auto insert(entities::Entity e, T value) noexcept -> u32;
+        auto remove(entities::Entity e) noexcept -> std::optional<Removed>;
+        auto clear() noexcept -> void;
+
+        [[nodiscard]]
+        auto index_of(entities::Entity e) const noexcept -> std::optional<u32>;
+        [[nodiscard]]
+        auto contains(entities::Entity e) const noexcept -> bool;
+
+        [[nodiscard]]
+        auto values(this auto& self) noexcept -> decltype(auto);
+        [[nodiscard]]
+        auto entities() const noexcept -> std::span<const entities::Entity>;
+        [[nodiscard]]
+        auto size() const noexcept -> usize;
+        [[nodiscard]]
+        auto empty() const noexcept -> bool;
+
+        [[nodiscard]]
+        auto operator[](this auto& self, usize index) noexcept -> decltype(auto);
+
+      private:
+        using Page = std::array<u32, PAGE_SIZE>;
+
+        /// nullptr when the page of e isn't allocated
+        auto slot(entities::Entity e) const noexcept -> u32*;
+
+        std::vector<Heap<Page>>       m_pages;
+        std::vector<entities::Entity> m_entities;
+        std::vector<T>                m_values;
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline EntitySparseSet<T>::EntitySparseSet() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline EntitySparseSet<T>::~EntitySparseSet() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline EntitySparseSet<T>::EntitySparseSet(EntitySparseSet&&) noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::operator=(EntitySparseSet&&) noexcept -> EntitySparseSet& = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::insert(entities::Entity e, T value) noexcept -> u32 {
+        if (const auto index = index_of(e); index) {
+            m_values[*index] = std::move(value);
+            return *index;
+        }
+
+        const auto page = as<usize>(e) / PAGE_SIZE;
+        if (page >= std::ranges::size(m_pages)) m_pages.resize(page + 1);
+        if (m_pages[page] == nullptr) {
+            m_pages[page] = allocate_unsafe<Page>();
+            m_pages[page]->fill(NO_INDEX);
+        }
+
+        const auto index = as<u32>(std::ranges::size(m_values));
+        (*m_pages[page])[as<usize>(e) % PAGE_SIZE] = index;
+        m_entities.emplace_back(e);
+        m_values.emplace_back(std::move(value));
+
+        return index;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::remove(entities::Entity e) noexcept -> std::optional<Removed> {
+        const auto index = index_of(e);
+        if (not index) return std::nullopt;
+
+        const auto last = as<u32>(std::ranges::size(m_values) - 1);
+        if (*index != last) {
+            const auto moved   = m_entities[last];
+            m_values[*index]   = std::move(m_values[last]);
+            m_entities[*index] = moved;
+            *slot(moved)       = *index;
+        }
+        *slot(e) = NO_INDEX;
+
+        m_values.pop_back();
+        m_entities.pop_back();
+
+        return Removed { .index = *index, .moved = last };
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::clear() noexcept -> void {
+        for (const auto e : m_entities) *slot(e) = NO_INDEX;
+
+        m_entities.clear();
+        m_values.clear();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::index_of(entities::Entity e) const noexcept -> std::optional<u32> {
+        const auto* index = slot(e);
+        if (index == nullptr or *index == NO_INDEX) return std::nullopt;
+
+        return *index;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::contains(entities::Entity e) const noexcept -> bool {
+        return index_of(e).has_value();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::values(this auto& self) noexcept -> decltype(auto) {
+        return std::span { self.m_values };
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::entities() const noexcept -> std::span<const entities::Entity> {
+        return m_entities;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::size() const noexcept -> usize {
+        return std::ranges::size(m_values);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::empty() const noexcept -> bool {
+        return std::ranges::empty(m_values);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::operator[](this auto& self, usize index) noexcept -> decltype(auto) {
+        EXPECTS(index < self.size());
+
+        return std::forward_like<decltype(self)>(self.m_values[index]);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto EntitySparseSet<T>::slot(entities::Entity e) const noexcept -> u32* {
+        const auto page = as<usize>(e) / PAGE_SIZE;
+        if (page >= std::ranges::size(m_pages) or m_pages[page] == nullptr) return nullptr;
+
+        return &(*m_pages[page])[as<usize>(e) % PAGE_SIZE];
+    }
+} // namespace stormkit::engine
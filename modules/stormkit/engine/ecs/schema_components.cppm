@@ -0,0 +1,298 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:ecs.schema_components;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    enum class FieldType : u8 {
+        F32,
+        F64,
+        I32,
+        U32,
+        BOOL,
+        VEC2,
+        VEC3,
+        VEC4,
+        ENTITY,
+    };
+
+    [[nodiscard]]
+    constexpr auto field_type_from_string(std::string_view name) noexcept -> std::optional<FieldType>;
+    [[nodiscard]]
+    constexpr auto size_of(FieldType type) noexcept -> usize;
+    [[nodiscard]]
+    constexpr auto alignment_of(FieldType type) noexcept -> usize;
+
+    /// Marker added to the entity manager, so the queries and has_component() see the schema components, their data
+    /// live in the ComponentSchema rows
+    struct SchemaComponent {
+        entities::ComponentType _type;
+
+        constexpr auto component_name() const noexcept -> std::string_view { return "SchemaComponent"; }
+
+        constexpr auto type() const noexcept -> entities::ComponentType { return _type; }
+    };
+
+    struct SchemaField {
+        std::string name;
+        FieldType   type;
+        u32         offset;
+    };
+
+    /// Component declared by a script, stored natively: one row per entity, rows packed back to back with a fixed
+    /// stride and fields at fixed offsets, removed rows are filled by the last one
+    class STORMKIT_ENGINE_API ComponentSchema {
+      public:
+        ComponentSchema(std::string name, std::span<const std::pair<std::string, FieldType>> fields) noexcept;
+        ~ComponentSchema() noexcept;
+
+        ComponentSchema(const ComponentSchema&)                    = delete;
+        auto operator=(const ComponentSchema&) -> ComponentSchema& = delete;
+
+        ComponentSchema(ComponentSchema&&) noexcept;
+        auto operator=(ComponentSchema&&) noexcept -> ComponentSchema&;
+
+        /// zeroed row, the existing one if the entity already has the component
+        auto add(entities::Entity entity) noexcept -> u32;
+        auto remove(entities::Entity entity) noexcept -> bool;
+        auto clear() noexcept -> void;
+
+        [[nodiscard]]
+        auto row_of(entities::Entity entity) const noexcept -> std::optional<u32>;
+        [[nodiscard]]
+        auto field(std::string_view name) const noexcept -> const SchemaField*;
+
+        template<typename T>
+        [[nodiscard]]
+        auto get(this auto& self, u32 row, const SchemaField& field) noexcept -> decltype(auto);
+
+        [[nodiscard]]
+        auto name() const noexcept -> const std::string&;
+        [[nodiscard]]
+        auto type() const noexcept -> entities::ComponentType;
+        [[nodiscard]]
+        auto fields() const noexcept -> std::span<const SchemaField>;
+        [[nodiscard]]
+        auto stride() const noexcept -> usize;
+        [[nodiscard]]
+        auto size() const noexcept -> usize;
+        /// entity of each row
+        [[nodiscard]]
+        auto entities() const noexcept -> std::span<const entities::Entity>;
+        [[nodiscard]]
+        auto data(this auto& self) noexcept -> decltype(auto);
+
+      private:
+        std::string              m_name;
+        entities::ComponentType  m_type;
+        std::vector<SchemaField> m_fields;
+        usize                    m_stride = 0;
+
+        std::vector<Byte>              m_data;
+        std::vector<entities::Entity>  m_entities;
+        HashMap<entities::Entity, u32> m_rows;
+    };
+
+    /// Schemas of the components declared by the scripts, guarded by the world lock like the entity manager
+    class STORMKIT_ENGINE_API SchemaRegistry {
+      public:
+        /// a schema declared again with other fields replace the previous one, at the same address. Its rows are migrated,
+        /// the fields kept with the same name and type keep their value and the others are zeroed
+        auto define(std::string name, std::span<const std::pair<std::string, FieldType>> fields) noexcept -> ComponentSchema&;
+
+        [[nodiscard]]
+        auto find(this auto& self, std::string_view name) noexcept -> decltype(auto);
+        /// drop the rows of a destroyed entity, native code destroying entities with schema components must call it
+        auto remove(entities::Entity entity) noexcept -> void;
+        auto clear_rows() noexcept -> void;
+        auto clear() noexcept -> void;
+
+      private:
+        std::vector<Heap<ComponentSchema>> m_schemas;
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    constexpr auto field_type_from_string(std::string_view name) noexcept -> std::optional<FieldType> {
+        if (name == "f32") return FieldType::F32;
+        if (name == "f64") return FieldType::F64;
+        if (name == "i32") return FieldType::I32;
+        if (name == "u32") return FieldType::U32;
+        if (name == "bool") return FieldType::BOOL;
+        if (name == "vec2") return FieldType::VEC2;
+        if (name == "vec3") return FieldType::VEC3;
+        if (name == "vec4") return FieldType::VEC4;
+        if (name == "entity") return FieldType::ENTITY;
+
+        return std::nullopt;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    constexpr auto size_of(FieldType type) noexcept -> usize {
+        switch (type) {
+            case FieldType::F32: return sizeof(f32);
+            case FieldType::F64: return sizeof(f64);
+            case FieldType::I32: return sizeof(i32);
+            case FieldType::U32: return sizeof(u32);
+            case FieldType::BOOL: return sizeof(bool);
+            case FieldType::VEC2: return sizeof(math::fvec2);
+            case FieldType::VEC3: return sizeof(math::fvec3);
+            case FieldType::VEC4: return sizeof(math::fvec4);
+            case FieldType::ENTITY: return sizeof(entities::Entity);
+        }
+        std::unreachable();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    constexpr auto alignment_of(FieldType type) noexcept -> usize {
+        switch (type) {
+            case FieldType::F32: return alignof(f32);
+            case FieldType::F64: return alignof(f64);
+            case FieldType::I32: return alignof(i32);
+            case FieldType::U32: return alignof(u32);
+            case FieldType::BOOL: return alignof(bool);
+            case FieldType::VEC2: return alignof(math::fvec2);
+            case FieldType::VEC3: return alignof(math::fvec3);
+            case FieldType::VEC4: return alignof(math::fvec4);
+            case FieldType::ENTITY: return alignof(entities::Entity);
+        }
+        std::unreachable();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline ComponentSchema::~ComponentSchema() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline ComponentSchema::ComponentSchema(ComponentSchema&&) noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::operator=(ComponentSchema&&) noexcept -> ComponentSchema& = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::get(this auto& self, u32 row, const SchemaField& field) noexcept -> decltype(auto) {
+        EXPECTS(sizeof(T) == size_of(field.type));
+        EXPECTS(row < self.size());
+
+        using Pointer = std::conditional_t<std::is_const_v<std::remove_reference_t<decltype(self)>>, const T*, T*>;
+        // rows and offsets are aligned for the field types, the storage of operator new for all of them
+        return *std::bit_cast<Pointer>(std::ranges::data(self.m_data) + row * self.m_stride + field.offset);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::name() const noexcept -> const std::string& {
+        return m_name;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::type() const noexcept -> entities::ComponentType {
+        return m_type;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::fields() const noexcept -> std::span<const SchemaField> {
+        return m_fields;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::stride() const noexcept -> usize {
+        return m_stride;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::size() const noexcept -> usize {
+        return std::ranges::size(m_entities);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::entities() const noexcept -> std::span<const entities::Entity> {
+        return m_entities;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::data(this auto& self) noexcept -> decltype(auto) {
+        return std::span { self.m_data };
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::row_of(entities::Entity entity) const noexcept -> std::optional<u32> {
+        const auto it = m_rows.find(entity);
+        if (it == std::ranges::cend(m_rows)) return std::nullopt;
+
+        return it->second;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ComponentSchema::field(std::string_view name) const noexcept -> const SchemaField* {
+        // a handful of fields, a linear search beat hashing
+        const auto it = std::ranges::find(m_fields, name, &SchemaField::name);
+        if (it == std::ranges::cend(m_fields)) return nullptr;
+
+        return &*it;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SchemaRegistry::find(this auto& self, std::string_view name) noexcept -> decltype(auto) {
+        using Pointer = std::conditional_t<std::is_const_v<std::remove_reference_t<decltype(self)>>,
+                                           const ComponentSchema*,
+                                           ComponentSchema*>;
+
+        const auto it = std::ranges::find_if(self.m_schemas, [&name](const auto& schema) noexcept {
+            return schema->name() == name;
+        });
+        if (it == std::ranges::cend(self.m_schemas)) return Pointer { nullptr };
+
+        return Pointer { &**it };
+    }
+} // namespace stormkit::engine
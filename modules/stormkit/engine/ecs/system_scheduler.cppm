@@ -0,0 +1,123 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:ecs.system_scheduler;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    /// Native systems declaring the components they read and write. A system waits for the systems registered before it
+    /// which conflict with it, the others run with it in the same wave, on the thread pool. The systems of a wave share
+    /// the entity manager: they only touch their declared components and never add or remove entities or components.
+    /// The extract systems run together once every update system is done, they copy what the renderer need and write
+    /// no component. They only run on the last tick of a frame, their delta is the time stepped since their last run.
+    class STORMKIT_ENGINE_API SystemScheduler {
+      public:
+        enum class Phase : u8 {
+            UPDATE,
+            EXTRACT,
+        };
+
+        /// components accessed besides the ones of the matched entities, which are read at least
+        struct Access {
+            std::vector<entities::ComponentType> reads;
+            std::vector<entities::ComponentType> writes;
+        };
+
+        /// entities having every component of the system types
+        using Update = std::function<void(entities::EntityManager&, fsecond, std::span<const entities::Entity>)>;
+
+        SystemScheduler() noexcept;
+        ~SystemScheduler() noexcept;
+
+        SystemScheduler(const SystemScheduler&)                    = delete;
+        auto operator=(const SystemScheduler&) -> SystemScheduler& = delete;
+
+        SystemScheduler(SystemScheduler&&) noexcept;
+        auto operator=(SystemScheduler&&) noexcept -> SystemScheduler&;
+
+        /// replaced if already registered
+        auto add_system(std::string                          name,
+                        std::vector<entities::ComponentType> types,
+                        Access                               access,
+                        Update                               update,
+                        Phase                                phase = Phase::UPDATE) noexcept -> void;
+        auto remove_system(std::string_view name) noexcept -> void;
+
+        /// run every update system, and the extract systems if extract is true, world must be locked for writing for the
+        /// whole step
+        auto step(entities::EntityManager& world, fsecond delta, ThreadPool& thread_pool, bool extract = true) noexcept
+          -> void;
+
+        [[nodiscard]]
+        auto system_count() const noexcept -> usize;
+        [[nodiscard]]
+        auto wave_count() const noexcept -> usize;
+
+      private:
+        struct System {
+            std::string                          name;
+            std::vector<entities::ComponentType> types;
+            Access                               access;
+            Update                               update;
+            Phase                                phase;
+        };
+
+        auto build_waves() noexcept -> void;
+
+        std::vector<System>             m_systems;
+        // indices in m_systems, in registration order, the systems of a wave don't conflict with each other
+        std::vector<std::vector<usize>> m_waves;
+        // time stepped since the extract systems last ran
+        fsecond                         m_extract_delta = {};
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SystemScheduler::SystemScheduler() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SystemScheduler::~SystemScheduler() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SystemScheduler::SystemScheduler(SystemScheduler&&) noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SystemScheduler::operator=(SystemScheduler&&) noexcept -> SystemScheduler& = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SystemScheduler::system_count() const noexcept -> usize {
+        return std::ranges::size(m_systems);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SystemScheduler::wave_count() const noexcept -> usize {
+        return std::ranges::size(m_waves);
+    }
+} // namespace stormkit::engine
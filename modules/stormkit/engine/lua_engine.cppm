@@ -19,16 +19,26 @@ import std;
 
 import stormkit;
 
+import :vfs;
+import :lua_heap;
+import :script_scheduler;
+
 namespace stdfs = std::filesystem;
 
 export namespace stormkit::engine {
+    inline constexpr auto BYTECODE_CACHE_DIRECTORY = std::string_view { "./cache/lua" };
+
+    /// Scripts, boot.lua and the modules loaded with require(), are read through the vfs and compiled once,
+    /// their bytecode is cached on disk keyed by the hash of the source and of the compiler
     class STORMKIT_ENGINE_API LuaEngine {
         struct PrivateTag {};
 
       public:
         using BindToLuaClosure = std::function<void(sol::state&)>;
 
-        constexpr LuaEngine(stdfs::path&&, PrivateTag) noexcept;
+        static constexpr auto BYTECODE_EXTENSION = std::string_view { ".luauc" };
+
+        constexpr LuaEngine(stdfs::path&&, const VirtualFileSystem&, PrivateTag) noexcept;
         ~LuaEngine();
 
         LuaEngine(const LuaEngine&)                    = delete;
@@ -37,17 +47,52 @@ export namespace stormkit::engine {
         LuaEngine(LuaEngine&&) noexcept;
         auto operator=(LuaEngine&&) noexcept -> LuaEngine&;
 
-        static auto create(stdfs::path lua_dir) noexcept -> LuaEngine;
-        static auto allocate(stdfs::path lua_dir) noexcept -> Heap<LuaEngine>;
+        static auto create(stdfs::path lua_dir, const VirtualFileSystem& vfs) noexcept -> LuaEngine;
+        static auto allocate(stdfs::path lua_dir, const VirtualFileSystem& vfs) noexcept -> Heap<LuaEngine>;
 
         auto boot() -> sol::state;
+        /// re-run the modules whose loose file changed since they were loaded, the world is kept and the systems they
+        /// add replace the previous ones. While they run stormkit.reloading is true, return the count of reloaded modules
+        auto reload_changed_modules(sol::state& global_state) noexcept -> usize;
+
+        /// compile a chunk with the engine compiler options, return the compilation error on failure
+        static auto compile(std::string_view source) noexcept -> std::expected<std::string, std::string>;
+
+        auto set_bytecode_cache(stdfs::path directory) noexcept -> void;
+        /// load the precompiled BYTECODE_EXTENSION files only, as packed by stormkit-pack --bytecode
+        auto set_bytecode_only(bool enabled) noexcept -> void;
+
+        /// coroutines of the current state, cleared on boot()
+        auto scheduler(this auto& self) noexcept -> decltype(auto);
+        /// allocator and collector of the current state
+        auto heap(this auto& self) noexcept -> decltype(auto);
 
         auto append_binder(BindToLuaClosure&& binder) noexcept -> void;
         auto prepend_binder(BindToLuaClosure&& binder) noexcept -> void;
 
       private:
+        struct Module {
+            stdfs::path           path;
+            // last write time of the loose file, default for the modules read from a pack
+            stdfs::file_time_type write_time;
+        };
+
+        auto bind_require(sol::state& global_state) noexcept -> void;
+        auto run_module(sol::state_view state, const stdfs::path& path) const -> std::expected<sol::object, std::string>;
+        auto load_chunk(sol::state_view state, const stdfs::path& path) const
+          -> std::expected<sol::protected_function, std::string>;
+        auto read_bytecode(const stdfs::path& path) const noexcept -> std::expected<FileData, std::string>;
+
         stdfs::path                   m_lua_dir;
+        Ref<const VirtualFileSystem>  m_vfs;
         std::vector<BindToLuaClosure> m_binders;
+
+        stdfs::path m_bytecode_cache;
+        bool        m_bytecode_only = false;
+
+        HashMap<std::string, Module> m_modules;
+        ScriptScheduler              m_scheduler;
+        LuaHeap                      m_heap;
     };
 } // namespace stormkit::engine
 
@@ -59,8 +104,8 @@ namespace stormkit::engine {
     ////////////////////////////////////////
     ////////////////////////////////////////
     STORMKIT_FORCE_INLINE
-    constexpr LuaEngine::LuaEngine(stdfs::path&& lua_dir, PrivateTag) noexcept
-        : m_lua_dir { std::move(lua_dir) } {};
+    constexpr LuaEngine::LuaEngine(stdfs::path&& lua_dir, const VirtualFileSystem& vfs, PrivateTag) noexcept
+        : m_lua_dir { std::move(lua_dir) }, m_vfs { as_ref(vfs) } {};
 
     ////////////////////////////////////////
     ////////////////////////////////////////
@@ -80,8 +125,8 @@ namespace stormkit::engine {
     ////////////////////////////////////////
     ////////////////////////////////////////
     STORMKIT_FORCE_INLINE
-    inline auto LuaEngine::create(stdfs::path lua_dir) noexcept -> LuaEngine {
-        auto app = LuaEngine { std::move(lua_dir), PrivateTag {} };
+    inline auto LuaEngine::create(stdfs::path lua_dir, const VirtualFileSystem& vfs) noexcept -> LuaEngine {
+        auto app = LuaEngine { std::move(lua_dir), vfs, PrivateTag {} };
         // Try(app.do_init());
         return app;
     }
@@ -89,27 +134,24 @@ namespace stormkit::engine {
     ////////////////////////////////////////
     ////////////////////////////////////////
     STORMKIT_FORCE_INLINE
-    inline auto LuaEngine::allocate(stdfs::path lua_dir) noexcept -> Heap<LuaEngine> {
-        auto app = allocate_unsafe<LuaEngine>(std::move(lua_dir), PrivateTag {});
+    inline auto LuaEngine::allocate(stdfs::path lua_dir, const VirtualFileSystem& vfs) noexcept -> Heap<LuaEngine> {
+        auto app = allocate_unsafe<LuaEngine>(std::move(lua_dir), vfs, PrivateTag {});
         // Try(app->do_init());
         return app;
     }
 
     ////////////////////////////////////////
     ////////////////////////////////////////
-    inline auto LuaEngine::boot() -> sol::state {
-        auto lua_engine = lua::Engine::load_from_file(m_lua_dir / "boot.lua",
-                                                      {
-                                                        .log      = true,
-                                                        .image    = true,
-                                                        .entities = true,
-                                                        .wsi      = true,
-                                                        .gpu      = true,
-                                                      },
-                                                      [this](auto& global_state) noexcept {
-                                                          for (auto&& binder : m_binders) binder(global_state);
-                                                      });
-        return lua_engine.run();
+    STORMKIT_FORCE_INLINE
+    inline auto LuaEngine::scheduler(this auto& self) noexcept -> decltype(auto) {
+        return std::forward_like<decltype(self)>(self.m_scheduler);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaEngine::heap(this auto& self) noexcept -> decltype(auto) {
+        return std::forward_like<decltype(self)>(self.m_heap);
     }
 
     ////////////////////////////////////////
@@ -125,4 +167,18 @@ namespace stormkit::engine {
     inline auto LuaEngine::prepend_binder(BindToLuaClosure&& binder) noexcept -> void {
         m_binders.emplace(std::begin(m_binders), std::move(binder));
     }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaEngine::set_bytecode_cache(stdfs::path directory) noexcept -> void {
+        m_bytecode_cache = std::move(directory);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaEngine::set_bytecode_only(bool enabled) noexcept -> void {
+        m_bytecode_only = enabled;
+    }
 } // namespace stormkit::engine
@@ -0,0 +1,151 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/lua/lua.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:lua_heap;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    /// Allocator of a lua state, the small blocks come from per size class pools which are only released with the heap,
+    /// the bigger ones from malloc. The automatic collector is replaced by steps bounded by a per frame budget.
+    /// Used on the lua thread only, stats() return the snapshot published by the last step().
+    class STORMKIT_ENGINE_API LuaHeap {
+      public:
+        using Clock = std::chrono::steady_clock;
+
+        // powers of two from MIN_BLOCK_SIZE to MAX_BLOCK_SIZE
+        static constexpr auto MIN_BLOCK_SIZE    = 16_usize;
+        static constexpr auto MAX_BLOCK_SIZE    = 512_usize;
+        static constexpr auto SIZE_CLASS_COUNT  = 6_usize;
+        static constexpr auto CHUNK_SIZE        = 64_usize * 1024_usize;
+        static constexpr auto DEFAULT_GC_BUDGET = std::chrono::microseconds { 1000 };
+        static constexpr auto DEFAULT_GC_STEP   = 32;
+        // a full collection is forced past it, the budget was then too small for the allocation rate
+        static constexpr auto DEFAULT_GC_LIMIT  = 1024_usize * 1024_usize * 1024_usize;
+
+        struct Stats {
+            usize                     live_bytes   = 0;
+            usize                     peak_bytes   = 0;
+            // reserved by the pools, used or not
+            usize                     pooled_bytes = 0;
+            u64                       allocations  = 0;
+            u64                       collections  = 0;
+            u64                       forced       = 0;
+            std::chrono::microseconds last_pause   = {};
+            std::chrono::microseconds max_pause    = {};
+        };
+
+        LuaHeap() noexcept;
+        ~LuaHeap() noexcept;
+
+        LuaHeap(const LuaHeap&)                    = delete;
+        auto operator=(const LuaHeap&) -> LuaHeap& = delete;
+
+        LuaHeap(LuaHeap&&) noexcept;
+        auto operator=(LuaHeap&&) noexcept -> LuaHeap&;
+
+        /// lua_Alloc, user_data is the heap
+        static auto allocate(void* user_data, void* pointer, std::size_t old_size, std::size_t new_size) noexcept -> void*;
+
+        /// stop the automatic collector of state, its garbage is then collected by step()
+        auto attach(lua_State* state) noexcept -> void;
+        /// free every pool, the state allocated from the heap must be closed
+        auto reset() noexcept -> void;
+
+        /// collect incrementally for at most the gc budget
+        auto step(lua_State* state) noexcept -> void;
+
+        auto set_gc_budget(std::chrono::microseconds budget) noexcept -> void;
+        auto set_gc_limit(usize bytes) noexcept -> void;
+        [[nodiscard]]
+        auto gc_budget() const noexcept -> std::chrono::microseconds;
+
+        [[nodiscard]]
+        auto stats() const noexcept -> Stats;
+
+        /// stormkit.memory: stats() and set_gc_budget(microseconds)
+        auto bind(sol::state& global_state) noexcept -> void;
+
+      private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        auto allocate_block(usize size) noexcept -> void*;
+        auto free_block(void* pointer, usize size) noexcept -> void;
+        auto refill(usize size_class) noexcept -> bool;
+
+        std::array<FreeBlock*, SIZE_CLASS_COUNT>  m_free_lists = {};
+        std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+        Stats                                     m_stats;
+        Locked<Stats>                             m_published;
+
+        std::chrono::microseconds m_gc_budget = DEFAULT_GC_BUDGET;
+        usize                     m_gc_limit  = DEFAULT_GC_LIMIT;
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline LuaHeap::LuaHeap() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline LuaHeap::~LuaHeap() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline LuaHeap::LuaHeap(LuaHeap&&) noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaHeap::operator=(LuaHeap&&) noexcept -> LuaHeap& = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaHeap::set_gc_budget(std::chrono::microseconds budget) noexcept -> void {
+        m_gc_budget = budget;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaHeap::set_gc_limit(usize bytes) noexcept -> void {
+        m_gc_limit = bytes;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaHeap::gc_budget() const noexcept -> std::chrono::microseconds {
+        return m_gc_budget;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaHeap::stats() const noexcept -> Stats {
+        return *m_published.read();
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,154 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/lua/lua.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:lua_profiler;
+
+import std;
+
+import stormkit;
+
+namespace stdfs = std::filesystem;
+
+export namespace stormkit::engine {
+    /// Time of the lua systems and callbacks, recorded by name on the lua thread, and optional sampling of the lua call
+    /// stacks from the Luau interrupt callback. The results can be read from any thread.
+    class STORMKIT_ENGINE_API LuaProfiler {
+      public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr auto DEFAULT_BUDGET        = Clock::duration { std::chrono::milliseconds { 4 } };
+        static constexpr auto DEFAULT_SAMPLE_PERIOD = Clock::duration { std::chrono::microseconds { 500 } };
+
+        struct Stats {
+            Clock::duration last    = {};
+            // exponential moving average over the last 16 calls
+            Clock::duration average = {};
+            Clock::duration max     = {};
+            u64             calls   = 0;
+        };
+
+        LuaProfiler() noexcept;
+        ~LuaProfiler() noexcept;
+
+        LuaProfiler(const LuaProfiler&)                    = delete;
+        auto operator=(const LuaProfiler&) -> LuaProfiler& = delete;
+
+        LuaProfiler(LuaProfiler&&) noexcept;
+        auto operator=(LuaProfiler&&) noexcept -> LuaProfiler&;
+
+        auto record(std::string_view name, Clock::duration duration) noexcept -> void;
+        /// close a frame of the lua thread, a warning names the slowest entry when duration is over the budget
+        auto end_frame(Clock::duration duration) noexcept -> void;
+
+        auto set_budget(Clock::duration budget) noexcept -> void;
+        [[nodiscard]]
+        auto budget() const noexcept -> Clock::duration;
+
+        /// sorted by decreasing average
+        [[nodiscard]]
+        auto stats() const noexcept -> std::vector<std::pair<std::string, Stats>>;
+        auto reset() noexcept -> void;
+
+        /// install the interrupt callback of state, stop_sampling() must be called before state is closed
+        auto start_sampling(lua_State* state, Clock::duration period = DEFAULT_SAMPLE_PERIOD) noexcept -> void;
+        auto stop_sampling(lua_State* state) noexcept -> void;
+        [[nodiscard]]
+        auto sampling() const noexcept -> bool;
+
+        /// one "outer;inner count" line per sampled stack, as read by flamegraph.pl, inferno or speedscope
+        [[nodiscard]]
+        auto folded_stacks() const noexcept -> std::string;
+        auto write_folded_stacks(const stdfs::path& path) const noexcept -> bool;
+
+      private:
+        static auto interrupt(lua_State* state, int gc) -> void;
+
+        auto sample(lua_State* state) noexcept -> void;
+
+        // transparent, record() look the labels up without building a std::string, one is only made for a new label
+        struct NameHash {
+            using is_transparent = void;
+
+            auto operator()(std::string_view name) const noexcept -> usize { return std::hash<std::string_view> {}(name); }
+        };
+
+        using StatsMap = std::unordered_map<std::string, Stats, NameHash, std::equal_to<>>;
+
+        struct Data {
+            StatsMap                    stats;
+            HashMap<std::string, u64>   stacks;
+            Clock::duration             budget = DEFAULT_BUDGET;
+
+            // slowest entry of the current frame
+            std::string     slowest;
+            Clock::duration slowest_duration = {};
+            u64             frames           = 0;
+            u64             over_budget      = 0;
+        };
+
+        Locked<Data> m_data;
+
+        // only used on the thread running the sampled state
+        Clock::duration   m_sample_period = DEFAULT_SAMPLE_PERIOD;
+        Clock::time_point m_next_sample   = {};
+        bool              m_sampling      = false;
+    };
+
+    STORMKIT_ENGINE_API auto bind_lua_profiler(sol::table& engine) noexcept -> void;
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline LuaProfiler::LuaProfiler() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline LuaProfiler::~LuaProfiler() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline LuaProfiler::LuaProfiler(LuaProfiler&&) noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaProfiler::operator=(LuaProfiler&&) noexcept -> LuaProfiler& = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaProfiler::set_budget(Clock::duration budget) noexcept -> void {
+        m_data.write()->budget = budget;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaProfiler::budget() const noexcept -> Clock::duration {
+        return m_data.read()->budget;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto LuaProfiler::sampling() const noexcept -> bool {
+        return m_sampling;
+    }
+} // namespace stormkit::engine
@@ -21,6 +21,10 @@ import stormkit.gpu;
 
 export import :renderer.framegraph;
 export import :renderer.render_surface;
+export import :renderer.render_queue;
+export import :renderer.texture_cache;
+
+import :vfs;
 
 namespace stdfs = std::filesystem;
 
@@ -29,6 +33,12 @@ export namespace stormkit::engine {
 
     inline constexpr auto INVALID_TEXTURE_ID = std::numeric_limits<TextureID>::max();
 
+    /// KTX2 files baked from the loaded images, relative to the working directory
+    inline constexpr auto TEXTURE_CACHE_DIRECTORY = std::string_view { "./cache/textures" };
+
+    /// gpu memory the resident textures may use before the unreferenced ones are evicted
+    inline constexpr auto DEFAULT_TEXTURE_BUDGET = usize { 256 } * 1024 * 1024;
+
     struct FrameResources {
         using Images     = std::vector<std::pair<engine::FrameBuilder::ResourceID, gpu::Image>>;
         using ImagesMap  = std::vector<std::pair<engine::FrameBuilder::ResourceID, Ref<gpu::Image>>>;
@@ -38,6 +48,8 @@ export namespace stormkit::engine {
 
         gpu::Semaphore semaphore;
         gpu::Fence     fence;
+        // index of the realized FrameBuilder, in build order
+        u64            index = 0;
 
         Images  created_images  = {};
         Buffers created_buffers = {};
@@ -82,6 +94,30 @@ export namespace stormkit::engine {
 
     class ResourceStore {
       public:
+        /// called with the id of the image and whether it could be loaded
+        using OnImageLoaded = std::function<void(TextureID, bool)>;
+
+        /// thread running the on_loaded callback of an async load
+        enum class CallbackThread : u8 {
+            /// from update() on the render thread, at the end of the frame update the image was swapped in
+            RENDER,
+            /// from run_deferred_callbacks() on the thread owning the callback, e.g. the Lua thread
+            DEFERRED,
+        };
+
+        struct AsyncImage {
+            TextureID                id;
+            std::shared_future<bool> loaded;
+        };
+
+        struct TextureStats {
+            usize resident_bytes;
+            usize budget;
+            usize resident_count;
+            u64   evictions;
+            u64   reloads;
+        };
+
         explicit ResourceStore(const Renderer& renderer) noexcept;
         ~ResourceStore() noexcept;
 
@@ -91,13 +127,128 @@ export namespace stormkit::engine {
         ResourceStore(ResourceStore&&) noexcept;
         auto operator=(ResourceStore&&) noexcept -> ResourceStore&;
 
+        [[nodiscard]]
+        static auto create(const Renderer& renderer) noexcept -> gpu::Expected<ResourceStore>;
+
         auto load_image(const stdfs::path& path) -> TextureID;
+        /// Decode the images in parallel on the thread pool and upload them all with a single submission, the ids
+        /// of the images which failed to load are INVALID_TEXTURE_ID.
+        auto load_images(std::span<const stdfs::path> paths) -> std::vector<TextureID>;
+        /// Return at once with an id bound to a transparent placeholder, the image is decoded on the thread pool
+        /// then uploaded without blocking and swapped in by update() once its fence is signaled.
+        auto load_image_async(const stdfs::path& path,
+                              OnImageLoaded      on_loaded       = {},
+                              CallbackThread     callback_thread = CallbackThread::RENDER) noexcept -> AsyncImage;
 
         auto get_image(TextureID id) const noexcept -> const gpu::Image&;
+        [[nodiscard]]
+        auto is_loaded(TextureID id) const noexcept -> bool;
+        /// bumped each time a loaded image replace its placeholder or an evicted one, so their views can be recreated
+        [[nodiscard]]
+        auto revision() const noexcept -> u32;
+
+        /// A referenced texture is never evicted, an evicted texture is reloaded by update() once referenced again
+        /// and is bound to the placeholder meanwhile. Sprites and tilesets take one reference each.
+        auto acquire(TextureID id) const noexcept -> void;
+        auto release(TextureID id) const noexcept -> void;
+
+        /// unreferenced textures are evicted by update(), least recently used first, while the budget is exceeded
+        auto set_texture_budget(usize bytes) noexcept -> void;
+        [[nodiscard]]
+        auto texture_stats() const noexcept -> TextureStats;
+
+        /// submit the decoded images and swap in the uploaded ones, called by the renderer each frame
+        auto update() noexcept -> void;
+
+        auto run_deferred_callbacks() noexcept -> void;
+        /// drop the deferred callbacks not run yet, before the state they capture is destroyed
+        auto drop_deferred_callbacks() noexcept -> void;
 
       private:
-        Ref<const Renderer>            m_renderer;
-        HashMap<TextureID, gpu::Image> m_textures;
+        auto do_init() noexcept -> gpu::Expected<void>;
+        auto finish(TextureID id, bool success, std::promise<bool>& promise) noexcept -> void;
+        auto store(TextureID id, const stdfs::path& path, usize size, Heap<gpu::Image>&& image) noexcept -> void;
+        /// loaded, being loaded or failed to load, but not evicted
+        auto is_requested(TextureID id) const noexcept -> bool;
+        auto evict() noexcept -> void;
+
+        struct Request {
+            TextureID                                 id;
+            stdfs::path                               path;
+            std::promise<bool>                        promise;
+            std::future<std::optional<CachedTexture>> decoded;
+        };
+
+        struct Upload {
+            TextureID          id;
+            std::promise<bool> promise;
+            usize              size;
+            Heap<gpu::Image>   image;
+            gpu::Buffer        staging_buffer;
+            gpu::CommandBuffer cmb;
+            gpu::Fence         fence;
+        };
+
+        struct Callback {
+            TextureID      id;
+            OnImageLoaded  on_loaded;
+            CallbackThread thread;
+        };
+
+        struct Completion {
+            TextureID     id;
+            OnImageLoaded on_loaded;
+            bool          success;
+        };
+
+        struct Texture {
+            // null while pending or once evicted and resolved to the placeholder, Heap keep references stable on insertion
+            Heap<gpu::Image> image      = nullptr;
+            // reloaded from it once evicted
+            stdfs::path      path       = {};
+            usize            size       = 0;
+            u32              references = 0;
+            // frame of the last acquire, release or upload, orders the eviction
+            u64              last_used  = 0;
+            bool             evicted    = false;
+        };
+
+        struct Textures {
+            HashMap<TextureID, Texture> entries;
+            u32                         revision = 0;
+            u64                         frame    = 0;
+
+            usize budget         = DEFAULT_TEXTURE_BUDGET;
+            usize resident_bytes = 0;
+            u64   evictions      = 0;
+            u64   reloads        = 0;
+        };
+
+        struct AsyncState {
+            std::vector<Request>                         requests;
+            std::vector<Callback>                        callbacks;
+            // completions waiting for their callback, run by update() or by run_deferred_callbacks()
+            std::vector<Completion>                      completed;
+            std::vector<Completion>                      deferred;
+            HashMap<TextureID, std::shared_future<bool>> futures;
+        };
+
+        auto request(TextureID id, const stdfs::path& path, AsyncState& async) noexcept -> std::shared_future<bool>;
+
+        Ref<const Renderer>      m_renderer;
+        TextureCache             m_texture_cache;
+        // reference counts are taken through const access, like a shared_ptr copy
+        mutable Locked<Textures> m_textures;
+        Locked<AsyncState>       m_async;
+
+        DeferInit<gpu::Image>       m_placeholder;
+        DeferInit<gpu::CommandPool> m_upload_command_pool;
+
+        // only touched by update(), on the render thread
+        std::vector<Request>                           m_decoding;
+        std::vector<Upload>                            m_uploading;
+        // evicted images, destroyed once the frames in flight which may sample them are done
+        std::vector<std::pair<Heap<gpu::Image>, u64>> m_evicted;
     };
 
     class STORMKIT_ENGINE_API Renderer final {
@@ -106,7 +257,7 @@ export namespace stormkit::engine {
       public:
         using BuildFrameClosure = FunctionRef<void(FrameBuilder&)>;
 
-        Renderer(ThreadPool& thread_pool, PrivateFuncTag) noexcept;
+        Renderer(ThreadPool& thread_pool, const VirtualFileSystem& vfs, PrivateFuncTag) noexcept;
         ~Renderer() noexcept;
 
         Renderer(const Renderer&)                    = delete;
@@ -118,10 +269,12 @@ export namespace stormkit::engine {
         [[nodiscard]]
         static auto create(std::string_view               application_name,
                            ThreadPool&                    thread_pool,
+                           const VirtualFileSystem&       vfs,
                            OptionalRef<const wsi::Window> window) noexcept -> gpu::Expected<Renderer>;
         [[nodiscard]]
         static auto allocate(std::string_view               application_name,
                              ThreadPool&                    thread_pool,
+                             const VirtualFileSystem&       vfs,
                              OptionalRef<const wsi::Window> window) noexcept -> gpu::Expected<Heap<Renderer>>;
 
         auto instance() const noexcept -> const gpu::Instance&;
@@ -129,15 +282,21 @@ export namespace stormkit::engine {
         auto surface() const noexcept -> const RenderSurface&;
         auto raster_queue() const noexcept -> const gpu::Queue&;
         auto main_command_pool() const noexcept -> const gpu::CommandPool&;
+        auto thread_pool() const noexcept -> ThreadPool&;
+        auto vfs() const noexcept -> const VirtualFileSystem&;
         template<typename Self>
         auto resources(this Self& self) noexcept -> meta::ForwardConst<Self, ResourceStore>&;
 
+        /// wait for the GPU to finish the frame built buffering_count() frames ago, its per frame data is reused
         auto build_frame(BuildFrameClosure build_frame) noexcept -> void;
 
+        /// index of the frame being built in [0, buffering_count()), each frame in flight use its own copy of per frame data
         auto current_frame() const noexcept -> u32;
         auto buffering_count() const noexcept -> u32;
 
         auto do_render() noexcept -> void;
+        /// once the render thread is stopped, build_frame() no longer wait for it
+        auto wait_idle() noexcept -> gpu::Expected<void>;
 
       private:
         auto do_init(std::string_view, OptionalRef<const wsi::Window>) noexcept -> gpu::Expected<void>;
@@ -148,11 +307,14 @@ export namespace stormkit::engine {
         auto do_render(RenderSurface::Frame&) noexcept -> gpu::Expected<void>;
 
         auto realize_frame(const FrameBuilder& frame_builder) noexcept -> FrameResources;
+        auto poll_completed_frames() noexcept -> void;
+        auto complete_frames(u64 count) noexcept -> void;
 
-        bool            m_validation_layers_enabled = false;
-        u32             m_current_frame             = 0;
-        math::uextent2  m_extent;
-        Ref<ThreadPool> m_thread_pool;
+        bool                         m_validation_layers_enabled = false;
+        u32                          m_current_frame             = 0;
+        math::uextent2               m_extent;
+        Ref<ThreadPool>              m_thread_pool;
+        Ref<const VirtualFileSystem> m_vfs;
 
         DeferInit<gpu::Instance> m_instance;
         Heap<gpu::Device>        m_device;
@@ -168,6 +330,12 @@ export namespace stormkit::engine {
 
         Locked<std::queue<FrameBuilder>>       m_frame_builders;
         std::vector<DeferInit<FrameResources>> m_frame_resources;
+
+        // frames built on the main thread and realized on the render thread, completed_frames count the frames whose
+        // fence signaled, frames finish in submission order on the raster queue
+        u64                    m_built_frames     = 0;
+        u64                    m_realized_frames  = 0;
+        Heap<std::atomic<u64>> m_completed_frames = core::allocate_unsafe<std::atomic<u64>>(0u);
     };
 
     inline constexpr auto RENDERER_LOGGER = log::Module { "Renderer" };
@@ -184,7 +352,7 @@ namespace stormkit::engine {
     /////////////////////////////////////
     STORMKIT_FORCE_INLINE
     inline ResourceStore::ResourceStore(const Renderer& renderer) noexcept
-        : m_renderer { as_ref(renderer) } {
+        : m_renderer { as_ref(renderer) }, m_texture_cache { TEXTURE_CACHE_DIRECTORY, renderer.vfs() } {
     }
 
     /////////////////////////////////////
@@ -202,13 +370,51 @@ namespace stormkit::engine {
     STORMKIT_FORCE_INLINE
     inline auto ResourceStore::operator=(ResourceStore&&) noexcept -> ResourceStore& = default;
 
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ResourceStore::create(const Renderer& renderer) noexcept -> gpu::Expected<ResourceStore> {
+        auto store = ResourceStore { renderer };
+        Try(store.do_init());
+        Return store;
+    }
+
     /////////////////////////////////////
     /////////////////////////////////////
     STORMKIT_FORCE_INLINE
     inline auto ResourceStore::get_image(TextureID id) const noexcept -> const gpu::Image& {
-        EXPECTS(m_textures.contains(id));
+        const auto textures = m_textures.read();
+
+        const auto it = textures->entries.find(id);
+        EXPECTS(it != std::ranges::cend(textures->entries));
+
+        if (it->second.image == nullptr) return *m_placeholder;
+
+        return *it->second.image;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ResourceStore::is_loaded(TextureID id) const noexcept -> bool {
+        const auto textures = m_textures.read();
+
+        const auto it = textures->entries.find(id);
+        return it != std::ranges::cend(textures->entries) and it->second.image != nullptr;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ResourceStore::revision() const noexcept -> u32 {
+        return m_textures.read()->revision;
+    }
 
-        return m_textures.at(id);
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ResourceStore::set_texture_budget(usize bytes) noexcept -> void {
+        m_textures.write()->budget = bytes;
     }
 
     /////////////////////////////////////
@@ -236,8 +442,8 @@ namespace stormkit::engine {
     /////////////////////////////////////
     /////////////////////////////////////
     STORMKIT_FORCE_INLINE
-    Renderer::Renderer(ThreadPool& thread_pool, PrivateFuncTag) noexcept
-        : m_thread_pool { as_ref_mut(thread_pool) } {
+    Renderer::Renderer(ThreadPool& thread_pool, const VirtualFileSystem& vfs, PrivateFuncTag) noexcept
+        : m_thread_pool { as_ref_mut(thread_pool) }, m_vfs { as_ref(vfs) } {
     }
 
     /////////////////////////////////////
@@ -262,8 +468,9 @@ namespace stormkit::engine {
     STORMKIT_FORCE_INLINE
     inline auto Renderer::create(std::string_view               application_name,
                                  ThreadPool&                    thread_pool,
+                                 const VirtualFileSystem&       vfs,
                                  OptionalRef<const wsi::Window> window) noexcept -> gpu::Expected<Renderer> {
-        auto renderer = Renderer { thread_pool, PrivateFuncTag {} };
+        auto renderer = Renderer { thread_pool, vfs, PrivateFuncTag {} };
         Try(renderer.do_init(application_name, std::move(window)));
         Return renderer;
     }
@@ -273,8 +480,9 @@ namespace stormkit::engine {
     STORMKIT_FORCE_INLINE
     inline auto Renderer::allocate(std::string_view               application_name,
                                    ThreadPool&                    thread_pool,
+                                   const VirtualFileSystem&       vfs,
                                    OptionalRef<const wsi::Window> window) noexcept -> gpu::Expected<Heap<Renderer>> {
-        auto renderer = core::allocate_unsafe<Renderer>(thread_pool, PrivateFuncTag {});
+        auto renderer = core::allocate_unsafe<Renderer>(thread_pool, vfs, PrivateFuncTag {});
         Try(renderer->do_init(application_name, std::move(window)));
         Return renderer;
     }
@@ -319,6 +527,20 @@ namespace stormkit::engine {
         return m_main_command_pool.get();
     }
 
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Renderer::thread_pool() const noexcept -> ThreadPool& {
+        return *m_thread_pool;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto Renderer::vfs() const noexcept -> const VirtualFileSystem& {
+        return *m_vfs;
+    }
+
     /////////////////////////////////////
     /////////////////////////////////////
     template<typename Self>
@@ -332,11 +554,21 @@ namespace stormkit::engine {
     /////////////////////////////////////
     STORMKIT_FORCE_INLINE
     inline auto Renderer::build_frame(BuildFrameClosure build_frame) noexcept -> void {
+        // the per frame slots, and what is retired after buffering_count() frames, are only reused once the GPU is done
+        auto completed = m_completed_frames->load();
+        while (m_built_frames >= completed + buffering_count()) {
+            m_completed_frames->wait(completed);
+            completed = m_completed_frames->load();
+        }
+
         auto frame_builder = FrameBuilder {};
         std::invoke(build_frame, frame_builder);
 
         auto frame_builders = m_frame_builders.write();
         frame_builders->push(std::move(frame_builder));
+
+        m_current_frame  = (m_current_frame + 1) % buffering_count();
+        m_built_frames  += 1;
     }
 
     /////////////////////////////////////
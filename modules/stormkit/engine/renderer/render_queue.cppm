@@ -0,0 +1,207 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:renderer.render_queue;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    /// 64 bits draw sort key, most significant bits first:
+    /// - opaque:      layer (8) | 0 (1) | pipeline (8) | texture (16) | depth front to back (24) | unused (7)
+    /// - translucent: layer (8) | 1 (1) | depth back to front (24) | pipeline (8) | texture (16) | unused (7)
+    struct SortKey {
+        static constexpr auto LAYER_SHIFT       = 56u;
+        static constexpr auto TRANSLUCENT_SHIFT = 55u;
+
+        [[nodiscard]]
+        static constexpr auto opaque(u8 layer, u8 pipeline, u16 texture, f32 depth) noexcept -> u64;
+        [[nodiscard]]
+        static constexpr auto translucent(u8 layer, u8 pipeline, u16 texture, f32 depth) noexcept -> u64;
+
+        [[nodiscard]]
+        static constexpr auto layer(u64 key) noexcept -> u8;
+        [[nodiscard]]
+        static constexpr auto is_translucent(u64 key) noexcept -> bool;
+        [[nodiscard]]
+        static constexpr auto pipeline(u64 key) noexcept -> u8;
+        [[nodiscard]]
+        static constexpr auto texture(u64 key) noexcept -> u16;
+
+        /// map a float to 24 bits keeping its order, negative values included
+        [[nodiscard]]
+        static constexpr auto depth_bits(f32 depth) noexcept -> u64;
+    };
+
+    struct DrawPacket {
+        u64 key     = 0;
+        u32 payload = 0;
+    };
+
+    /// Consecutive sorted packets sharing the same pipeline and texture.
+    struct DrawBatch {
+        u8  pipeline = 0;
+        u16 texture  = 0;
+        u32 first    = 0;
+        u32 count    = 0;
+    };
+
+    class STORMKIT_ENGINE_API RenderQueue {
+      public:
+        RenderQueue() noexcept;
+        ~RenderQueue() noexcept;
+
+        RenderQueue(const RenderQueue&)                    = delete;
+        auto operator=(const RenderQueue&) -> RenderQueue& = delete;
+
+        RenderQueue(RenderQueue&&) noexcept;
+        auto operator=(RenderQueue&&) noexcept -> RenderQueue&;
+
+        auto clear() noexcept -> void;
+        auto reserve(usize count) noexcept -> void;
+        auto push(u64 key, u32 payload) noexcept -> void;
+
+        /// stable LSD radix sort on the keys, digits shared by every key are skipped
+        auto sort() noexcept -> void;
+
+        /// build the batches of the sorted packets, see DrawBatch
+        [[nodiscard]]
+        auto batches() const noexcept -> std::vector<DrawBatch>;
+
+        [[nodiscard]]
+        auto packets() const noexcept -> std::span<const DrawPacket>;
+        [[nodiscard]]
+        auto size() const noexcept -> usize;
+
+      private:
+        std::vector<DrawPacket> m_packets;
+        std::vector<DrawPacket> m_scratch;
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    /////////////////////////////////////
+    /////////////////////////////////////
+    constexpr auto SortKey::depth_bits(f32 depth) noexcept -> u64 {
+        auto bits = std::bit_cast<u32>(depth);
+        bits      = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+
+        return u64 { bits >> 8u };
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    constexpr auto SortKey::opaque(u8 layer, u8 pipeline, u16 texture, f32 depth) noexcept -> u64 {
+        return (u64 { layer } << LAYER_SHIFT)
+               | (u64 { pipeline } << 47u)
+               | (u64 { texture } << 31u)
+               | (depth_bits(depth) << 7u);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    constexpr auto SortKey::translucent(u8 layer, u8 pipeline, u16 texture, f32 depth) noexcept -> u64 {
+        constexpr auto DEPTH_MASK = (u64 { 1 } << 24u) - 1u;
+
+        return (u64 { layer } << LAYER_SHIFT)
+               | (u64 { 1 } << TRANSLUCENT_SHIFT)
+               | ((~depth_bits(depth) & DEPTH_MASK) << 31u)
+               | (u64 { pipeline } << 23u)
+               | (u64 { texture } << 7u);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    constexpr auto SortKey::layer(u64 key) noexcept -> u8 {
+        return as<u8>(key >> LAYER_SHIFT);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    constexpr auto SortKey::is_translucent(u64 key) noexcept -> bool {
+        return ((key >> TRANSLUCENT_SHIFT) & 1u) == 1u;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    constexpr auto SortKey::pipeline(u64 key) noexcept -> u8 {
+        if (is_translucent(key)) return as<u8>((key >> 23u) & 0xffu);
+
+        return as<u8>((key >> 47u) & 0xffu);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    constexpr auto SortKey::texture(u64 key) noexcept -> u16 {
+        if (is_translucent(key)) return as<u16>((key >> 7u) & 0xffffu);
+
+        return as<u16>((key >> 31u) & 0xffffu);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline RenderQueue::RenderQueue() noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline RenderQueue::~RenderQueue() noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline RenderQueue::RenderQueue(RenderQueue&&) noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto RenderQueue::operator=(RenderQueue&&) noexcept -> RenderQueue& = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto RenderQueue::clear() noexcept -> void {
+        m_packets.clear();
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto RenderQueue::reserve(usize count) noexcept -> void {
+        m_packets.reserve(count);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto RenderQueue::push(u64 key, u32 payload) noexcept -> void {
+        m_packets.emplace_back(DrawPacket { .key = key, .payload = payload });
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto RenderQueue::packets() const noexcept -> std::span<const DrawPacket> {
+        return m_packets;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto RenderQueue::size() const noexcept -> usize {
+        return std::ranges::size(m_packets);
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,134 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/platform_macro.hpp>
+
+export module stormkit.engine:renderer.texture_cache;
+
+import std;
+
+import stormkit.core;
+import stormkit.image;
+import stormkit.gpu;
+
+import :vfs;
+
+namespace stdfs = std::filesystem;
+
+export namespace stormkit::engine {
+    /// Texture ready to be copied to the gpu, with its full mip chain
+    struct CachedTexture {
+        struct Level {
+            std::span<const Byte> data;
+            math::uextent3        extent;
+        };
+
+        gpu::PixelFormat   format;
+        std::vector<Level> levels;
+
+        // mapped cache file or freshly built mip chain, levels point into it
+        std::shared_ptr<const void> storage;
+
+        [[nodiscard]]
+        auto extent() const noexcept -> const math::uextent3&;
+        [[nodiscard]]
+        auto size() const noexcept -> usize;
+    };
+
+    /// Convert the source images to KTX2 files holding their full mip chain, named after the hash of the source path,
+    /// size and modification time. Later loads only stat the source and map the KTX2 file, the source is read and decoded
+    /// on a miss, so a modified source is baked again.
+    /// Sources are read through the vfs, KTX2 sources are used without baking.
+    class TextureCache {
+      public:
+        TextureCache(stdfs::path directory, const VirtualFileSystem& vfs) noexcept;
+        ~TextureCache() noexcept;
+
+        TextureCache(const TextureCache&) noexcept;
+        auto operator=(const TextureCache&) noexcept -> TextureCache&;
+
+        TextureCache(TextureCache&&) noexcept;
+        auto operator=(TextureCache&&) noexcept -> TextureCache&;
+
+        /// thread safe, return std::nullopt if the source can't be read or decoded
+        [[nodiscard]]
+        auto load(const stdfs::path& source) const noexcept -> std::optional<CachedTexture>;
+
+        [[nodiscard]]
+        auto directory() const noexcept -> const stdfs::path&;
+
+      private:
+        auto parse(FileData&& file) const noexcept -> std::optional<CachedTexture>;
+        auto bake(std::span<const Byte> source, const stdfs::path& path) const noexcept -> std::optional<CachedTexture>;
+
+        stdfs::path                  m_directory;
+        Ref<const VirtualFileSystem> m_vfs;
+    };
+} // namespace stormkit::engine
+
+/////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+/////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto CachedTexture::extent() const noexcept -> const math::uextent3& {
+        EXPECTS(not std::ranges::empty(levels));
+        return levels.front().extent;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto CachedTexture::size() const noexcept -> usize {
+        auto size = 0_usize;
+        for (const auto& level : levels) size += std::ranges::size(level.data);
+
+        return size;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline TextureCache::TextureCache(stdfs::path directory, const VirtualFileSystem& vfs) noexcept
+        : m_directory { std::move(directory) }, m_vfs { as_ref(vfs) } {
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline TextureCache::~TextureCache() noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline TextureCache::TextureCache(const TextureCache&) noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto TextureCache::operator=(const TextureCache&) noexcept -> TextureCache& = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline TextureCache::TextureCache(TextureCache&&) noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto TextureCache::operator=(TextureCache&&) noexcept -> TextureCache& = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto TextureCache::directory() const noexcept -> const stdfs::path& {
+        return m_directory;
+    }
+} // namespace stormkit::engine
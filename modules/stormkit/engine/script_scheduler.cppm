@@ -0,0 +1,144 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/lua/lua.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:script_scheduler;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    /// Lua coroutines suspended on a delay, a frame count or an event. Delays sit in hashed timer wheels and events in
+    /// subscription lists, so an update only resume the coroutines which are due. Only used on the lua thread.
+    class STORMKIT_ENGINE_API ScriptScheduler {
+      public:
+        using TaskID    = u32;
+        using HandlerID = u32;
+
+        // a time slot covers RESOLUTION, a revolution of the wheel TIME_SLOTS of them
+        static constexpr auto RESOLUTION  = fsecond { 0.001f };
+        static constexpr auto TIME_SLOTS  = 1024_usize;
+        static constexpr auto FRAME_SLOTS = 256_usize;
+
+        ScriptScheduler() noexcept;
+        ~ScriptScheduler() noexcept;
+
+        ScriptScheduler(const ScriptScheduler&)                    = delete;
+        auto operator=(const ScriptScheduler&) -> ScriptScheduler& = delete;
+
+        ScriptScheduler(ScriptScheduler&&) noexcept;
+        auto operator=(ScriptScheduler&&) noexcept -> ScriptScheduler&;
+
+        /// stormkit.scheduler: spawn, cancel, wait, wait_frames, wait_until, emit, on_message and off_message
+        auto bind(sol::state& global_state) noexcept -> void;
+
+        /// run function in a new coroutine until its first wait
+        auto spawn(sol::state_view state, sol::protected_function function, std::vector<sol::object> args = {}) noexcept
+          -> TaskID;
+        auto cancel(TaskID id) noexcept -> void;
+
+        /// resume the coroutines waiting on event and run its handlers, with args, return how many were run
+        auto emit(std::string_view event, const std::vector<sol::object>& args = {}) noexcept -> usize;
+
+        auto update(fsecond delta) noexcept -> void;
+        /// drop every coroutine and handler, must be called before their state is closed
+        auto clear() noexcept -> void;
+
+        [[nodiscard]]
+        auto task_count() const noexcept -> usize;
+
+      private:
+        struct Task {
+            sol::thread    thread;
+            sol::coroutine coroutine;
+        };
+
+        struct Timer {
+            u64    due;
+            TaskID task;
+        };
+
+        struct Handler {
+            HandlerID               id;
+            sol::protected_function function;
+        };
+
+        auto resume(TaskID id, const std::vector<sol::object>& args = {}) noexcept -> void;
+        auto finish(TaskID id) noexcept -> void;
+
+        auto current(lua_State* state) const noexcept -> std::optional<TaskID>;
+        auto wait(TaskID id, fsecond delay) noexcept -> void;
+        auto wait_frames(TaskID id, u64 frames) noexcept -> void;
+        auto wait_until(TaskID id, std::string event) noexcept -> void;
+
+        HashMap<TaskID, Task>       m_tasks;
+        HashMap<lua_State*, TaskID> m_threads;
+
+        std::vector<std::vector<Timer>> m_time_wheel  = std::vector<std::vector<Timer>>(TIME_SLOTS);
+        std::vector<std::vector<Timer>> m_frame_wheel = std::vector<std::vector<Timer>>(FRAME_SLOTS);
+        // current position of the wheels, in RESOLUTION and in frames
+        u64                             m_time        = 0;
+        u64                             m_frame       = 0;
+        f64                             m_elapsed     = 0.;
+
+        HashMap<std::string, std::vector<TaskID>>  m_waiting;
+        HashMap<std::string, std::vector<Handler>> m_handlers;
+
+        TaskID    m_next_task    = 1;
+        HandlerID m_next_handler = 1;
+        // set by the wait primitives, a coroutine yielding without one is resumed the next frame
+        bool      m_suspended    = false;
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline ScriptScheduler::ScriptScheduler() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline ScriptScheduler::~ScriptScheduler() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline ScriptScheduler::ScriptScheduler(ScriptScheduler&&) noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ScriptScheduler::operator=(ScriptScheduler&&) noexcept -> ScriptScheduler& = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ScriptScheduler::task_count() const noexcept -> usize {
+        return std::ranges::size(m_tasks);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto ScriptScheduler::current(lua_State* state) const noexcept -> std::optional<TaskID> {
+        const auto it = m_threads.find(state);
+        if (it == std::ranges::cend(m_threads)) return std::nullopt;
+
+        return it->second;
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,156 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:simulation_clock;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    /// Fixed timestep of the simulation. The elapsed frame time is accumulated and consumed by whole ticks, at most
+    /// max_catch_up() per frame, what remains give the interpolation alpha of the rendered frame between the two last
+    /// ticks. Used on the main thread, stats() can be read from any thread.
+    class STORMKIT_ENGINE_API SimulationClock {
+      public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr auto DEFAULT_TICK_RATE    = 60u;
+        // past it the simulation slows down instead of spiraling, the time in excess is dropped
+        static constexpr auto DEFAULT_MAX_CATCH_UP = 5u;
+
+        struct Stats {
+            u64             ticks       = 0;
+            u64             frames      = 0;
+            // frames built without any tick
+            u64             idle_frames = 0;
+            Clock::duration dropped     = {};
+            // exponential moving average over the last 16 ticks and frames
+            Clock::duration tick_time   = {};
+            Clock::duration render_time = {};
+        };
+
+        SimulationClock() noexcept;
+        ~SimulationClock() noexcept;
+
+        SimulationClock(const SimulationClock&)                    = delete;
+        auto operator=(const SimulationClock&) -> SimulationClock& = delete;
+
+        SimulationClock(SimulationClock&&) noexcept;
+        auto operator=(SimulationClock&&) noexcept -> SimulationClock&;
+
+        /// accumulate the time elapsed since the previous call, return the number of ticks to run this frame
+        auto advance() noexcept -> u32;
+
+        auto record_tick(Clock::duration duration) noexcept -> void;
+        auto record_render(Clock::duration duration) noexcept -> void;
+
+        auto set_tick_rate(u32 rate) noexcept -> void;
+        auto set_max_catch_up(u32 ticks) noexcept -> void;
+
+        [[nodiscard]]
+        auto tick_rate() const noexcept -> u32;
+        /// fixed delta of every tick
+        [[nodiscard]]
+        auto tick_delta() const noexcept -> fsecond;
+        /// position of the rendered frame between the previous and the last tick, in [0, 1[
+        [[nodiscard]]
+        auto alpha() const noexcept -> f32;
+
+        [[nodiscard]]
+        auto stats() const noexcept -> Stats;
+
+      private:
+        u32             m_tick_rate    = DEFAULT_TICK_RATE;
+        u32             m_max_catch_up = DEFAULT_MAX_CATCH_UP;
+        Clock::duration m_tick         = Clock::duration { std::chrono::seconds { 1 } } / DEFAULT_TICK_RATE;
+
+        std::optional<Clock::time_point> m_last;
+        Clock::duration                  m_accumulator = {};
+        f32                              m_alpha       = 0.f;
+
+        Stats         m_stats;
+        Locked<Stats> m_published;
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SimulationClock::SimulationClock() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SimulationClock::~SimulationClock() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline SimulationClock::SimulationClock(SimulationClock&&) noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SimulationClock::operator=(SimulationClock&&) noexcept -> SimulationClock& = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SimulationClock::set_tick_rate(u32 rate) noexcept -> void {
+        EXPECTS(rate > 0);
+
+        m_tick_rate = rate;
+        m_tick      = Clock::duration { std::chrono::seconds { 1 } } / rate;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SimulationClock::set_max_catch_up(u32 ticks) noexcept -> void {
+        EXPECTS(ticks > 0);
+
+        m_max_catch_up = ticks;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SimulationClock::tick_rate() const noexcept -> u32 {
+        return m_tick_rate;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SimulationClock::tick_delta() const noexcept -> fsecond {
+        return std::chrono::duration_cast<fsecond>(m_tick);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SimulationClock::alpha() const noexcept -> f32 {
+        return m_alpha;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto SimulationClock::stats() const noexcept -> Stats {
+        return *m_published.read();
+    }
+} // namespace stormkit::engine
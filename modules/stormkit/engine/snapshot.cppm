@@ -0,0 +1,137 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/platform_macro.hpp>
+
+export module stormkit.engine:snapshot;
+
+import std;
+
+import stormkit;
+
+export namespace stormkit::engine {
+    /// Triple buffer handing the last state extracted by one producer to one consumer, neither of them ever wait. The
+    /// producer fill back() then publish() it, acquire() return the last published state which stay untouched until the
+    /// next acquire(). States published faster than they are acquired are skipped.
+    /// back() hold an older state, it must be filled entirely before being published.
+    template<typename T>
+    class SnapshotBuffer {
+      public:
+        SnapshotBuffer() noexcept;
+        ~SnapshotBuffer() noexcept;
+
+        SnapshotBuffer(const SnapshotBuffer&)                    = delete;
+        auto operator=(const SnapshotBuffer&) -> SnapshotBuffer& = delete;
+
+        /// neither side may be in use
+        SnapshotBuffer(SnapshotBuffer&&) noexcept;
+        auto operator=(SnapshotBuffer&&) noexcept -> SnapshotBuffer&;
+
+        /// producer side
+        [[nodiscard]]
+        auto back() noexcept -> T&;
+        auto publish() noexcept -> void;
+
+        /// consumer side
+        [[nodiscard]]
+        auto acquire() noexcept -> const T&;
+
+        /// number of published states, the index of the next one
+        [[nodiscard]]
+        auto published() const noexcept -> u64;
+
+      private:
+        // set on the middle index when it hold a state not acquired yet
+        static constexpr auto FRESH = u8 { 0b100 };
+
+        std::array<T, 3> m_slots;
+
+        u8               m_back      = 0;
+        std::atomic<u8>  m_middle    = 1;
+        u8               m_front     = 2;
+        std::atomic<u64> m_published = 0;
+    };
+} // namespace stormkit::engine
+
+////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline SnapshotBuffer<T>::SnapshotBuffer() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline SnapshotBuffer<T>::~SnapshotBuffer() noexcept = default;
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline SnapshotBuffer<T>::SnapshotBuffer(SnapshotBuffer&& other) noexcept
+        : m_slots { std::move(other.m_slots) }, m_back { other.m_back }, m_middle { other.m_middle.load() },
+          m_front { other.m_front }, m_published { other.m_published.load() } {
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto SnapshotBuffer<T>::operator=(SnapshotBuffer&& other) noexcept -> SnapshotBuffer& {
+        if (&other == this) [[unlikely]]
+            return *this;
+
+        m_slots     = std::move(other.m_slots);
+        m_back      = other.m_back;
+        m_middle    = other.m_middle.load();
+        m_front     = other.m_front;
+        m_published = other.m_published.load();
+
+        return *this;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto SnapshotBuffer<T>::back() noexcept -> T& {
+        return m_slots[m_back];
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto SnapshotBuffer<T>::publish() noexcept -> void {
+        m_back = as<u8>(m_middle.exchange(as<u8>(m_back | FRESH), std::memory_order_acq_rel) & ~FRESH);
+        m_published.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto SnapshotBuffer<T>::acquire() noexcept -> const T& {
+        if (m_middle.load(std::memory_order_relaxed) & FRESH)
+            m_front = as<u8>(m_middle.exchange(m_front, std::memory_order_acq_rel) & ~FRESH);
+
+        return m_slots[m_front];
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename T>
+    STORMKIT_FORCE_INLINE
+    inline auto SnapshotBuffer<T>::published() const noexcept -> u64 {
+        return m_published.load(std::memory_order_relaxed);
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,215 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/platform_macro.hpp>
+
+#include <stormkit/engine/api.hpp>
+
+export module stormkit.engine:vfs;
+
+import std;
+
+import stormkit.core;
+
+namespace stdfs = std::filesystem;
+
+export namespace stormkit::engine {
+    /// Bytes of a file, kept alive by storage (a file mapping or an owned buffer)
+    struct FileData {
+        std::shared_ptr<const void> storage;
+        std::span<const Byte>       data;
+
+        [[nodiscard]]
+        auto as_string_view() const noexcept -> std::string_view;
+    };
+
+    /// Identify a version of a file without reading it, a file of a pack has the modification time of the pack
+    struct FileStatus {
+        u64                                 size;
+        std::chrono::file_clock::time_point modified;
+    };
+
+    [[nodiscard]]
+    STORMKIT_ENGINE_API auto map_file(const stdfs::path& path) noexcept -> std::optional<FileData>;
+
+    /// Read only archive of files stored back to back and aligned, with an index sorted by the hash of their name.
+    /// The whole pack is mapped once, lookups are a binary search and the returned data point into the mapping.
+    class STORMKIT_ENGINE_API AssetPack {
+      public:
+        static constexpr auto EXTENSION = std::string_view { ".skpack" };
+
+        /// may rename or replace a file before it is packed, returning false abort the build
+        using Transform = std::function<bool(std::string& name, FileData& file)>;
+
+        ~AssetPack() noexcept;
+
+        AssetPack(const AssetPack&)                    = delete;
+        auto operator=(const AssetPack&) -> AssetPack& = delete;
+
+        AssetPack(AssetPack&&) noexcept;
+        auto operator=(AssetPack&&) noexcept -> AssetPack&;
+
+        [[nodiscard]]
+        static auto open(const stdfs::path& path) noexcept -> std::optional<AssetPack>;
+        /// pack the regular files found under root / directory, named after their path relative to root
+        static auto build(const stdfs::path&           root,
+                          std::span<const stdfs::path> directories,
+                          const stdfs::path&           output,
+                          const Transform&             transform = {}) noexcept -> bool;
+
+        /// name is a relative path with '/' separators
+        [[nodiscard]]
+        auto find(std::string_view name) const noexcept -> std::optional<FileData>;
+
+        [[nodiscard]]
+        auto size() const noexcept -> usize;
+
+      private:
+        struct Entry {
+            u64 hash;
+            u64 offset;
+            u64 size;
+            u32 name_offset;
+            u32 name_size;
+        };
+
+        AssetPack(FileData&& file, std::vector<Entry>&& entries) noexcept;
+
+        auto name(const Entry& entry) const noexcept -> std::string_view;
+
+        FileData           m_file;
+        std::vector<Entry> m_entries;
+    };
+
+    /// Resolve paths against the mounted packs first, then against the disk if loose files are allowed.
+    /// Mount the packs before reading, read() is then thread safe.
+    class STORMKIT_ENGINE_API VirtualFileSystem {
+      public:
+        VirtualFileSystem() noexcept;
+        ~VirtualFileSystem() noexcept;
+
+        VirtualFileSystem(const VirtualFileSystem&)                    = delete;
+        auto operator=(const VirtualFileSystem&) -> VirtualFileSystem& = delete;
+
+        VirtualFileSystem(VirtualFileSystem&&) noexcept;
+        auto operator=(VirtualFileSystem&&) noexcept -> VirtualFileSystem&;
+
+        /// files of the pack are looked up relative to mount_point, later mounts take precedence
+        auto mount(const stdfs::path& pack, const stdfs::path& mount_point) noexcept -> bool;
+        auto set_loose_files(bool enabled) noexcept -> void;
+
+        [[nodiscard]]
+        auto read(const stdfs::path& path) const noexcept -> std::optional<FileData>;
+        [[nodiscard]]
+        auto exists(const stdfs::path& path) const noexcept -> bool;
+        /// std::nullopt if the file doesn't exist, nothing is read
+        [[nodiscard]]
+        auto status(const stdfs::path& path) const noexcept -> std::optional<FileStatus>;
+
+        [[nodiscard]]
+        auto loose_files() const noexcept -> bool;
+
+      private:
+        struct Mount {
+            stdfs::path                         point;
+            AssetPack                           pack;
+            std::chrono::file_clock::time_point modified;
+        };
+
+        struct Found {
+            Ref<const Mount> mount;
+            FileData         file;
+        };
+
+        auto find(const stdfs::path& path) const noexcept -> std::optional<Found>;
+
+        std::vector<Mount> m_mounts;
+        bool               m_loose_files = true;
+    };
+} // namespace stormkit::engine
+
+/////////////////////////////////////////////////////////////////////
+///                      IMPLEMENTATION                          ///
+/////////////////////////////////////////////////////////////////////
+
+namespace stormkit::engine {
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto FileData::as_string_view() const noexcept -> std::string_view {
+        return { std::bit_cast<const char*>(std::ranges::data(data)), std::ranges::size(data) };
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline AssetPack::AssetPack(FileData&& file, std::vector<Entry>&& entries) noexcept
+        : m_file { std::move(file) }, m_entries { std::move(entries) } {
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline AssetPack::~AssetPack() noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline AssetPack::AssetPack(AssetPack&&) noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto AssetPack::operator=(AssetPack&&) noexcept -> AssetPack& = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto AssetPack::size() const noexcept -> usize {
+        return std::ranges::size(m_entries);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto AssetPack::name(const Entry& entry) const noexcept -> std::string_view {
+        return { std::bit_cast<const char*>(std::ranges::data(m_file.data)) + entry.name_offset, entry.name_size };
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline VirtualFileSystem::VirtualFileSystem() noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline VirtualFileSystem::~VirtualFileSystem() noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline VirtualFileSystem::VirtualFileSystem(VirtualFileSystem&&) noexcept = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto VirtualFileSystem::operator=(VirtualFileSystem&&) noexcept -> VirtualFileSystem& = default;
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto VirtualFileSystem::set_loose_files(bool enabled) noexcept -> void {
+        m_loose_files = enabled;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    STORMKIT_FORCE_INLINE
+    inline auto VirtualFileSystem::loose_files() const noexcept -> bool {
+        return m_loose_files;
+    }
+} // namespace stormkit::engine
@@ -8,17 +8,35 @@ struct Camera {
     view: mat4x4f,
 }
 
+// pushed for each frame, the camera uniform is only uploaded when the camera move
+struct FrameConstants {
+    time: f32,
+}
+
+// basis and origin are the 2D affine model transform, see SpriteInstance
 struct SpriteData {
-    model: mat4x4f,
+    basis: vec4f,
+    origin: vec4f,
+    uv_rect: vec4f,
+    animation: vec4f,
+    animation_start: vec4f,
 }
 
 @group(0) @binding(0)
 var<uniform> camera: Camera;
 
+var<push_constant> frame_constants: FrameConstants;
+
 @group(1) @binding(0)
-var<uniform> sprite_data: SpriteData;
+var<storage, read> sprites: array<SpriteData>;
+
+@group(2) @binding(0)
+var sprite_texture: texture_2d<f32>;
 
-@vertex fn vert_main(@builtin(vertex_index) id: u32) -> VertOut {
+@group(2) @binding(1)
+var sprite_sampler: sampler;
+
+@vertex fn vert_main(@builtin(vertex_index) id: u32, @builtin(instance_index) instance: u32) -> VertOut {
     var output: VertOut;
 
     var vertex = vec2f(0.f, 0.f);
@@ -30,8 +48,19 @@ var<uniform> sprite_data: SpriteData;
         vertex = vec2f(1.f, 1.f);
     }
 
-    output.position = camera.proj * camera.view * sprite_data.model * vec4f(vertex, 1., 1.);
-    output.uv    = vertex;
+    let sprite = sprites[instance];
+
+    // animation.xy: uv offset between frames, animation.z: frame count, animation.w: frame duration
+    var uv_rect = sprite.uv_rect;
+    if (sprite.animation.z > 1. && sprite.animation.w > 0.) {
+        let elapsed = max(frame_constants.time - sprite.animation_start.x, 0.);
+        let frame   = floor(elapsed / sprite.animation.w) % sprite.animation.z;
+        uv_rect    += sprite.animation.xyxy * frame;
+    }
+
+    let world       = sprite.origin.xy + sprite.basis.xy * vertex.x + sprite.basis.zw * vertex.y;
+    output.position = camera.proj * camera.view * vec4f(world, 1., 1.);
+    output.uv    = mix(uv_rect.xy, uv_rect.zw, vertex);
 
     return output;
 }
@@ -47,7 +76,7 @@ struct FragOut {
 @fragment fn frag_main(input: FragIn) -> FragOut {
     var output: FragOut;
 
-    output.color = vec4f(input.uv, 1., 1.);
+    output.color = textureSample(sprite_texture, sprite_sampler, input.uv);
 
     return output;
 }
@@ -0,0 +1,101 @@
+// basis and origin are the 2D affine model transform, see SpriteInstance
+struct SpriteData {
+    basis: vec4f,
+    origin: vec4f,
+    uv_rect: vec4f,
+    animation: vec4f,
+    animation_start: vec4f,
+}
+
+struct CullInput {
+    instance_count: u32,
+    batch_count: u32,
+    padding: vec2u,
+    batch_of: array<u32>,
+}
+
+struct CullStats {
+    visible: atomic<u32>,
+}
+
+struct DrawCommand {
+    vertex_count: u32,
+    instance_count: atomic<u32>,
+    first_vertex: u32,
+    first_instance: u32,
+}
+
+const WORKGROUP_SIZE: u32 = 256u;
+const VISIBLE_BIT: u32 = 0x80000000u;
+
+@group(1) @binding(0)
+var<storage, read> sprites: array<SpriteData>;
+
+@group(1) @binding(1)
+var<storage, read> cull_input: CullInput;
+
+@group(1) @binding(2)
+var<storage, read_write> prefixes: array<u32>;
+
+@group(1) @binding(3)
+var<storage, read_write> chunk_counts: array<u32>;
+
+@group(1) @binding(4)
+var<storage, read_write> visible_sprites: array<SpriteData>;
+
+@group(1) @binding(5)
+var<storage, read_write> commands: array<DrawCommand>;
+
+@group(1) @binding(6)
+var<storage, read_write> stats: CullStats;
+
+var<workgroup> partial: array<u32, WORKGROUP_SIZE>;
+
+// scatter the sprites flagged by sprite_cull.wgsl keeping their sorted order,
+// each batch draw the contiguous run of its visible sprites
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn compact_main(@builtin(global_invocation_id) global_id: vec3u,
+                @builtin(local_invocation_id) local_id: vec3u,
+                @builtin(workgroup_id) group_id: vec3u) {
+    let local = local_id.x;
+
+    // the chunk start at the count of visible sprites in the previous chunks
+    var sum = 0u;
+    for (var chunk = local; chunk < group_id.x; chunk += WORKGROUP_SIZE) {
+        sum += chunk_counts[chunk];
+    }
+    partial[local] = sum;
+    workgroupBarrier();
+
+    for (var stride = WORKGROUP_SIZE / 2u; stride > 0u; stride >>= 1u) {
+        if (local < stride) {
+            partial[local] += partial[local + stride];
+        }
+        workgroupBarrier();
+    }
+
+    // one add per chunk, the host visible counter is not hammered per sprite
+    if (local == 0u) {
+        atomicAdd(&stats.visible, chunk_counts[group_id.x]);
+    }
+
+    let index = global_id.x;
+    if (index >= cull_input.instance_count) {
+        return;
+    }
+
+    let prefix   = prefixes[index];
+    let position = partial[0] + (prefix & ~VISIBLE_BIT);
+    let batch    = cull_input.batch_of[index];
+
+    if (index == 0u || cull_input.batch_of[index - 1u] != batch) {
+        commands[batch].first_instance = position;
+    }
+
+    if ((prefix & VISIBLE_BIT) == 0u) {
+        return;
+    }
+
+    visible_sprites[position] = sprites[index];
+    atomicAdd(&commands[batch].instance_count, 1u);
+}
@@ -0,0 +1,122 @@
+struct Camera {
+    proj: mat4x4f,
+    view: mat4x4f,
+}
+
+// basis and origin are the 2D affine model transform, see SpriteInstance
+struct SpriteData {
+    basis: vec4f,
+    origin: vec4f,
+    uv_rect: vec4f,
+    animation: vec4f,
+    animation_start: vec4f,
+}
+
+struct CullInput {
+    instance_count: u32,
+    batch_count: u32,
+    padding: vec2u,
+    batch_of: array<u32>,
+}
+
+struct CullStats {
+    visible: atomic<u32>,
+}
+
+struct DrawCommand {
+    vertex_count: u32,
+    instance_count: atomic<u32>,
+    first_vertex: u32,
+    first_instance: u32,
+}
+
+const WORKGROUP_SIZE: u32 = 256u;
+const VISIBLE_BIT: u32 = 0x80000000u;
+
+@group(0) @binding(0)
+var<uniform> camera: Camera;
+
+@group(1) @binding(0)
+var<storage, read> sprites: array<SpriteData>;
+
+@group(1) @binding(1)
+var<storage, read> cull_input: CullInput;
+
+@group(1) @binding(2)
+var<storage, read_write> prefixes: array<u32>;
+
+@group(1) @binding(3)
+var<storage, read_write> chunk_counts: array<u32>;
+
+@group(1) @binding(5)
+var<storage, read_write> commands: array<DrawCommand>;
+
+// host visible, read back by the CPU for the culling statistics
+@group(1) @binding(6)
+var<storage, read_write> stats: CullStats;
+
+var<workgroup> scan: array<u32, WORKGROUP_SIZE>;
+
+fn is_visible(sprite: SpriteData) -> bool {
+    let transform = camera.proj * camera.view;
+
+    var lower = vec2f(3.40282347e+38f);
+    var upper = vec2f(-3.40282347e+38f);
+    for (var corner = 0u; corner < 4u; corner++) {
+        let vertex   = vec2f(f32(corner & 1u), f32(corner >> 1u));
+        let world    = sprite.origin.xy + sprite.basis.xy * vertex.x + sprite.basis.zw * vertex.y;
+        let position = transform * vec4f(world, 1., 1.);
+        let ndc      = position.xy / position.w;
+
+        lower = min(lower, ndc);
+        upper = max(upper, ndc);
+    }
+
+    return all(upper >= vec2f(-1.f)) && all(lower <= vec2f(1.f));
+}
+
+// flag visible sprites and prefix sum the flags of each workgroup chunk,
+// sprite_compact.wgsl then offset the chunks and scatter the visible sprites
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn cull_main(@builtin(global_invocation_id) global_id: vec3u,
+             @builtin(local_invocation_id) local_id: vec3u,
+             @builtin(workgroup_id) group_id: vec3u) {
+    let index = global_id.x;
+    let local = local_id.x;
+
+    if (index < cull_input.batch_count) {
+        commands[index].vertex_count   = 4u;
+        commands[index].first_vertex   = 0u;
+        commands[index].first_instance = 0u;
+        atomicStore(&commands[index].instance_count, 0u);
+    }
+
+    if (index == 0u) {
+        atomicStore(&stats.visible, 0u);
+    }
+
+    var visible = 0u;
+    if (index < cull_input.instance_count && is_visible(sprites[index])) {
+        visible = 1u;
+    }
+
+    scan[local] = visible;
+    workgroupBarrier();
+
+    for (var offset = 1u; offset < WORKGROUP_SIZE; offset <<= 1u) {
+        var value = scan[local];
+        if (local >= offset) {
+            value += scan[local - offset];
+        }
+        workgroupBarrier();
+        scan[local] = value;
+        workgroupBarrier();
+    }
+
+    // exclusive prefix in the low bits, visibility in the high bit
+    prefixes[index] = (scan[local] - visible) | select(0u, VISIBLE_BIT, visible == 1u);
+
+    if (local == WORKGROUP_SIZE - 1u) {
+        chunk_counts[group_id.x] = scan[local];
+    }
+}
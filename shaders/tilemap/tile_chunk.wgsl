@@ -0,0 +1,72 @@
+struct VertOut {
+    @builtin(position) position: vec4f,
+    @location(0) uv: vec2f
+}
+
+struct Camera {
+    proj: mat4x4f,
+    view: mat4x4f,
+}
+
+const CHUNK_SIZE: u32         = 32u;
+const CHUNK_TILE_COUNT: u32   = CHUNK_SIZE * CHUNK_SIZE;
+// origin.xy, tile_size.xy, tile_uv.xy, columns, tile count
+const CHUNK_HEADER_COUNT: u32 = 8u;
+const SLOT_COUNT: u32         = CHUNK_HEADER_COUNT + CHUNK_TILE_COUNT;
+
+@group(0) @binding(0)
+var<uniform> camera: Camera;
+
+@group(1) @binding(0)
+var<storage, read> chunks: array<u32>;
+
+@group(2) @binding(0)
+var tileset: texture_2d<f32>;
+
+@group(2) @binding(1)
+var tileset_sampler: sampler;
+
+fn header_vec2(slot: u32, index: u32) -> vec2f {
+    return vec2f(bitcast<f32>(chunks[slot + index]), bitcast<f32>(chunks[slot + index + 1u]));
+}
+
+// each chunk is drawn with first_instance = its slot * CHUNK_TILE_COUNT,
+// the tiles packed as x (5 bits) | y (5 bits) << 5 | tile index (16 bits) << 16
+@vertex fn vert_main(@builtin(vertex_index) id: u32, @builtin(instance_index) instance: u32) -> VertOut {
+    var output: VertOut;
+
+    let vertex = vec2f(f32(id & 1u), f32(id >> 1u));
+
+    let slot      = (instance / CHUNK_TILE_COUNT) * SLOT_COUNT;
+    let origin    = header_vec2(slot, 0u);
+    let tile_size = header_vec2(slot, 2u);
+    let tile_uv   = header_vec2(slot, 4u);
+    let columns   = chunks[slot + 6u];
+
+    let packed = chunks[slot + CHUNK_HEADER_COUNT + instance % CHUNK_TILE_COUNT];
+    let cell   = vec2f(f32(packed & 31u), f32((packed >> 5u) & 31u));
+    let tile   = (packed >> 16u) - 1u;
+
+    let position = origin + (cell + vertex) * tile_size;
+
+    output.position = camera.proj * camera.view * vec4f(position, 1., 1.);
+    output.uv       = (vec2f(f32(tile % columns), f32(tile / columns)) + vertex) * tile_uv;
+
+    return output;
+}
+
+struct FragIn {
+    @location(0) uv: vec2f
+}
+
+struct FragOut {
+    @location(0) color: vec4f
+}
+
+@fragment fn frag_main(input: FragIn) -> FragOut {
+    var output: FragOut;
+
+    output.color = textureSample(tileset, tileset_sampler, input.uv);
+
+    return output;
+}
@@ -32,14 +32,18 @@ namespace stormkit::engine {
         constexpr auto CAMERA_BUFFER_NAME          = "StormKit:2d_pipeline:render_sprites:camera_buffer";
         constexpr auto CAMERA_STAGING_BUFFER_NAME  = "StormKit:2d_pipeline:update_camera_buffer:camera_staging_buffer";
         constexpr auto CAMERA_BUFFER_SIZE          = sizeof(Camera);
+        // dynamic offsets are kept aligned on the highest minUniformBufferOffsetAlignment allowed by Vulkan
+        constexpr auto CAMERA_REGION_SIZE = (CAMERA_BUFFER_SIZE + 255_usize) & ~255_usize;
     } // namespace
 
     extern auto bind_pipeline_2d(sol::state& global_state) noexcept -> void;
+    extern auto bind_tilemap(sol::state& global_state, Pipeline2D& pipeline) noexcept -> void;
 
     //////////////////////////////////////
     //////////////////////////////////////
     Pipeline2D::Pipeline2D(Application& application, const math::fextent2& viewport, PrivateTag) noexcept
-        : m_world { as_ref(application.world()) }, m_view { ViewData::create_dirty() }, m_sprite_render_system {} {
+        : m_world { as_ref(application.world()) }, m_view { ViewData::create() }, m_sprite_render_system {},
+          m_tilemap_renderer {} {
         m_view.write().viewport = viewport;
         application.append_binder(&bind_pipeline_2d);
     }
@@ -101,7 +105,7 @@ namespace stormkit::engine {
           .camera_buffer = Try(gpu::Buffer::create(device,
                                                    {
                                                      .usages = gpu::BufferUsageFlag::UNIFORM | gpu::BufferUsageFlag::TRANSFER_DST,
-                                                     .size   = CAMERA_BUFFER_SIZE * renderer.buffering_count(),
+                                                     .size   = CAMERA_REGION_SIZE * renderer.buffering_count(),
                                                      .property = gpu::MemoryPropertyFlag::DEVICE_LOCAL,
                                                    }));
         const auto camera_sets = into_dyn_array<gpu::Descriptor>(gpu::BufferDescriptor {
@@ -117,6 +121,9 @@ namespace stormkit::engine {
         m_sprite_render_system.unsafe() = Try(pipeline_2d::SpriteRenderSystem::create(renderer,
                                                                                       m_scene_data.pipeline_state,
                                                                                       *m_scene_data.camera_descriptor_layout));
+        m_tilemap_renderer.unsafe()     = Try(pipeline_2d::TilemapRenderer::create(renderer,
+                                                                               m_scene_data.pipeline_state,
+                                                                               *m_scene_data.camera_descriptor_layout));
 
         Return {};
     }
@@ -127,21 +134,41 @@ namespace stormkit::engine {
         const auto& renderer = application.renderer();
         auto&       _world   = application.world();
 
+        // the entity manager only deliver the added and removed entities, the sprites are read from the snapshots
         auto world = _world.write();
-        world->add_system("StormKit:sprite_render_system",
-                          { pipeline_2d::StaticSpriteComponent::type() },
+        world->add_system("StormKit:animated_sprite_system",
+                          { pipeline_2d::AnimatedSpriteComponent::type(),
+                            pipeline_2d::StaticSpriteComponent::type(),
+                            pipeline_2d::TransformComponent::type() },
                           entities::System::Closures {
-                            .update =
-                              [this](auto& world, auto delta, const auto& entities) noexcept {
-                                  auto render_system = m_sprite_render_system.write();
-                                  render_system->update(world, delta, entities);
+                            .update              = [](auto&, auto, const auto&) static noexcept {},
+                            .on_message_received =
+                              [this](auto&, const auto&, const auto& entities) noexcept {
+                                  m_sprite_extractor.set_animated(entities);
                               },
+                          });
+        world->add_system("StormKit:sprite_render_system",
+                          { pipeline_2d::StaticSpriteComponent::type(), pipeline_2d::TransformComponent::type() },
+                          entities::System::Closures {
+                            .update              = [](auto&, auto, const auto&) static noexcept {},
                             .on_message_received =
                               [this, &renderer](auto& world, const auto& message, const auto& entities) noexcept {
                                   auto render_system = m_sprite_render_system.write();
                                   render_system->on_message_received(renderer, world, message, entities);
                               },
                           });
+
+        application.systems().add_system("StormKit:sprite_extract_system",
+                                         { pipeline_2d::StaticSpriteComponent::type(), pipeline_2d::TransformComponent::type() },
+                                         { .reads = { pipeline_2d::AnimatedSpriteComponent::type() }, .writes = {} },
+                                         [this](auto& world, auto delta, auto entities) noexcept {
+                                             m_sprite_extractor.extract(world, entities, delta, m_sprite_snapshots.back());
+                                             m_sprite_snapshots.publish();
+                                         },
+                                         SystemScheduler::Phase::EXTRACT);
+
+        // bound here as the pipeline has reached its final address
+        application.append_binder([this](auto& global_state) noexcept { bind_tilemap(global_state, *this); });
     }
 
     //////////////////////////////////////
@@ -165,7 +192,28 @@ namespace stormkit::engine {
           [](auto&, auto&, const auto&) static noexcept {},
           FrameBuilder::ROOT);
 
-        if (m_view.dirty()) update_task(renderer, graph, camera_buffer_id);
+        // each frame in flight read its own camera region, it is only uploaded when behind the view
+        const auto frame                   = renderer.current_frame();
+        m_scene_data.camera_current_offset = as<u32>(frame * CAMERA_REGION_SIZE);
+
+        // the animation time is pushed by the sprite render task, the camera is only uploaded when it moves
+        if (m_view.dirty(frame)) update_task(graph, camera_buffer_id, frame);
+
+        // drawn from the last extracted tick, interpolated toward it. A snapshot spanning several ticks is interpolated over
+        // its last tick only, the frame stays at the same time behind the simulation
+        const auto& simulation = application.simulation();
+        const auto& snapshot   = m_sprite_snapshots.acquire();
+        const auto  alpha      = (snapshot.delta > fsecond::zero())
+                                   ? 1.f - (1.f - simulation.alpha()) * (simulation.tick_delta() / snapshot.delta)
+                                   : simulation.alpha();
+        m_sprite_render_system.write()->update(snapshot, alpha);
+
+        // the tilemap is drawn in the sprite pass, under the sprites
+        auto tilemap_draws = m_tilemap_renderer.write()->insert_tasks(application,
+                                                                      graph,
+                                                                      *m_scene_data.camera_descriptor_set,
+                                                                      m_scene_data.camera_current_offset,
+                                                                      camera_bounds());
 
         m_sprite_render_system.write()
           ->insert_tasks(application,
@@ -173,15 +221,21 @@ namespace stormkit::engine {
                          *backbuffer_id,
                          camera_buffer_id,
                          *m_scene_data.camera_descriptor_set,
-                         m_scene_data.camera_current_offset);
+                         m_scene_data.camera_current_offset,
+                         camera_bounds(),
+                         std::move(tilemap_draws));
     }
 
     //////////////////////////////////////
     //////////////////////////////////////
-    auto Pipeline2D::update_task(const Renderer&          renderer,
-                                 FrameBuilder&            graph,
-                                 FrameBuilder::ResourceID camera_buffer_id) noexcept -> void {
-        m_view.mark_not_dirty();
+    auto Pipeline2D::update_task(FrameBuilder& graph, FrameBuilder::ResourceID camera_buffer_id, u32 frame) noexcept
+      -> void {
+        m_view.mark_synced(frame);
+
+        // copied now, the slot hold the version it was marked synced with
+        auto camera       = Camera {};
+        camera.projection = math::transpose(m_view.read().camera.projection);
+        camera.view       = math::transpose(m_view.read().camera.view);
 
         struct UpdateCameraTaskData {
             FrameBuilder::ResourceID camera_staging_buffer_id = {};
@@ -198,23 +252,16 @@ namespace stormkit::engine {
                                                                     });
               data.camera_buffer_id         = camera_buffer_id;
 
-              m_scene_data.camera_current_offset = (renderer.current_frame() * CAMERA_BUFFER_SIZE) % renderer.buffering_count();
-
               builder.write_buffer(data.camera_buffer_id);
               builder.write_buffer(data.camera_staging_buffer_id);
           },
-          [this, &renderer](auto& frame_resources, auto& cmb, const auto& data) noexcept {
+          [camera, offset = m_scene_data.camera_current_offset](auto& frame_resources, auto& cmb, const auto& data) noexcept {
               auto&       camera_staging_buffer = frame_resources.get_buffer(data.camera_staging_buffer_id);
               const auto& camera_buffer         = frame_resources.get_buffer(data.camera_buffer_id);
 
-              auto camera       = Camera {};
-              camera.projection = math::transpose(m_view.read().camera.projection);
-              camera.view       = math::transpose(m_view.read().camera.view);
               camera_staging_buffer.upload(as_bytes(camera));
 
-              cmb.copy_buffer(camera_staging_buffer, camera_buffer, CAMERA_BUFFER_SIZE, m_scene_data.camera_current_offset);
-
-              m_view.mark_not_dirty();
+              cmb.copy_buffer(camera_staging_buffer, camera_buffer, CAMERA_BUFFER_SIZE, offset);
           });
     }
 } // namespace stormkit::engine
@@ -18,14 +18,15 @@ namespace sm = stormkit::monadic;
 
 namespace stormkit::engine {
     auto make_sprite(World& _world, TextureID texture_id, const math::fbounding_rect& sprite_rect) {
-        auto world = _world.m_world.write();
+        // called from a script system the world is already locked by the tick
+        return _world.write_world([&](auto& world) noexcept {
+            auto e = world.make_entity();
 
-        auto e = world->make_entity();
+            world.add_component(e, pipeline_2d::TransformComponent {});
+            world.add_component(e, pipeline_2d::StaticSpriteComponent { texture_id, sprite_rect });
 
-        world->add_component(e, pipeline_2d::TransformComponent {});
-        world->add_component(e, pipeline_2d::StaticSpriteComponent { texture_id, sprite_rect });
-
-        return e;
+            return e;
+        });
     }
 
     auto bind_pipeline_2d_components(sol::state& global_state, sol::table& engine) noexcept -> void {
@@ -34,6 +35,10 @@ namespace stormkit::engine {
                                                                                pipeline_2d::TransformComponent(math::fvec2)> {},
                                                              "position",
                                                              &pipeline_2d::TransformComponent::position,
+                                                             "scale",
+                                                             &pipeline_2d::TransformComponent::scale,
+                                                             "rotate",
+                                                             &pipeline_2d::TransformComponent::rotate,
                                                              "type",
                                                              &pipeline_2d::TransformComponent::component_name);
         engine.new_usertype<
@@ -43,12 +48,33 @@ namespace stormkit::engine {
                                                                                                    math::fbounding_rect)> {},
                                               "texture",
                                               &pipeline_2d::StaticSpriteComponent::texture_id,
+                                              "layer",
+                                              &pipeline_2d::StaticSpriteComponent::layer,
+                                              "depth",
+                                              &pipeline_2d::StaticSpriteComponent::depth,
+                                              "translucent",
+                                              &pipeline_2d::StaticSpriteComponent::translucent,
                                               "type",
                                               &pipeline_2d::StaticSpriteComponent::component_name);
 
+        engine.new_usertype<pipeline_2d::AnimatedSpriteComponent>("animated_sprite_component",
+                                                                  sol::constructors<pipeline_2d::AnimatedSpriteComponent()> {},
+                                                                  "frame_count",
+                                                                  &pipeline_2d::AnimatedSpriteComponent::frame_count,
+                                                                  "frame_stride",
+                                                                  &pipeline_2d::AnimatedSpriteComponent::frame_stride,
+                                                                  "frame_duration",
+                                                                  &pipeline_2d::AnimatedSpriteComponent::frame_duration,
+                                                                  "start_time",
+                                                                  &pipeline_2d::AnimatedSpriteComponent::start_time,
+                                                                  "type",
+                                                                  &pipeline_2d::AnimatedSpriteComponent::component_name);
+
         auto& world = sol::object { engine["world"] }.as<World>();
         bind_component_to_world<pipeline_2d::TransformComponent>(world, pipeline_2d::TransformComponent::component_name());
         bind_component_to_world<pipeline_2d::StaticSpriteComponent>(world, pipeline_2d::StaticSpriteComponent::component_name());
+        bind_component_to_world<pipeline_2d::AnimatedSpriteComponent>(world,
+                                                                      pipeline_2d::AnimatedSpriteComponent::component_name());
     }
 
     auto bind_pipeline_2d(sol::state& global_state) noexcept -> void {
@@ -59,9 +85,77 @@ namespace stormkit::engine {
           "resources_store",
           sol::no_constructor,
           "load_image",
-          +[](ResourceStore* store, std::string_view path) static noexcept { return store->load_image(stdfs::path { path }); });
+          +[](ResourceStore* store, std::string_view path) static noexcept { return store->load_image(stdfs::path { path }); },
+          "load_images",
+          +[](ResourceStore* store, std::vector<std::string> paths) static noexcept {
+              const auto _paths = paths
+                                  | std::views::transform([](const auto& path) static noexcept { return stdfs::path { path }; })
+                                  | std::ranges::to<std::vector>();
+              return sol::as_table(store->load_images(_paths));
+          },
+          "load_image_async",
+          +[](ResourceStore* store, std::string_view path, sol::optional<sol::protected_function> on_loaded) static noexcept {
+              auto callback = ResourceStore::OnImageLoaded {};
+              if (on_loaded)
+                  callback = [on_loaded = *std::move(on_loaded)](TextureID id, bool success) {
+                      lua::luacall(on_loaded, id, success);
+                  };
+
+              return store->load_image_async(stdfs::path { path }, std::move(callback), ResourceStore::CallbackThread::DEFERRED)
+                .id;
+          },
+          "is_loaded",
+          &ResourceStore::is_loaded,
+          "set_texture_budget",
+          &ResourceStore::set_texture_budget,
+          "texture_stats",
+          +[](const ResourceStore* store, sol::this_state state) static noexcept {
+              const auto stats = store->texture_stats();
+
+              auto table              = sol::state_view { state }.create_table();
+              table["resident_bytes"] = stats.resident_bytes;
+              table["budget"]         = stats.budget;
+              table["resident_count"] = stats.resident_count;
+              table["evictions"]      = stats.evictions;
+              table["reloads"]        = stats.reloads;
+
+              return table;
+          });
         auto pipeline_2d      = engine["2d"].get_or_create<sol::table>();
+        pipeline_2d["animation_time"] = &pipeline_2d::animation_time;
         engine["make_sprite"] = &make_sprite;
     }
 
+    auto bind_tilemap(sol::state& global_state, Pipeline2D& pipeline) noexcept -> void {
+        auto engine  = global_state["stormkit"].get_or_create<sol::table>();
+        auto tilemap = engine["2d"].get_or_create<sol::table>()["tilemap"].get_or_create<sol::table>();
+
+        tilemap["open"] = [&pipeline](std::string_view path) noexcept {
+            return pipeline.tilemap().write()->tilemap().open(stdfs::path { path });
+        };
+        tilemap["save"] = [&pipeline](sol::optional<std::string_view> path) noexcept {
+            auto renderer = pipeline.tilemap().write();
+            if (path) return renderer->tilemap().save(stdfs::path { *path });
+
+            return renderer->tilemap().save();
+        };
+        // the world size of a tile default to its size in the texture
+        tilemap["set_tileset"] = [&pipeline](TextureID          texture,
+                                             f32                tile_width,
+                                             f32                tile_height,
+                                             sol::optional<f32> world_width,
+                                             sol::optional<f32> world_height) noexcept {
+            pipeline.tilemap().write()->set_tileset(texture,
+                                                    { tile_width, tile_height },
+                                                    { world_width.value_or(tile_width), world_height.value_or(tile_height) });
+        };
+        tilemap["set_tile"] = [&pipeline](i32 x, i32 y, u16 tile) noexcept {
+            pipeline.tilemap().write()->tilemap().set_tile(x, y, tile);
+        };
+        tilemap["tile"] = [&pipeline](i32 x, i32 y) noexcept { return pipeline.tilemap().write()->tilemap().tile(x, y); };
+        tilemap["fill"] = [&pipeline](i32 x, i32 y, u32 width, u32 height, u16 tile) noexcept {
+            pipeline.tilemap().write()->tilemap().fill(x, y, width, height, tile);
+        };
+    }
+
 } // namespace stormkit::engine
@@ -0,0 +1,141 @@
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :pipeline_2d.sprite_grid;
+
+namespace stormkit::engine::pipeline_2d {
+    namespace {
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto cell_key(i32 x, i32 y) noexcept -> u64 {
+            return (u64 { std::bit_cast<u32>(x) } << 32) | u64 { std::bit_cast<u32>(y) };
+        }
+    } // namespace
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteGrid::update(entities::Entity e, const math::fbounding_rect& bounds) noexcept -> void {
+        const auto range = to_cell_range(bounds);
+
+        if (auto it = m_entry_of.find(e); it != std::ranges::end(m_entry_of)) {
+            auto& entry = m_entries[it->second];
+            if (entry.cells == range) return;
+
+            unlink(it->second, entry.cells);
+            entry.cells = range;
+            link(it->second, range);
+
+            return;
+        }
+
+        auto index = 0u;
+        if (not std::ranges::empty(m_free_entries)) {
+            index = m_free_entries.back();
+            m_free_entries.pop_back();
+            m_entries[index] = Entry { .e = e, .cells = range };
+        } else {
+            index = as<u32>(std::ranges::size(m_entries));
+            m_entries.emplace_back(Entry { .e = e, .cells = range });
+        }
+
+        m_entry_of.emplace(e, index);
+        link(index, range);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteGrid::remove(entities::Entity e) noexcept -> void {
+        auto it = m_entry_of.find(e);
+        if (it == std::ranges::end(m_entry_of)) return;
+
+        const auto index = it->second;
+        unlink(index, m_entries[index].cells);
+        m_entries[index].cells = {};
+
+        m_free_entries.emplace_back(index);
+        m_entry_of.erase(it);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteGrid::clear() noexcept -> void {
+        m_cells.clear();
+        m_entry_of.clear();
+        m_entries.clear();
+        m_free_entries.clear();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteGrid::query(const math::fbounding_rect& rect, std::vector<entities::Entity>& out) const noexcept -> void {
+        const auto range = to_cell_range(rect);
+
+        // the stamp avoid reporting twice an entity which overlap several cells
+        if (++m_query_stamp == 0) {
+            for (auto& entry : m_entries) entry.query_stamp = 0;
+            m_query_stamp = 1;
+        }
+
+        for (auto y = range.min_y; y <= range.max_y; ++y) {
+            for (auto x = range.min_x; x <= range.max_x; ++x) {
+                const auto it = m_cells.find(cell_key(x, y));
+                if (it == std::ranges::cend(m_cells)) continue;
+
+                for (const auto index : it->second) {
+                    const auto& entry = m_entries[index];
+                    if (entry.query_stamp == m_query_stamp) continue;
+
+                    entry.query_stamp = m_query_stamp;
+                    out.emplace_back(entry.e);
+                }
+            }
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteGrid::to_cell_range(const math::fbounding_rect& bounds) const noexcept -> CellRange {
+        const auto to_cell = [this](f32 value) noexcept { return as<i32>(std::floor(value * m_inv_cell_size)); };
+
+        return CellRange {
+            .min_x = to_cell(std::min(bounds.left, bounds.right)),
+            .min_y = to_cell(std::min(bounds.top, bounds.bottom)),
+            .max_x = to_cell(std::max(bounds.left, bounds.right)),
+            .max_y = to_cell(std::max(bounds.top, bounds.bottom)),
+        };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteGrid::link(u32 entry, const CellRange& range) noexcept -> void {
+        for (auto y = range.min_y; y <= range.max_y; ++y)
+            for (auto x = range.min_x; x <= range.max_x; ++x) m_cells[cell_key(x, y)].emplace_back(entry);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteGrid::unlink(u32 entry, const CellRange& range) noexcept -> void {
+        for (auto y = range.min_y; y <= range.max_y; ++y) {
+            for (auto x = range.min_x; x <= range.max_x; ++x) {
+                const auto key = cell_key(x, y);
+                auto       it  = m_cells.find(key);
+                if (it == std::ranges::end(m_cells)) continue;
+
+                auto& cell = it->second;
+                if (auto found = std::ranges::find(cell, entry); found != std::ranges::end(cell)) {
+                    *found = cell.back();
+                    cell.pop_back();
+                }
+
+                if (std::ranges::empty(cell)) m_cells.erase(it);
+            }
+        }
+    }
+} // namespace stormkit::engine::pipeline_2d
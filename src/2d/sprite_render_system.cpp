@@ -1,5 +1,6 @@
 module;
 
+#include <stormkit/core/contract_macro.hpp>
 #include <stormkit/core/try_expected.hpp>
 
 #include <stormkit/log/log_macro.hpp>
@@ -20,16 +21,50 @@ namespace stormkit::engine::pipeline_2d {
     LOGGER("sprite render system")
 
     struct SpriteData {
-        math::fmat4 model = math::fmat4::identity();
-
         static constexpr auto layout_binding() -> gpu::DescriptorSetLayoutBinding {
             return { .binding          = 0,
-                     .type             = gpu::DescriptorType::UNIFORM_BUFFER_DYNAMIC,
+                     .type             = gpu::DescriptorType::STORAGE_BUFFER_DYNAMIC,
                      .stages           = gpu::ShaderStageFlag::VERTEX,
                      .descriptor_count = 1 };
         }
     };
 
+    /// pushed by the render task, must match FrameConstants of quad_sprite.wgsl
+    struct FrameConstants {
+        /// animation_time() of the frame, drive the sprite animations
+        f32 time;
+    };
+
+    struct TextureData {
+        static constexpr auto layout_bindings() -> std::array<gpu::DescriptorSetLayoutBinding, 2> {
+            return {
+                gpu::DescriptorSetLayoutBinding { .binding          = 0,
+                                                 .type             = gpu::DescriptorType::SAMPLED_IMAGE,
+                                                 .stages           = gpu::ShaderStageFlag::FRAGMENT,
+                                                 .descriptor_count = 1 },
+                gpu::DescriptorSetLayoutBinding { .binding          = 1,
+                                                 .type             = gpu::DescriptorType::SAMPLER,
+                                                 .stages           = gpu::ShaderStageFlag::FRAGMENT,
+                                                 .descriptor_count = 1 },
+            };
+        }
+    };
+
+    struct CullData {
+        static constexpr auto BINDING_COUNT = 7u;
+
+        static constexpr auto layout_bindings() -> std::array<gpu::DescriptorSetLayoutBinding, BINDING_COUNT> {
+            auto out = std::array<gpu::DescriptorSetLayoutBinding, BINDING_COUNT> {};
+            for (auto i = 0u; i < BINDING_COUNT; ++i)
+                out[i] = { .binding          = i,
+                           .type             = gpu::DescriptorType::STORAGE_BUFFER_DYNAMIC,
+                           .stages           = gpu::ShaderStageFlag::COMPUTE,
+                           .descriptor_count = 1 };
+
+            return out;
+        }
+    };
+
     namespace {
         constexpr auto QUAD_SPRITE_SHADER = core::into_bytes({
         // clang-format off
@@ -37,20 +72,224 @@ namespace stormkit::engine::pipeline_2d {
           // clang-format on
         });
 
+        constexpr auto SPRITE_CULL_SHADER = core::into_bytes({
+        // clang-format off
+#embed <sprite_cull.spv>
+          // clang-format on
+        });
+
+        constexpr auto SPRITE_COMPACT_SHADER = core::into_bytes({
+        // clang-format off
+#embed <sprite_compact.spv>
+          // clang-format on
+        });
+
         constexpr auto RENDER_SPRITES_TASK_NAME = "StormKit:2d_pipeline:render_sprites";
         constexpr auto VERTEX_BUFFER_NAME       = "StormKit:2d_pipeline:render_sprites:vertex_buffer";
 
         constexpr auto UPDATE_SPRITES_TASK_NAME    = "StormKit:2d_pipeline:update_sprites_buffer";
         constexpr auto SPRITES_BUFFER_NAME         = "StormKit:2d_pipeline:render_sprites:sprites_buffer";
-        constexpr auto SPRITES_STAGING_BUFFER_NAME = "StormKit:2d_pipeline:update_sprites_buffer:sprites_staging_buffer";
+        constexpr auto SPRITES_STAGING_BUFFER_NAME = "StormKit:2d_pipeline:update_sprites_buffer:sprites_staging_buffer:{}";
+
+        constexpr auto MAX_SPRITE_COUNT    = 131072_usize;
+        constexpr auto SPRITES_BUFFER_SIZE = sizeof(SpriteInstance) * MAX_SPRITE_COUNT;
+        constexpr auto MAX_TEXTURE_COUNT   = 1024_usize;
+        // each texture index may be bound a second time while its previous binding is retired for the frames in flight
+        constexpr auto MAX_TEXTURE_SETS    = 2 * MAX_TEXTURE_COUNT;
+        constexpr auto MAX_MIP_LEVELS      = 16u;
+        // index of the texture descriptor set in the sprite pipeline layout, after the camera and the sprites
+        constexpr auto TEXTURE_DESCRIPTOR_SET = 2u;
 
-        constexpr auto MAX_SPRITE_COUNT    = 128_usize;
-        constexpr auto SPRITES_BUFFER_SIZE = sizeof(SpriteData) * MAX_SPRITE_COUNT;
+        constexpr auto CULL_SPRITES_TASK_NAME         = "StormKit:2d_pipeline:cull_sprites";
+        constexpr auto COMPACT_SPRITES_TASK_NAME      = "StormKit:2d_pipeline:compact_sprites";
+        constexpr auto UPLOAD_CULL_INPUT_TASK_NAME    = "StormKit:2d_pipeline:upload_cull_input";
+        constexpr auto CULL_INPUT_BUFFER_NAME         = "StormKit:2d_pipeline:cull_sprites:input_buffer";
+        constexpr auto CULL_INPUT_STAGING_BUFFER_NAME = "StormKit:2d_pipeline:upload_cull_input:input_staging_buffer";
+        constexpr auto CULL_PREFIXES_BUFFER_NAME      = "StormKit:2d_pipeline:cull_sprites:prefixes_buffer";
+        constexpr auto CULL_CHUNK_COUNTS_BUFFER_NAME  = "StormKit:2d_pipeline:cull_sprites:chunk_counts_buffer";
+        constexpr auto VISIBLE_SPRITES_BUFFER_NAME    = "StormKit:2d_pipeline:compact_sprites:visible_sprites_buffer";
+        constexpr auto DRAW_COMMANDS_BUFFER_NAME      = "StormKit:2d_pipeline:compact_sprites:draw_commands_buffer";
+        constexpr auto CULL_STATS_BUFFER_NAME         = "StormKit:2d_pipeline:compact_sprites:stats_buffer";
+
+        // must match WORKGROUP_SIZE of sprite_cull.wgsl and sprite_compact.wgsl
+        constexpr auto CULL_WORKGROUP_SIZE = 256_usize;
+        constexpr auto MAX_DRAW_COUNT      = 4096_usize;
+        // header of sprite_cull.wgsl CullInput, instance count, batch count and padding
+        constexpr auto CULL_INPUT_HEADER_COUNT = 4_usize;
+
+        /// dynamic offsets are kept aligned on the highest minStorageBufferOffsetAlignment allowed by Vulkan
+        constexpr auto align_region(usize size) noexcept -> usize {
+            return (size + 255_usize) & ~255_usize;
+        }
+
+        constexpr auto CULL_INPUT_BUFFER_SIZE    = align_region(sizeof(u32) * (CULL_INPUT_HEADER_COUNT + MAX_SPRITE_COUNT));
+        constexpr auto PREFIXES_BUFFER_SIZE      = align_region(sizeof(u32) * MAX_SPRITE_COUNT);
+        constexpr auto CHUNK_COUNTS_BUFFER_SIZE  = align_region(sizeof(u32) * MAX_SPRITE_COUNT / CULL_WORKGROUP_SIZE);
+        constexpr auto DRAW_COMMAND_SIZE         = sizeof(u32) * 4;
+        constexpr auto DRAW_COMMANDS_BUFFER_SIZE = align_region(DRAW_COMMAND_SIZE * MAX_DRAW_COUNT);
+        // CullStats of sprite_cull.wgsl, the visible sprite count
+        constexpr auto CULL_STATS_BUFFER_SIZE    = align_region(sizeof(u32));
+
+        constexpr auto STATIC_SPRITE_PIPELINE = u8 { 0 };
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto sort_key(const StaticSpriteComponent& sprite, u16 texture) noexcept -> u64 {
+            if (sprite.translucent) return SortKey::translucent(sprite.layer, STATIC_SPRITE_PIPELINE, texture, sprite.depth);
+
+            return SortKey::opaque(sprite.layer, STATIC_SPRITE_PIPELINE, texture, sprite.depth);
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto interpolate(const math::fvec2& from, const math::fvec2& to, f32 alpha) noexcept -> math::fvec2 {
+            return { std::lerp(from.x, to.x, alpha), std::lerp(from.y, to.y, alpha) };
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto overlaps(const math::fbounding_rect& bounds, const math::fbounding_rect& camera_bounds) noexcept
+          -> bool {
+            return bounds.right >= camera_bounds.left
+                   and bounds.left <= camera_bounds.right
+                   and bounds.bottom >= camera_bounds.top
+                   and bounds.top <= camera_bounds.bottom;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        template<typename T>
+        constexpr auto swap_remove(std::vector<T>& values, usize index) noexcept -> void {
+            values[index] = std::move(values.back());
+            values.pop_back();
+        }
     } // namespace
 
     //////////////////////////////////////
     //////////////////////////////////////
-    auto SpriteRenderSystem::update(entities::EntityManager&, fsecond, const entities::Entities&) noexcept -> void {
+    auto animation_time() noexcept -> f32 {
+        static const auto start = std::chrono::steady_clock::now();
+
+        return std::chrono::duration_cast<fsecond>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteExtractor::extract(entities::EntityManager&          world,
+                                  std::span<const entities::Entity> entities,
+                                  fsecond                           delta,
+                                  SpriteSnapshot&                   out) noexcept -> void {
+        m_current.clear();
+
+        out.sprites.clear();
+        out.sprites.reserve(stdr::size(entities));
+        for (const auto e : entities) {
+            const auto& transform = world.get_component<TransformComponent>(e);
+            const auto  previous  = m_previous.index_of(e);
+
+            auto animated = std::optional<AnimatedSpriteComponent> {};
+            if (m_animated.contains(e)) animated = world.get_component<AnimatedSpriteComponent>(e);
+
+            // a sprite appearing is not interpolated
+            out.sprites.emplace_back(SpriteSnapshot::Sprite {
+              .e         = e,
+              .previous  = previous ? m_previous[*previous] : transform,
+              .transform = transform,
+              .sprite    = world.get_component<StaticSpriteComponent>(e),
+              .animated  = std::move(animated),
+            });
+            m_current.insert(e, transform);
+        }
+
+        std::swap(m_previous, m_current);
+        out.tick  = m_tick++;
+        out.delta = delta;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteExtractor::set_animated(const entities::Entities& entities) noexcept -> void {
+        m_animated.clear();
+        for (const auto e : entities) m_animated.insert(e, {});
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::update(const SpriteSnapshot& snapshot, f32 alpha) noexcept -> void {
+        const auto& sprites = m_sprites.read();
+        EXPECTS(m_transforms.size() == stdr::size(sprites));
+
+        auto changed = false;
+        for (const auto& extracted : snapshot.sprites) {
+            // removed since the snapshot was taken
+            const auto slot = sprites.index_of(extracted.e);
+            if (not slot) continue;
+
+            const auto  i      = *slot;
+            const auto  e      = extracted.e;
+            const auto& sprite = extracted.sprite;
+            const auto& bounds = sprite.texture_bounds;
+
+            const auto  key            = sort_key(sprite, sprites[i].texture);
+            const auto& inverse_extent = m_texture_data.textures[sprites[i].texture].inverse_extent;
+            const auto  uv_rect        = std::array {
+                bounds.left * inverse_extent.x,
+                bounds.top * inverse_extent.y,
+                bounds.right * inverse_extent.x,
+                bounds.bottom * inverse_extent.y,
+            };
+
+            // sampling part of the texture make it an atlas, the next refresh_textures bind its first level only
+            auto& texture = m_texture_data.textures[sprites[i].texture];
+            if (not texture.atlas) {
+                const auto extent = texture.image->extent();
+                if (extracted.animated
+                    or bounds.left != 0.f
+                    or bounds.top != 0.f
+                    or bounds.right != as<f32>(extent.width)
+                    or bounds.bottom != as<f32>(extent.height)) {
+                    texture.atlas = true;
+                    m_texture_data.new_atlases.emplace_back(sprites[i].texture);
+                }
+            }
+
+            auto animation = Animation {};
+            if (extracted.animated) {
+                const auto& animated = *extracted.animated;
+                animation            = Animation {
+                               .frames     = { animated.frame_stride.x * inverse_extent.x,
+                                               animated.frame_stride.y * inverse_extent.y,
+                                               as<f32>(animated.frame_count),
+                                               animated.frame_duration },
+                               .start_time = animated.start_time,
+                };
+            }
+
+            // running animations need no upload, only starting or changing one does
+            if (m_sort_keys[i] != key or m_uv_rects[i] != uv_rect or m_animations[i] != animation) {
+                m_sort_keys[i]  = key;
+                m_uv_rects[i]   = uv_rect;
+                m_animations[i] = animation;
+                changed         = true;
+            }
+
+            // still sprites give the same transform for any alpha, only the moving ones are uploaded again
+            const auto& previous = extracted.previous;
+            const auto& current  = extracted.transform;
+            const auto  extent   = math::fvec2 { bounds.right - bounds.left, bounds.bottom - bounds.top };
+            if (not m_transforms.set(i,
+                                     interpolate(previous.position, current.position, alpha),
+                                     interpolate(previous.scale, current.scale, alpha),
+                                     std::lerp(previous.rotate.x, current.rotate.x, alpha),
+                                     extent))
+                continue;
+
+            // a move keep the submission order, GPU culling only rebuild the instance of the sprite
+            m_grid.update(e, sprite_bounds(m_transforms, i));
+            m_moved_slots.emplace_back(i);
+        }
+
+        if (changed) m_sprites.mark_dirty();
     }
 
     //////////////////////////////////////
@@ -61,51 +300,133 @@ namespace stormkit::engine::pipeline_2d {
                                                  const entities::Entities& entities) noexcept -> void {
         // auto sprites = m_sprites.write();
         if (message.id == entities::EntityManager::ADDED_ENTITY_MESSAGE_ID) {
+            auto added = std::vector<std::pair<entities::Entity, u32>> {};
             for (auto&& e : message.entities) {
-                if (not world.has_component(e, StaticSpriteComponent::type())) continue;
+                if (m_sprites.read().contains(e)
+                    or not world.has_component(e, StaticSpriteComponent::type())
+                    or not world.has_component(e, TransformComponent::type()))
+                    continue;
 
                 const auto& sprite_component = world
                                                  .template get_component<StaticSpriteComponent>(e, StaticSpriteComponent::type());
 
-                dlog("Add sprite from entity: {}.", e);
-                m_sprites.write().emplace_back(Sprite {
-                  .e       = e,
-                  .texture = TryAssert(gpu::ImageView::create(renderer.device(),
-                                                              renderer.resources().get_image(sprite_component.texture_id)),
-                                       std::format("Failed to create image view for entity: {}!", e)),
-                  .sampler = TryAssert(gpu::Sampler::create(renderer.device(), {}),
-                                       std::format("Failed to create sampler for entity: {}!", e)) });
+                // each sprite hold a reference, its texture can't be evicted while it is alive
+                renderer.resources().acquire(sprite_component.texture_id);
+                const auto texture = texture_index(renderer, sprite_component.texture_id);
+                const auto slot    = m_sprites.write().insert(e, Sprite { .e = e, .texture = texture });
+                added.emplace_back(e, slot);
             }
 
+            // the rest of the new slots is filled by the next update
+            const auto count = stdr::size(m_sprites.read());
+            m_transforms.resize(count);
+            m_sort_keys.resize(count);
+            m_uv_rects.resize(count);
+            m_animations.resize(count);
+
+            // in the grid from now on, whether or not the next update see their transform change
+            for (const auto [e, slot] : added) {
+                const auto& transform = world.template get_component<TransformComponent>(e);
+                const auto& bounds    = world.template get_component<StaticSpriteComponent>(e).texture_bounds;
+                m_transforms.set(slot,
+                                 transform.position,
+                                 transform.scale,
+                                 transform.rotate.x,
+                                 { bounds.right - bounds.left, bounds.bottom - bounds.top });
+                m_grid.update(e, sprite_bounds(m_transforms, slot));
+            }
+
+            if (not stdr::empty(added)) dlog("Add {} sprites.", stdr::size(added));
         } else if (message.id == entities::EntityManager::REMOVED_ENTITY_MESSAGE_ID) {
-            auto&& [remove_begin, remove_end] = stdr::remove_if(m_sprites.write(), [&message](const auto& sprite) noexcept {
-                auto removed = stdr::any_of(message.entities, monadic::is_equal(sprite.e));
-                if (removed) dlog("Remove sprite from entity: {}.", sprite.e);
+            // built instances survive a removal as empty quads, no batch may lose its texture binding though
+            auto incremental = not m_sprites.dirty();
+            auto removed     = 0_usize;
+            for (auto&& e : message.entities) {
+                const auto slot = m_sprites.read().index_of(e);
+                if (not slot) continue;
 
-                return removed;
-            });
+                const auto texture = m_sprites.read()[*slot].texture;
+                renderer.resources().release(m_texture_data.textures[texture].id);
+                release_texture_index(texture);
+                if (m_texture_data.textures[texture].references == 0) incremental = false;
+                m_grid.remove(e);
+
+                // the last sprite fill the hole, every other slot keep its index
+                const auto last = as<u32>(m_transforms.size() - 1);
+                m_sprites.write().remove(e);
+                m_transforms.swap_remove(*slot);
+                swap_remove(m_sort_keys, *slot);
+                swap_remove(m_uv_rects, *slot);
+                swap_remove(m_animations, *slot);
+                remove_instance(*slot, last);
+                ++removed;
+            }
 
-            if (remove_begin != stdr::cend(m_sprites.read())) { m_sprites.write().erase(remove_begin, remove_end); }
+            if (removed == 0) return;
+            dlog("Remove {} sprites.", removed);
+
+            // past a quarter of empty quads the instances are compacted again
+            m_statistics.sprites = as<u32>(m_transforms.size());
+            if (incremental and m_hidden_instances * 4 <= m_sprite_data.instance_count) m_sprites.mark_not_dirty();
         }
     }
 
     //////////////////////////////////////
     //////////////////////////////////////
-    auto SpriteRenderSystem::insert_tasks(const Application&        application,
-                                          FrameBuilder&             graph,
-                                          FrameBuilder::ResourceID  backbuffer_id,
-                                          FrameBuilder::ResourceID  camera_buffer_id,
-                                          const gpu::DescriptorSet& camera_descriptor_set,
-                                          u32                       camera_current_offset) noexcept -> void {
+    auto SpriteRenderSystem::insert_tasks(const Application&          application,
+                                          FrameBuilder&               graph,
+                                          FrameBuilder::ResourceID    backbuffer_id,
+                                          FrameBuilder::ResourceID    camera_buffer_id,
+                                          const gpu::DescriptorSet&   camera_descriptor_set,
+                                          u32                         camera_current_offset,
+                                          const math::fbounding_rect& camera_bounds,
+                                          BackgroundDraws             background) noexcept -> void {
+        refresh_textures(application.renderer());
+
         const auto sprites_buffer_id = graph.retain_buffer(SPRITES_BUFFER_NAME, *m_sprite_data.buffer);
 
-        if (m_sprites.dirty()) update_task(application, graph, sprites_buffer_id);
+        if (m_culling_mode == CullingMode::GPU and m_gpu_cull_data.supported and prepare_gpu_culling()) {
+            const auto cull_input_buffer_id = graph.retain_buffer(CULL_INPUT_BUFFER_NAME, *m_gpu_cull_data.input_buffer);
+            update_task(application, graph, sprites_buffer_id);
+            upload_cull_input_task(application, graph, cull_input_buffer_id);
+
+            const auto [visible_sprites_buffer_id, indirect_draws] = cull_task(application,
+                                                                               graph,
+                                                                               sprites_buffer_id,
+                                                                               cull_input_buffer_id,
+                                                                               camera_buffer_id,
+                                                                               camera_descriptor_set,
+                                                                               camera_current_offset);
+            render_static_sprite_task(graph,
+                                      backbuffer_id,
+                                      camera_buffer_id,
+                                      visible_sprites_buffer_id,
+                                      camera_descriptor_set,
+                                      camera_current_offset,
+                                      std::move(background),
+                                      indirect_draws);
+            return;
+        }
+        m_gpu_cull_data.built = false;
+
+        const auto camera_moved = camera_bounds.left != m_camera_bounds.left
+                                  or camera_bounds.top != m_camera_bounds.top
+                                  or camera_bounds.right != m_camera_bounds.right
+                                  or camera_bounds.bottom != m_camera_bounds.bottom;
+        // sprites moving inside the view keep their instance, only their model matrix is uploaded again
+        if (m_sprites.dirty() or camera_moved or visibility_changed()) {
+            cull(camera_bounds);
+            build_instances();
+        } else if (not stdr::empty(m_moved_slots))
+            patch_instances();
+        update_task(application, graph, sprites_buffer_id);
         render_static_sprite_task(graph,
                                   backbuffer_id,
-                                  sprites_buffer_id,
                                   camera_buffer_id,
+                                  sprites_buffer_id,
                                   camera_descriptor_set,
-                                  camera_current_offset);
+                                  camera_current_offset,
+                                  std::move(background));
     }
 
     //////////////////////////////////////
@@ -130,10 +451,19 @@ namespace stormkit::engine::pipeline_2d {
                                             into_dyn_array<gpu::DescriptorSetLayoutBinding>(SpriteData::layout_binding())));
 
         m_static_sprite_data
-          .pipeline_layout = Try(gpu::PipelineLayout::create(device,
-                                                             { .descriptor_set_layouts = to_refs(camera_descriptor_layout,
-                                                                                                 m_static_sprite_data
-                                                                                                   .descriptor_layout) }));
+          .texture_descriptor_layout = Try(gpu::DescriptorSetLayout::
+                                             create(device,
+                                                    into_dyn_array<gpu::DescriptorSetLayoutBinding>(TextureData::layout_bindings())));
+
+        m_static_sprite_data
+          .pipeline_layout = Try(gpu::PipelineLayout::
+                                   create(device,
+                                          { .descriptor_set_layouts = to_refs(camera_descriptor_layout,
+                                                                              m_static_sprite_data.descriptor_layout,
+                                                                              m_static_sprite_data.texture_descriptor_layout),
+                                            .push_constant_ranges   = { { .stages = gpu::ShaderStageFlag::VERTEX,
+                                                                          .offset = 0,
+                                                                          .size   = sizeof(FrameConstants) } } }));
 
         const auto rendering_info = gpu::RasterPipelineRenderingInfo {
             .color_attachment_formats = { gpu::PixelFormat::RGBA8_UNORM }
@@ -145,13 +475,14 @@ namespace stormkit::engine::pipeline_2d {
                                                 m_static_sprite_data.pipeline_layout,
                                                 rendering_info));
 
+        // the second set bind the visible sprites compacted by the GPU culling
         const auto pool_sizes         = to_array<gpu::DescriptorPool::Size>({
           {
-           .type             = gpu::DescriptorType::UNIFORM_BUFFER_DYNAMIC,
-           .descriptor_count = 1,
+           .type             = gpu::DescriptorType::STORAGE_BUFFER_DYNAMIC,
+           .descriptor_count = 2,
            },
         });
-        m_sprite_data.descriptor_pool = Try(gpu::DescriptorPool::create(device, pool_sizes, 1));
+        m_sprite_data.descriptor_pool = Try(gpu::DescriptorPool::create(device, pool_sizes, 2));
 
         m_static_sprite_data
           .descriptor_set = Try(m_sprite_data.descriptor_pool->create_descriptor_set(m_static_sprite_data.descriptor_layout));
@@ -159,12 +490,12 @@ namespace stormkit::engine::pipeline_2d {
         m_sprite_data
           .buffer       = Try(gpu::Buffer::create(device,
                                                   {
-                                                    .usages   = gpu::BufferUsageFlag::UNIFORM | gpu::BufferUsageFlag::TRANSFER_DST,
+                                                    .usages   = gpu::BufferUsageFlag::STORAGE | gpu::BufferUsageFlag::TRANSFER_DST,
                                                     .size     = SPRITES_BUFFER_SIZE * renderer.buffering_count(),
                                                     .property = gpu::MemoryPropertyFlag::DEVICE_LOCAL,
                                                   }));
         const auto sets = into_dyn_array<gpu::Descriptor>(gpu::BufferDescriptor {
-          .type    = gpu::DescriptorType::UNIFORM_BUFFER_DYNAMIC,
+          .type    = gpu::DescriptorType::STORAGE_BUFFER_DYNAMIC,
           .binding = 0,
           .buffer  = as_ref(m_sprite_data.buffer),
           .range   = SPRITES_BUFFER_SIZE,
@@ -173,72 +504,705 @@ namespace stormkit::engine::pipeline_2d {
 
         m_static_sprite_data.descriptor_set->update(sets);
 
+        const auto texture_pool_sizes = to_array<gpu::DescriptorPool::Size>({
+          {
+           .type             = gpu::DescriptorType::SAMPLED_IMAGE,
+           .descriptor_count = as<u32>(MAX_TEXTURE_SETS),
+           },
+          {
+           .type             = gpu::DescriptorType::SAMPLER,
+           .descriptor_count = as<u32>(MAX_TEXTURE_SETS),
+           },
+        });
+        m_texture_data.descriptor_pool = Try(gpu::DescriptorPool::create(device, texture_pool_sizes, as<u32>(MAX_TEXTURE_SETS)));
+        m_texture_data.sampler         = Try(gpu::Sampler::create(device,
+                                                          { .mipmap_mode = gpu::SamplerMipmapMode::LINEAR,
+                                                            .max_lod     = as<f32>(MAX_MIP_LEVELS) }));
+
+        Try(do_init_gpu_culling(renderer, camera_descriptor_layout));
+
+        Return {};
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::do_init_gpu_culling(const Renderer&                 renderer,
+                                                 const gpu::DescriptorSetLayout& camera_descriptor_layout) noexcept
+      -> gpu::Expected<void> {
+        const auto& device          = renderer.device();
+        const auto  buffering_count = renderer.buffering_count();
+
+        // the compacted batches start at a non zero instance, their indirect draws need drawIndirectFirstInstance
+        m_gpu_cull_data.supported = device.physical_device().capabilities().features.draw_indirect_first_instance;
+        if (not m_gpu_cull_data.supported) {
+            ilog("drawIndirectFirstInstance is not supported, sprites will always be culled on the CPU.");
+            Return {};
+        }
+
+        m_gpu_cull_data
+          .cull_shader = Try(gpu::Shader::load_from_bytes(device, SPRITE_CULL_SHADER, gpu::ShaderStageFlag::COMPUTE));
+        m_gpu_cull_data
+          .compact_shader = Try(gpu::Shader::load_from_bytes(device, SPRITE_COMPACT_SHADER, gpu::ShaderStageFlag::COMPUTE));
+
+        m_gpu_cull_data
+          .descriptor_layout = Try(gpu::DescriptorSetLayout::
+                                     create(device, into_dyn_array<gpu::DescriptorSetLayoutBinding>(CullData::layout_bindings())));
+
+        m_gpu_cull_data
+          .pipeline_layout = Try(gpu::PipelineLayout::create(device,
+                                                             { .descriptor_set_layouts = to_refs(camera_descriptor_layout,
+                                                                                                 m_gpu_cull_data
+                                                                                                   .descriptor_layout) }));
+
+        m_gpu_cull_data.cull_pipeline    = Try(gpu::Pipeline::create(device,
+                                                                   gpu::ComputePipelineState {
+                                                                     .shader_state = as_ref(m_gpu_cull_data.cull_shader) },
+                                                                   m_gpu_cull_data.pipeline_layout));
+        m_gpu_cull_data.compact_pipeline = Try(gpu::Pipeline::create(device,
+                                                                     gpu::ComputePipelineState {
+                                                                       .shader_state = as_ref(m_gpu_cull_data
+                                                                                                .compact_shader) },
+                                                                     m_gpu_cull_data.pipeline_layout));
+
+        const auto create_buffer = [&device, buffering_count](gpu::BufferUsageFlag usages, usize size) noexcept {
+            return gpu::Buffer::create(device,
+                                       {
+                                         .usages   = usages,
+                                         .size     = size * buffering_count,
+                                         .property = gpu::MemoryPropertyFlag::DEVICE_LOCAL,
+                                       });
+        };
+
+        m_gpu_cull_data.input_buffer        = Try(create_buffer(gpu::BufferUsageFlag::STORAGE | gpu::BufferUsageFlag::TRANSFER_DST,
+                                                         CULL_INPUT_BUFFER_SIZE));
+        m_gpu_cull_data.prefixes_buffer     = Try(create_buffer(gpu::BufferUsageFlag::STORAGE, PREFIXES_BUFFER_SIZE));
+        m_gpu_cull_data.chunk_counts_buffer = Try(create_buffer(gpu::BufferUsageFlag::STORAGE, CHUNK_COUNTS_BUFFER_SIZE));
+        m_gpu_cull_data.visible_buffer      = Try(create_buffer(gpu::BufferUsageFlag::STORAGE, SPRITES_BUFFER_SIZE));
+        m_gpu_cull_data.commands_buffer     = Try(create_buffer(gpu::BufferUsageFlag::STORAGE | gpu::BufferUsageFlag::INDIRECT,
+                                                            DRAW_COMMANDS_BUFFER_SIZE));
+        m_gpu_cull_data.stats_buffer        = Try(gpu::Buffer::create(device,
+                                                               {
+                                                                 .usages   = gpu::BufferUsageFlag::STORAGE,
+                                                                 .size     = CULL_STATS_BUFFER_SIZE * buffering_count,
+                                                                 .property = gpu::MemoryPropertyFlag::HOST_VISIBLE
+                                                                             | gpu::MemoryPropertyFlag::HOST_COHERENT,
+                                                               }));
+        m_gpu_cull_data.stats_instances.assign(buffering_count, std::nullopt);
+
+        const auto pool_sizes          = to_array<gpu::DescriptorPool::Size>({
+          {
+           .type             = gpu::DescriptorType::STORAGE_BUFFER_DYNAMIC,
+           .descriptor_count = CullData::BINDING_COUNT,
+           },
+        });
+        m_gpu_cull_data.descriptor_pool = Try(gpu::DescriptorPool::create(device, pool_sizes, 1));
+        m_gpu_cull_data
+          .descriptor_set = Try(m_gpu_cull_data.descriptor_pool->create_descriptor_set(m_gpu_cull_data.descriptor_layout));
+
+        const auto descriptor = [](u32 binding, const gpu::Buffer& buffer, usize range) static noexcept {
+            return gpu::BufferDescriptor {
+                .type    = gpu::DescriptorType::STORAGE_BUFFER_DYNAMIC,
+                .binding = binding,
+                .buffer  = as_ref(buffer),
+                .range   = range,
+                .offset  = 0,
+            };
+        };
+
+        m_gpu_cull_data.descriptor_set->update(into_dyn_array<gpu::Descriptor>(
+          descriptor(0, *m_sprite_data.buffer, SPRITES_BUFFER_SIZE),
+          descriptor(1, *m_gpu_cull_data.input_buffer, CULL_INPUT_BUFFER_SIZE),
+          descriptor(2, *m_gpu_cull_data.prefixes_buffer, PREFIXES_BUFFER_SIZE),
+          descriptor(3, *m_gpu_cull_data.chunk_counts_buffer, CHUNK_COUNTS_BUFFER_SIZE),
+          descriptor(4, *m_gpu_cull_data.visible_buffer, SPRITES_BUFFER_SIZE),
+          descriptor(5, *m_gpu_cull_data.commands_buffer, DRAW_COMMANDS_BUFFER_SIZE),
+          descriptor(6, *m_gpu_cull_data.stats_buffer, CULL_STATS_BUFFER_SIZE)));
+
+        m_gpu_cull_data
+          .render_descriptor_set = Try(m_sprite_data.descriptor_pool->create_descriptor_set(m_static_sprite_data
+                                                                                             .descriptor_layout));
+        m_gpu_cull_data.render_descriptor_set->update(into_dyn_array<gpu::Descriptor>(
+          descriptor(0, *m_gpu_cull_data.visible_buffer, SPRITES_BUFFER_SIZE)));
+
         Return {};
     }
 
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::build_instances() noexcept -> void {
+        m_sprites.mark_not_dirty();
+        m_moved_slots.clear();
+        m_hidden_instances = 0;
+
+        // model matrices are built here on the main thread, the transfer tasks only copy them
+        const auto instance_count = std::min(m_visible_transforms.size(), MAX_SPRITE_COUNT);
+        auto&      instances      = m_instances.write();
+        instances.resize(m_visible_transforms.size());
+        compute_sprite_instances(m_visible_transforms, instances);
+        instances.resize(instance_count);
+        for (auto i = 0_usize; i < instance_count; ++i) {
+            const auto  slot      = m_visible_slots[i];
+            const auto& animation = m_animations[slot];
+
+            instances[i].uv_rect            = m_uv_rects[slot];
+            instances[i].animation          = animation.frames;
+            instances[i].animation_start[0] = animation.start_time;
+        }
+
+        m_sprite_data.instance_count = as<u32>(instance_count);
+
+        m_instance_of_slot.assign(m_transforms.size(), NO_INSTANCE);
+        for (auto i = 0_usize; i < instance_count; ++i) m_instance_of_slot[m_visible_slots[i]] = as<u32>(i);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::patch_instances() noexcept -> void {
+        // the submission order hold, each moved sprite keep its instance and only its model matrix change
+        stdr::sort(m_moved_slots);
+        const auto [last, end] = stdr::unique(m_moved_slots);
+        m_moved_slots.erase(last, end);
+
+        auto moved = SpriteTransforms {};
+        moved.gather(m_transforms, m_moved_slots);
+
+        auto models = std::vector<SpriteInstance>(moved.size());
+        compute_sprite_instances(moved, models);
+        for (auto i = 0_usize; i < stdr::size(m_moved_slots); ++i) {
+            const auto slot = m_moved_slots[i];
+            if (slot >= stdr::size(m_instance_of_slot) or m_instance_of_slot[slot] == NO_INSTANCE) continue;
+
+            auto& instance  = m_instances.write(m_instance_of_slot[slot]);
+            instance.basis  = models[i].basis;
+            instance.origin = models[i].origin;
+        }
+
+        m_moved_slots.clear();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::visibility_changed() const noexcept -> bool {
+        // past MAX_SPRITE_COUNT visible sprites have no instance, the view is culled again to pick the ones drawn
+        if (m_visible_transforms.size() > m_sprite_data.instance_count) return not stdr::empty(m_moved_slots);
+
+        return stdr::any_of(m_moved_slots, [this](auto slot) noexcept {
+            const auto drawn = slot < stdr::size(m_instance_of_slot) and m_instance_of_slot[slot] != NO_INSTANCE;
+            return drawn != overlaps(sprite_bounds(m_transforms, slot), m_camera_bounds);
+        });
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::remove_instance(u32 slot, u32 last) noexcept -> void {
+        // a zero basis collapse the quad, its instance stay in its batch until the next rebuild
+        if (slot < stdr::size(m_instance_of_slot) and m_instance_of_slot[slot] != NO_INSTANCE) {
+            auto& instance  = m_instances.write(m_instance_of_slot[slot]);
+            instance.basis  = {};
+            instance.origin = {};
+            ++m_hidden_instances;
+        }
+
+        // the sprite moved from last keep its instance under its new slot
+        if (last + 1 == stdr::size(m_instance_of_slot)) {
+            m_instance_of_slot[slot] = m_instance_of_slot[last];
+            m_instance_of_slot.pop_back();
+        }
+
+        std::erase(m_moved_slots, slot);
+        stdr::replace(m_moved_slots, last, slot);
+    }
+
     //////////////////////////////////////
     //////////////////////////////////////
     auto SpriteRenderSystem::update_task(const Application&       application,
                                          FrameBuilder&            graph,
                                          FrameBuilder::ResourceID sprites_buffer_id) noexcept -> void {
-        dlog("sprites dirty!");
-        m_sprites.mark_not_dirty();
+        const auto frame = application.renderer().current_frame();
 
-        const auto& renderer = application.renderer();
+        m_sprite_data.current_offset = as<u32>(frame * SPRITES_BUFFER_SIZE);
+
+        // only the ranges changed since this frame region was last written are uploaded, each in its own copy
+        const auto ranges = m_instances.changes(frame);
+        m_instances.mark_synced(frame);
+        if (stdr::empty(ranges)) return;
+
+        static constexpr auto MAX_UPLOADS = decltype(m_instances)::MAX_RANGES;
+
+        struct Upload {
+            std::vector<SpriteInstance> instances;
+            usize                       offset;
+        };
+
+        auto uploads = std::vector<Upload> {};
+        uploads.reserve(stdr::size(ranges));
+        for (const auto& range : ranges) {
+            const auto first = stdr::begin(m_instances.read()) + range.first;
+            uploads.emplace_back(std::vector<SpriteInstance> { first, first + range.count },
+                                 m_sprite_data.current_offset + sizeof(SpriteInstance) * range.first);
+        }
+        const auto upload_count = stdr::size(uploads);
+        EXPECTS(upload_count <= MAX_UPLOADS);
 
         struct UpdateStaticSpriteTaskData {
-            FrameBuilder::ResourceID sprites_staging_buffer_id = {};
-            FrameBuilder::ResourceID sprites_buffer_id         = {};
+            std::array<FrameBuilder::ResourceID, MAX_UPLOADS> sprites_staging_buffer_ids = {};
+            FrameBuilder::ResourceID                          sprites_buffer_id          = {};
         };
 
         graph.add_transfer_task<UpdateStaticSpriteTaskData>(
           UPDATE_SPRITES_TASK_NAME,
           [&](auto& builder, auto& data) noexcept {
-              data.sprites_staging_buffer_id = builder.create_buffer(SPRITES_STAGING_BUFFER_NAME,
-                                                                     {
-                                                                       .usages = gpu::BufferUsageFlag::TRANSFER_SRC,
-                                                                       .size   = SPRITES_BUFFER_SIZE,
-                                                                     });
-              data.sprites_buffer_id         = sprites_buffer_id;
+              data.sprites_buffer_id = sprites_buffer_id;
+              builder.write_buffer(data.sprites_buffer_id);
+
+              for (auto i = 0_usize; i < upload_count; ++i) {
+                  data.sprites_staging_buffer_ids[i] = builder
+                                                         .create_buffer(std::format(SPRITES_STAGING_BUFFER_NAME, i),
+                                                                        {
+                                                                          .usages = gpu::BufferUsageFlag::TRANSFER_SRC,
+                                                                          .size   = sizeof(SpriteInstance)
+                                                                                  * stdr::size(uploads[i].instances),
+                                                                        });
+                  builder.write_buffer(data.sprites_staging_buffer_ids[i]);
+              }
+          },
+          [uploads = std::move(uploads)](auto& frame_resources, auto& cmb, const auto& data) noexcept {
+              const auto& sprites_buffer = frame_resources.get_buffer(data.sprites_buffer_id);
 
-              m_sprite_data.current_offset = (renderer.current_frame() * SPRITES_BUFFER_SIZE) % renderer.buffering_count();
+              for (auto i = 0_usize; i < stdr::size(uploads); ++i) {
+                  const auto& [instances, offset] = uploads[i];
+                  auto& sprites_staging_buffer    = frame_resources.get_buffer(data.sprites_staging_buffer_ids[i]);
 
-              builder.write_buffer(data.sprites_buffer_id);
-              builder.write_buffer(data.sprites_staging_buffer_id);
+                  sprites_staging_buffer.upload(as_bytes(instances));
+
+                  cmb.copy_buffer(sprites_staging_buffer, sprites_buffer, sizeof(SpriteInstance) * stdr::size(instances), offset);
+              }
+          });
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::cull(const math::fbounding_rect& camera_bounds) noexcept -> void {
+        m_camera_bounds = camera_bounds;
+
+        m_visible_entities.clear();
+        m_grid.query(camera_bounds, m_visible_entities);
+
+        m_visible_slots.clear();
+        m_visible_slots.reserve(stdr::size(m_visible_entities));
+        for (const auto e : m_visible_entities) {
+            const auto slot = m_sprites.read().index_of(e);
+            if (not slot) continue;
+
+            // grid cells are coarse, reject what only share a cell with the camera
+            if (not overlaps(sprite_bounds(m_transforms, *slot), camera_bounds)) continue;
+
+            m_visible_slots.emplace_back(*slot);
+        }
+
+        sort_visible();
+
+        m_statistics.sprites = as<u32>(m_transforms.size());
+        m_statistics.visible = as<u32>(stdr::size(m_visible_slots));
+        m_statistics.culled  = m_statistics.sprites - m_statistics.visible;
+        m_statistics.batches = as<u32>(stdr::size(m_batches));
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::sort_visible() noexcept -> void {
+        // ties keep the slot order as the radix sort is stable, so submission is stable across frames
+        stdr::sort(m_visible_slots);
+
+        m_render_queue.clear();
+        m_render_queue.reserve(stdr::size(m_visible_slots));
+        for (const auto slot : m_visible_slots) m_render_queue.push(m_sort_keys[slot], slot);
+        m_render_queue.sort();
+
+        m_visible_slots.clear();
+        for (const auto& packet : m_render_queue.packets()) m_visible_slots.emplace_back(packet.payload);
+        m_batches = m_render_queue.batches();
+
+        m_visible_transforms.gather(m_transforms, m_visible_slots);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::prepare_gpu_culling() noexcept -> bool {
+        if (m_gpu_cull_data.built and not m_sprites.dirty()) {
+            if (not stdr::empty(m_moved_slots)) patch_instances();
+            return true;
+        }
+
+        // every sprite is uploaded in submission order, the compute tasks do the culling
+        m_visible_slots.resize(m_transforms.size());
+        std::iota(stdr::begin(m_visible_slots), stdr::end(m_visible_slots), 0u);
+        sort_visible();
+
+        // visible and culled come from the read back of the compute tasks
+        m_statistics.sprites = as<u32>(m_transforms.size());
+        m_statistics.batches = as<u32>(stdr::size(m_batches));
+
+        if (stdr::size(m_batches) > MAX_DRAW_COUNT) {
+            dlog("{} sprite batches exceed the {} GPU culling indirect draws, fallback to CPU culling.",
+                 stdr::size(m_batches),
+                 MAX_DRAW_COUNT);
+            return false;
+        }
+
+        build_instances();
+        build_cull_input();
+        m_gpu_cull_data.built = true;
+
+        return true;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::build_cull_input() noexcept -> void {
+        const auto instance_count = m_sprite_data.instance_count;
+
+        // CullInput of sprite_cull.wgsl, the header followed by the batch of each instance
+        auto& input = m_gpu_cull_data.input.write();
+        input.assign(CULL_INPUT_HEADER_COUNT + instance_count, 0u);
+        input[0] = instance_count;
+        input[1] = as<u32>(stdr::size(m_batches));
+        for (auto batch = 0u; batch < stdr::size(m_batches); ++batch) {
+            const auto first = m_batches[batch].first;
+            const auto end   = std::min(first + m_batches[batch].count, instance_count);
+            for (auto i = first; i < end; ++i) input[CULL_INPUT_HEADER_COUNT + i] = batch;
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::upload_cull_input_task(const Application&       application,
+                                                    FrameBuilder&            graph,
+                                                    FrameBuilder::ResourceID cull_input_buffer_id) noexcept -> void {
+        const auto frame = application.renderer().current_frame();
+
+        m_gpu_cull_data.input_offset = as<u32>(frame * CULL_INPUT_BUFFER_SIZE);
+
+        // the batches only change with the submission order, moving sprites keep the uploaded input
+        if (not m_gpu_cull_data.input.dirty(frame)) return;
+        m_gpu_cull_data.input.mark_synced(frame);
+
+        if (m_sprite_data.instance_count == 0) return;
+
+        auto       input       = m_gpu_cull_data.input.read();
+        const auto upload_size = sizeof(u32) * stdr::size(input);
+
+        struct UploadCullInputTaskData {
+            FrameBuilder::ResourceID input_staging_buffer_id = {};
+            FrameBuilder::ResourceID input_buffer_id         = {};
+        };
+
+        graph.add_transfer_task<UploadCullInputTaskData>(
+          UPLOAD_CULL_INPUT_TASK_NAME,
+          [&](auto& builder, auto& data) noexcept {
+              data.input_staging_buffer_id = builder.create_buffer(CULL_INPUT_STAGING_BUFFER_NAME,
+                                                                   {
+                                                                     .usages = gpu::BufferUsageFlag::TRANSFER_SRC,
+                                                                     .size   = upload_size,
+                                                                   });
+              data.input_buffer_id         = cull_input_buffer_id;
+
+              builder.write_buffer(data.input_buffer_id);
+              builder.write_buffer(data.input_staging_buffer_id);
           },
-          [this,
-           &application,
-           &renderer,
-           offset = m_sprite_data.current_offset](auto& frame_resources, auto& cmb, const auto& data) noexcept {
-              auto&       sprites_staging_buffer = frame_resources.get_buffer(data.sprites_staging_buffer_id);
-              const auto& sprites_buffer         = frame_resources.get_buffer(data.sprites_buffer_id);
-
-              const auto& read        = m_sprites.read();
-              const auto  sprite_data = read
-                                        | stdv::transform([](const auto& pair) static noexcept { return pair.e; })
-                                        | stdv::transform([this, &application](auto e) noexcept {
-                                             auto        world    = application.world().read();
-                                             const auto& position = world->get_component<pipeline_2d::TransformComponent>(e)
-                                                                      .position;
-                                             const auto& sprite   = world->get_component<pipeline_2d::StaticSpriteComponent>(e);
-                                             world.lock.unlock();
-
-                                             const auto width  = sprite.texture_bounds.right - sprite.texture_bounds.left;
-                                             const auto height = sprite.texture_bounds.bottom - sprite.texture_bounds.top;
-
-                                             auto transform = math::fmat4::identity();
-                                             transform      = math::scale(transform, { width, height, 1.f });
-                                             transform = math::translate(transform, math::fvec3 { position.x, position.y, 0.f });
-
-                                             return math::transpose(transform);
-                                          })
-                                        | stdr::to<std::vector>();
-              sprites_staging_buffer.upload(as_bytes(sprite_data));
-
-              cmb.copy_buffer(sprites_staging_buffer, sprites_buffer, SPRITES_BUFFER_SIZE, offset);
+          [input = std::move(input),
+           upload_size,
+           offset = m_gpu_cull_data.input_offset](auto& frame_resources, auto& cmb, const auto& data) noexcept {
+              auto&       input_staging_buffer = frame_resources.get_buffer(data.input_staging_buffer_id);
+              const auto& input_buffer         = frame_resources.get_buffer(data.input_buffer_id);
+
+              input_staging_buffer.upload(as_bytes(input));
+
+              cmb.copy_buffer(input_staging_buffer, input_buffer, upload_size, offset);
           });
     }
 
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::cull_task(const Application&        application,
+                                       FrameBuilder&             graph,
+                                       FrameBuilder::ResourceID  sprites_buffer_id,
+                                       FrameBuilder::ResourceID  input_buffer_id,
+                                       FrameBuilder::ResourceID  camera_buffer_id,
+                                       const gpu::DescriptorSet& camera_descriptor_set,
+                                       u32                       camera_current_offset) noexcept
+      -> std::pair<FrameBuilder::ResourceID, IndirectDraws> {
+        const auto& renderer = application.renderer();
+        const auto  frame    = renderer.current_frame() % renderer.buffering_count();
+
+        const auto prefixes_buffer_id     = graph.retain_buffer(CULL_PREFIXES_BUFFER_NAME, *m_gpu_cull_data.prefixes_buffer);
+        const auto chunk_counts_buffer_id = graph.retain_buffer(CULL_CHUNK_COUNTS_BUFFER_NAME,
+                                                                *m_gpu_cull_data.chunk_counts_buffer);
+        const auto visible_buffer_id      = graph.retain_buffer(VISIBLE_SPRITES_BUFFER_NAME, *m_gpu_cull_data.visible_buffer);
+        const auto commands_buffer_id     = graph.retain_buffer(DRAW_COMMANDS_BUFFER_NAME, *m_gpu_cull_data.commands_buffer);
+        const auto stats_buffer_id        = graph.retain_buffer(CULL_STATS_BUFFER_NAME, *m_gpu_cull_data.stats_buffer);
+
+        read_back_statistics(frame);
+
+        const auto indirect_draws = IndirectDraws {
+            .commands_buffer_id = commands_buffer_id,
+            .commands_offset    = as<u32>(frame * DRAW_COMMANDS_BUFFER_SIZE),
+            .sprites_offset     = as<u32>(frame * SPRITES_BUFFER_SIZE),
+        };
+
+        const auto group_count = as<u32>((m_sprite_data.instance_count + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE);
+        if (group_count == 0) return { visible_buffer_id, indirect_draws };
+
+        m_gpu_cull_data.stats_instances[frame] = m_sprite_data.instance_count;
+
+        const auto offsets = to_array<u32>({
+          camera_current_offset,
+          m_sprite_data.current_offset,
+          m_gpu_cull_data.input_offset,
+          as<u32>(frame * PREFIXES_BUFFER_SIZE),
+          as<u32>(frame * CHUNK_COUNTS_BUFFER_SIZE),
+          indirect_draws.sprites_offset,
+          indirect_draws.commands_offset,
+          as<u32>(frame * CULL_STATS_BUFFER_SIZE),
+        });
+
+        struct CullSpritesTaskData {
+            FrameBuilder::ResourceID camera_buffer_id       = {};
+            FrameBuilder::ResourceID sprites_buffer_id      = {};
+            FrameBuilder::ResourceID input_buffer_id        = {};
+            FrameBuilder::ResourceID prefixes_buffer_id     = {};
+            FrameBuilder::ResourceID chunk_counts_buffer_id = {};
+            FrameBuilder::ResourceID visible_buffer_id      = {};
+            FrameBuilder::ResourceID commands_buffer_id     = {};
+            FrameBuilder::ResourceID stats_buffer_id        = {};
+        };
+
+        const auto setup = [&](auto& data) noexcept {
+            data.camera_buffer_id       = camera_buffer_id;
+            data.sprites_buffer_id      = sprites_buffer_id;
+            data.input_buffer_id        = input_buffer_id;
+            data.prefixes_buffer_id     = prefixes_buffer_id;
+            data.chunk_counts_buffer_id = chunk_counts_buffer_id;
+            data.visible_buffer_id      = visible_buffer_id;
+            data.commands_buffer_id     = commands_buffer_id;
+            data.stats_buffer_id        = stats_buffer_id;
+        };
+
+        const auto dispatch = [&camera_descriptor_set, offsets, group_count, this](const gpu::Pipeline& pipeline,
+                                                                                   gpu::CommandBuffer&  cmb) noexcept {
+            cmb.bind_pipeline(pipeline)
+              .bind_descriptor_sets(pipeline,
+                                    m_gpu_cull_data.pipeline_layout,
+                                    as_refs(camera_descriptor_set, m_gpu_cull_data.descriptor_set),
+                                    offsets);
+            cmb.dispatch(group_count, 1, 1);
+        };
+
+        // flag visible sprites, prefix sum them per workgroup and reset the draw commands
+        graph.add_compute_task<CullSpritesTaskData>(
+          CULL_SPRITES_TASK_NAME,
+          [&](auto& builder, auto& data) noexcept {
+              setup(data);
+
+              builder.read_buffer(data.camera_buffer_id);
+              builder.read_buffer(data.sprites_buffer_id);
+              builder.read_buffer(data.input_buffer_id);
+              builder.write_buffer(data.prefixes_buffer_id);
+              builder.write_buffer(data.chunk_counts_buffer_id);
+              builder.write_buffer(data.commands_buffer_id);
+              builder.write_buffer(data.stats_buffer_id);
+          },
+          [dispatch, this](auto&, auto& cmb, const auto&) noexcept { dispatch(m_gpu_cull_data.cull_pipeline, cmb); });
+
+        // scatter visible sprites in submission order and fill the draw commands
+        graph.add_compute_task<CullSpritesTaskData>(
+          COMPACT_SPRITES_TASK_NAME,
+          [&](auto& builder, auto& data) noexcept {
+              setup(data);
+
+              builder.read_buffer(data.sprites_buffer_id);
+              builder.read_buffer(data.input_buffer_id);
+              builder.read_buffer(data.prefixes_buffer_id);
+              builder.read_buffer(data.chunk_counts_buffer_id);
+              builder.write_buffer(data.visible_buffer_id);
+              builder.write_buffer(data.commands_buffer_id);
+              builder.write_buffer(data.stats_buffer_id);
+          },
+          [dispatch, this](auto&, auto& cmb, const auto&) noexcept { dispatch(m_gpu_cull_data.compact_pipeline, cmb); });
+
+        return { visible_buffer_id, indirect_draws };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::read_back_statistics(u32 frame) noexcept -> void {
+        // the frame which used this region last is at least buffering_count() frames old
+        const auto instances = std::exchange(m_gpu_cull_data.stats_instances[frame], std::nullopt);
+        if (not instances) return;
+
+        auto&       buffer  = *m_gpu_cull_data.stats_buffer;
+        const auto  bytes   = buffer.map(frame * CULL_STATS_BUFFER_SIZE, sizeof(u32));
+        auto        visible = 0u;
+        std::memcpy(&visible, stdr::data(bytes), sizeof(u32));
+        buffer.unmap();
+
+        m_statistics.visible = std::min(visible, *instances);
+        m_statistics.culled  = *instances - m_statistics.visible;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::texture_index(const Renderer& renderer, TextureID id) noexcept -> u16 {
+        if (auto it = m_texture_data.indices.find(id); it != stdr::cend(m_texture_data.indices)) {
+            m_texture_data.textures[it->second].references += 1;
+            return it->second;
+        }
+
+        const auto& image  = renderer.resources().get_image(id);
+        const auto  extent = image.extent();
+
+        auto [view, descriptor_set] = bind_texture(renderer, id, image, false);
+
+        auto texture = Texture {
+            .id             = id,
+            .image          = as_ref(image),
+            .view           = std::move(view),
+            .descriptor_set = std::move(descriptor_set),
+            .inverse_extent = { 1.f / as<f32>(extent.width), 1.f / as<f32>(extent.height) },
+            .references     = 1,
+        };
+
+        auto index = u16 { 0 };
+        if (not stdr::empty(m_texture_data.free_indices)) {
+            index = m_texture_data.free_indices.back();
+            m_texture_data.free_indices.pop_back();
+            m_texture_data.textures[index] = std::move(texture);
+        } else {
+            EXPECTS(stdr::size(m_texture_data.textures) < MAX_TEXTURE_COUNT);
+
+            index = as<u16>(stdr::size(m_texture_data.textures));
+            m_texture_data.textures.emplace_back(std::move(texture));
+        }
+        m_texture_data.indices.emplace(id, index);
+
+        dlog("Register sprite texture {} at index {}.", id, index);
+
+        return index;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::release_texture_index(u16 index) noexcept -> void {
+        auto& texture = m_texture_data.textures[index];
+        EXPECTS(texture.references > 0);
+
+        texture.references -= 1;
+        if (texture.references > 0) return;
+
+        // the render tasks in flight may still bind it, the index is free right away as no sprite use it anymore
+        m_texture_data.retired.emplace_back(std::move(texture.view),
+                                            std::move(texture.descriptor_set),
+                                            m_texture_data.frame);
+        m_texture_data.indices.erase(texture.id);
+        m_texture_data.free_indices.emplace_back(index);
+
+        dlog("Unregister sprite texture {} from index {}.", texture.id, index);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::refresh_textures(const Renderer& renderer) noexcept -> void {
+        const auto& resources = renderer.resources();
+
+        m_texture_data.frame += 1;
+        release_texture_bindings(renderer.buffering_count());
+
+        // the index may have been recycled since, for a texture not known as an atlas yet
+        for (const auto index : std::exchange(m_texture_data.new_atlases, {})) {
+            const auto& texture = m_texture_data.textures[index];
+            if (texture.references == 0 or not texture.atlas) continue;
+
+            rebind_texture(renderer, index, *texture.image);
+            dlog("Sprite texture {} is an atlas, bound on its first level.", texture.id);
+        }
+
+        const auto revision = resources.revision();
+        if (revision == m_texture_data.revision) return;
+        m_texture_data.revision = revision;
+
+        // the texture index stored in the sprites stay valid, only the binding behind it is replaced
+        for (auto index = 0_usize; index < stdr::size(m_texture_data.textures); ++index) {
+            auto& texture = m_texture_data.textures[index];
+            if (texture.references == 0) continue;
+
+            const auto& image = resources.get_image(texture.id);
+            if (&image == &*texture.image) continue;
+
+            // the placeholder said nothing about the sprites rects, the next update tell again if it is an atlas
+            texture.atlas = false;
+            rebind_texture(renderer, as<u16>(index), image);
+
+            dlog("Sprite texture {} loaded, rebound.", texture.id);
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::rebind_texture(const Renderer& renderer, u16 index, const gpu::Image& image) noexcept -> void {
+        auto& texture = m_texture_data.textures[index];
+
+        auto [view, descriptor_set] = bind_texture(renderer, texture.id, image, texture.atlas);
+        m_texture_data.retired.emplace_back(std::move(texture.view), std::move(texture.descriptor_set), m_texture_data.frame);
+
+        const auto extent      = image.extent();
+        texture.image          = as_ref(image);
+        texture.view           = std::move(view);
+        texture.descriptor_set = std::move(descriptor_set);
+        texture.inverse_extent = { 1.f / as<f32>(extent.width), 1.f / as<f32>(extent.height) };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::release_texture_bindings(usize buffering_count) noexcept -> void {
+        // destroying the descriptor set give it back to m_texture_data.descriptor_pool
+        while (not stdr::empty(m_texture_data.retired)
+               and m_texture_data.retired.front().frame + buffering_count <= m_texture_data.frame)
+            m_texture_data.retired.pop_front();
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteRenderSystem::bind_texture(const Renderer& renderer, TextureID id, const gpu::Image& image, bool atlas) noexcept
+      -> std::pair<Heap<gpu::ImageView>, Heap<gpu::DescriptorSet>> {
+        // minified sprites sample the smaller levels, but those of an atlas mix its frames, as for the tilemaps
+        auto view = TryAssert(gpu::ImageView::allocate(renderer.device(),
+                                                       image,
+                                                       gpu::ImageViewType::T2D,
+                                                       { .level_count = atlas ? 1u : image.mip_levels() }),
+                              std::format("Failed to create image view for texture: {}!", id));
+        auto descriptor_set = core::allocate_unsafe<gpu::DescriptorSet>(
+          TryAssert(m_texture_data.descriptor_pool->create_descriptor_set(m_static_sprite_data.texture_descriptor_layout),
+                    std::format("Failed to create descriptor set for texture: {}!", id)));
+
+        const auto sets = into_dyn_array<gpu::Descriptor>(gpu::ImageDescriptor {
+                                                            .type       = gpu::DescriptorType::SAMPLED_IMAGE,
+                                                            .binding    = 0,
+                                                            .layout     = gpu::ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+                                                            .image_view = as_ref(*view),
+                                                            .sampler    = as_ref(m_texture_data.sampler),
+                                                          },
+                                                          gpu::ImageDescriptor {
+                                                            .type       = gpu::DescriptorType::SAMPLER,
+                                                            .binding    = 1,
+                                                            .layout     = gpu::ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+                                                            .image_view = as_ref(*view),
+                                                            .sampler    = as_ref(m_texture_data.sampler),
+                                                          });
+        descriptor_set->update(sets);
+
+        return { std::move(view), std::move(descriptor_set) };
+    }
+
     //////////////////////////////////////
     //////////////////////////////////////
     auto SpriteRenderSystem::render_static_sprite_task(FrameBuilder&             graph,
@@ -246,7 +1210,34 @@ namespace stormkit::engine::pipeline_2d {
                                                        FrameBuilder::ResourceID  camera_buffer_id,
                                                        FrameBuilder::ResourceID  sprites_buffer_id,
                                                        const gpu::DescriptorSet& camera_descriptor_set,
-                                                       u32                       camera_current_offset) noexcept -> void {
+                                                       u32                       camera_current_offset,
+                                                       BackgroundDraws           background,
+                                                       std::optional<IndirectDraws> indirect_draws) noexcept
+      -> void {
+        struct Draw {
+            Ref<const gpu::DescriptorSet> texture;
+            u32                           first;
+            u32                           count;
+        };
+
+        // resolved here as the texture list may grow while the frame is recorded
+        const auto instance_count = m_sprite_data.instance_count;
+        auto       draws          = std::vector<Draw> {};
+        draws.reserve(stdr::size(m_batches));
+        for (auto i = 0u; i < stdr::size(m_batches); ++i) {
+            const auto& batch = m_batches[i];
+            if (batch.first >= instance_count) break;
+
+            // indirect draws only need the batch command, the GPU write the instance range
+            draws.emplace_back(Draw { .texture = as_ref(*m_texture_data.textures[batch.texture].descriptor_set),
+                                      .first   = indirect_draws ? i : batch.first,
+                                      .count   = std::min(batch.count, instance_count - batch.first) });
+        }
+
+        const auto& sprites_descriptor_set = indirect_draws ? *m_gpu_cull_data.render_descriptor_set
+                                                            : *m_static_sprite_data.descriptor_set;
+        const auto  sprites_offset = indirect_draws ? indirect_draws->sprites_offset : m_sprite_data.current_offset;
+
         struct RenderSpriteTaskData {
             FrameBuilder::ResourceID camera_buffer_id  = {};
             FrameBuilder::ResourceID sprites_buffer_id = {};
@@ -262,19 +1253,51 @@ namespace stormkit::engine::pipeline_2d {
 
               builder.read_buffer(data.camera_buffer_id);
               builder.read_buffer(data.sprites_buffer_id);
+              if (indirect_draws) builder.read_buffer(indirect_draws->commands_buffer_id);
+              for (const auto buffer_id : background.buffers) builder.read_buffer(buffer_id);
               builder.write_attachment(data.backbuffer_id, gpu::ClearColor { .color = colors::BLACK<f32> });
           },
           [&camera_descriptor_set,
+           &sprites_descriptor_set,
            camera_current_offset,
+           sprites_offset,
+           constants = FrameConstants { .time = animation_time() },
+           indirect_draws,
+           draws  = std::move(draws),
+           record = std::move(background.record),
            this](const auto& frame_resources, auto& cmb, const auto& data) noexcept {
+              if (record) record(frame_resources, cmb);
+
+              if (stdr::empty(draws)) return;
+
+              // the camera (set 0) and the sprites (set 1) are the same for every draw, they stay bound while only the
+              // texture (set 2) is bound again, the layouts of the sets below it are compatible
               cmb.bind_pipeline(m_static_sprite_data.pipeline)
                 .bind_descriptor_sets(m_static_sprite_data.pipeline,
                                       m_static_sprite_data.pipeline_layout,
-                                      as_refs(camera_descriptor_set, m_static_sprite_data.descriptor_set),
-                                      to_array<u32>({ camera_current_offset, m_sprite_data.current_offset }));
+                                      as_refs(camera_descriptor_set, sprites_descriptor_set),
+                                      to_array<u32>({ camera_current_offset, sprites_offset }))
+                .push_constants(m_static_sprite_data.pipeline_layout, gpu::ShaderStageFlag::VERTEX, as_bytes(constants));
+
+              // instances are sorted, a draw is a run of sprites sharing the same texture
+              for (const auto& draw : draws) {
+                  cmb.bind_descriptor_sets(m_static_sprite_data.pipeline,
+                                           m_static_sprite_data.pipeline_layout,
+                                           as_refs(*draw.texture),
+                                           std::span<const u32> {},
+                                           TEXTURE_DESCRIPTOR_SET);
+
+                  if (not indirect_draws) {
+                      cmb.draw(4, draw.count, 0, draw.first);
+                      continue;
+                  }
 
-              const auto& access = m_sprites.read();
-              for (const auto& _ : access) cmb.draw(4);
+                  const auto& commands = frame_resources.get_buffer(indirect_draws->commands_buffer_id);
+                  cmb.draw_indirect(commands,
+                                    indirect_draws->commands_offset + draw.first * DRAW_COMMAND_SIZE,
+                                    1,
+                                    DRAW_COMMAND_SIZE);
+              }
           },
           FrameBuilder::ROOT);
 
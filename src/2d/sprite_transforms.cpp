@@ -0,0 +1,396 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/platform_macro.hpp>
+
+// the SSE2 kernel is always built on x86-64, the AVX2 one is compiled for its own target and picked at runtime
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define STORMKIT_ENGINE_SPRITE_KERNEL_X86
+    #include <immintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        #define STORMKIT_ENGINE_TARGET_AVX2 __attribute__((target("avx2")))
+    #else
+        #include <intrin.h>
+        #define STORMKIT_ENGINE_TARGET_AVX2
+    #endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define STORMKIT_ENGINE_SPRITE_KERNEL_NEON
+    #include <arm_neon.h>
+#endif
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :pipeline_2d.sprite_transforms;
+
+namespace stormkit::engine::pipeline_2d {
+    namespace {
+        /// return the count of sprites done, the remaining ones are left to the scalar path
+        using Kernel = auto (*)(const SpriteTransforms&, usize, SpriteInstance*) noexcept -> usize;
+
+        struct KernelEntry {
+            std::string_view name;
+            Kernel           kernel;
+        };
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        STORMKIT_FORCE_INLINE
+        inline auto compute_sprite_instance(const SpriteTransforms& transforms, usize i, SpriteInstance& out) noexcept -> void {
+            const auto width  = transforms.scale_x[i] * transforms.width[i];
+            const auto height = transforms.scale_y[i] * transforms.height[i];
+            const auto cos    = transforms.rotation_cos[i];
+            const auto sin    = transforms.rotation_sin[i];
+
+            out.basis  = { cos * width, sin * width, -sin * height, cos * height };
+            out.origin = { transforms.position_x[i], transforms.position_y[i], 0.f, 0.f };
+        }
+
+#if defined(STORMKIT_ENGINE_SPRITE_KERNEL_X86)
+        /////////////////////////////////////
+        /////////////////////////////////////
+        STORMKIT_FORCE_INLINE
+        inline auto store_sprite_instances(__m128          m00,
+                                           __m128          m10,
+                                           __m128          m01,
+                                           __m128          m11,
+                                           __m128          tx,
+                                           __m128          ty,
+                                           SpriteInstance* out) noexcept -> void {
+            const auto zero = _mm_setzero_ps();
+
+            // one row per sprite, m00 m10 m01 m11
+            _MM_TRANSPOSE4_PS(m00, m10, m01, m11);
+            const auto basis = std::array { m00, m10, m01, m11 };
+
+            const auto low    = _mm_unpacklo_ps(tx, ty);
+            const auto high   = _mm_unpackhi_ps(tx, ty);
+            const auto origin = std::array {
+                _mm_movelh_ps(low, zero),
+                _mm_movehl_ps(zero, low),
+                _mm_movelh_ps(high, zero),
+                _mm_movehl_ps(zero, high),
+            };
+
+            for (auto k = 0u; k < 4u; ++k) {
+                _mm_store_ps(stdr::data(out[k].basis), basis[k]);
+                _mm_store_ps(stdr::data(out[k].origin), origin[k]);
+            }
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto compute_sprite_instances_sse2(const SpriteTransforms& transforms, usize count, SpriteInstance* out) noexcept
+          -> usize {
+            constexpr auto WIDTH = 4_usize;
+
+            const auto aligned_count = count - (count % WIDTH);
+            const auto sign_mask     = _mm_set1_ps(-0.f);
+
+            for (auto i = 0_usize; i < aligned_count; i += WIDTH) {
+                const auto cos    = _mm_loadu_ps(stdr::data(transforms.rotation_cos) + i);
+                const auto sin    = _mm_loadu_ps(stdr::data(transforms.rotation_sin) + i);
+                const auto width  = _mm_mul_ps(_mm_loadu_ps(stdr::data(transforms.scale_x) + i),
+                                              _mm_loadu_ps(stdr::data(transforms.width) + i));
+                const auto height = _mm_mul_ps(_mm_loadu_ps(stdr::data(transforms.scale_y) + i),
+                                               _mm_loadu_ps(stdr::data(transforms.height) + i));
+
+                store_sprite_instances(_mm_mul_ps(cos, width),
+                                       _mm_mul_ps(sin, width),
+                                       _mm_xor_ps(_mm_mul_ps(sin, height), sign_mask),
+                                       _mm_mul_ps(cos, height),
+                                       _mm_loadu_ps(stdr::data(transforms.position_x) + i),
+                                       _mm_loadu_ps(stdr::data(transforms.position_y) + i),
+                                       out + i);
+            }
+
+            return aligned_count;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        STORMKIT_ENGINE_TARGET_AVX2
+        auto compute_sprite_instances_avx2(const SpriteTransforms& transforms, usize count, SpriteInstance* out) noexcept
+          -> usize {
+            constexpr auto WIDTH = 8_usize;
+
+            const auto aligned_count = count - (count % WIDTH);
+            const auto sign_mask     = _mm256_set1_ps(-0.f);
+
+            for (auto i = 0_usize; i < aligned_count; i += WIDTH) {
+                const auto cos    = _mm256_loadu_ps(stdr::data(transforms.rotation_cos) + i);
+                const auto sin    = _mm256_loadu_ps(stdr::data(transforms.rotation_sin) + i);
+                const auto width  = _mm256_mul_ps(_mm256_loadu_ps(stdr::data(transforms.scale_x) + i),
+                                                 _mm256_loadu_ps(stdr::data(transforms.width) + i));
+                const auto height = _mm256_mul_ps(_mm256_loadu_ps(stdr::data(transforms.scale_y) + i),
+                                                  _mm256_loadu_ps(stdr::data(transforms.height) + i));
+                const auto tx     = _mm256_loadu_ps(stdr::data(transforms.position_x) + i);
+                const auto ty     = _mm256_loadu_ps(stdr::data(transforms.position_y) + i);
+
+                const auto m00 = _mm256_mul_ps(cos, width);
+                const auto m10 = _mm256_mul_ps(sin, width);
+                const auto m01 = _mm256_xor_ps(_mm256_mul_ps(sin, height), sign_mask);
+                const auto m11 = _mm256_mul_ps(cos, height);
+
+                store_sprite_instances(_mm256_castps256_ps128(m00),
+                                       _mm256_castps256_ps128(m10),
+                                       _mm256_castps256_ps128(m01),
+                                       _mm256_castps256_ps128(m11),
+                                       _mm256_castps256_ps128(tx),
+                                       _mm256_castps256_ps128(ty),
+                                       out + i);
+                store_sprite_instances(_mm256_extractf128_ps(m00, 1),
+                                       _mm256_extractf128_ps(m10, 1),
+                                       _mm256_extractf128_ps(m01, 1),
+                                       _mm256_extractf128_ps(m11, 1),
+                                       _mm256_extractf128_ps(tx, 1),
+                                       _mm256_extractf128_ps(ty, 1),
+                                       out + i + 4);
+            }
+
+            return aligned_count;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto has_avx2() noexcept -> bool {
+    #if defined(__GNUC__) || defined(__clang__)
+            return __builtin_cpu_supports("avx2");
+    #else
+            auto info = std::array<int, 4> {};
+            __cpuidex(stdr::data(info), 7, 0);
+
+            // the OS must also save the ymm registers on context switches
+            return (info[1] & (1 << 5)) != 0 and (_xgetbv(0) & 0x6) == 0x6;
+    #endif
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto select_kernel() noexcept -> KernelEntry {
+            if (has_avx2()) return { "avx2", &compute_sprite_instances_avx2 };
+
+            return { "sse2", &compute_sprite_instances_sse2 };
+        }
+#elif defined(STORMKIT_ENGINE_SPRITE_KERNEL_NEON)
+        /////////////////////////////////////
+        /////////////////////////////////////
+        STORMKIT_FORCE_INLINE
+        inline auto transpose(float32x4_t a, float32x4_t b, float32x4_t c, float32x4_t d) noexcept -> std::array<float32x4_t, 4> {
+            const auto ab = vtrnq_f32(a, b);
+            const auto cd = vtrnq_f32(c, d);
+
+            return {
+                vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0])),
+                vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1])),
+                vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0])),
+                vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1])),
+            };
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto compute_sprite_instances_neon(const SpriteTransforms& transforms, usize count, SpriteInstance* out) noexcept
+          -> usize {
+            constexpr auto WIDTH = 4_usize;
+
+            const auto aligned_count = count - (count % WIDTH);
+            const auto zero          = vdupq_n_f32(0.f);
+
+            for (auto i = 0_usize; i < aligned_count; i += WIDTH) {
+                const auto cos    = vld1q_f32(stdr::data(transforms.rotation_cos) + i);
+                const auto sin    = vld1q_f32(stdr::data(transforms.rotation_sin) + i);
+                const auto width  = vmulq_f32(vld1q_f32(stdr::data(transforms.scale_x) + i),
+                                             vld1q_f32(stdr::data(transforms.width) + i));
+                const auto height = vmulq_f32(vld1q_f32(stdr::data(transforms.scale_y) + i),
+                                              vld1q_f32(stdr::data(transforms.height) + i));
+
+                const auto basis  = transpose(vmulq_f32(cos, width),
+                                             vmulq_f32(sin, width),
+                                             vnegq_f32(vmulq_f32(sin, height)),
+                                             vmulq_f32(cos, height));
+                const auto origin = transpose(vld1q_f32(stdr::data(transforms.position_x) + i),
+                                              vld1q_f32(stdr::data(transforms.position_y) + i),
+                                              zero,
+                                              zero);
+
+                for (auto k = 0u; k < 4u; ++k) {
+                    vst1q_f32(stdr::data(out[i + k].basis), basis[k]);
+                    vst1q_f32(stdr::data(out[i + k].origin), origin[k]);
+                }
+            }
+
+            return aligned_count;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto select_kernel() noexcept -> KernelEntry {
+            return { "neon", &compute_sprite_instances_neon };
+        }
+#else
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto compute_sprite_instances_scalar(const SpriteTransforms&, usize, SpriteInstance*) noexcept -> usize {
+            return 0;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto select_kernel() noexcept -> KernelEntry {
+            return { "scalar", &compute_sprite_instances_scalar };
+        }
+#endif
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto kernel() noexcept -> const KernelEntry& {
+            static const auto KERNEL = select_kernel();
+            return KERNEL;
+        }
+    } // namespace
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteTransforms::resize(usize count) noexcept -> void {
+        position_x.resize(count, 0.f);
+        position_y.resize(count, 0.f);
+        scale_x.resize(count, 1.f);
+        scale_y.resize(count, 1.f);
+        rotation.resize(count, 0.f);
+        rotation_cos.resize(count, 1.f);
+        rotation_sin.resize(count, 0.f);
+        width.resize(count, 0.f);
+        height.resize(count, 0.f);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteTransforms::clear() noexcept -> void {
+        resize(0);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteTransforms::swap_remove(usize index) noexcept -> void {
+        EXPECTS(index < size());
+
+        const auto remove = [index](std::vector<f32>& values) noexcept {
+            values[index] = values.back();
+            values.pop_back();
+        };
+
+        remove(position_x);
+        remove(position_y);
+        remove(scale_x);
+        remove(scale_y);
+        remove(rotation);
+        remove(rotation_cos);
+        remove(rotation_sin);
+        remove(width);
+        remove(height);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteTransforms::gather(const SpriteTransforms& other, std::span<const u32> indices) noexcept -> void {
+        const auto copy = [&indices](const std::vector<f32>& from, std::vector<f32>& to) noexcept {
+            to.resize(stdr::size(indices));
+            for (auto i = 0_usize; i < stdr::size(indices); ++i) to[i] = from[indices[i]];
+        };
+
+        copy(other.position_x, position_x);
+        copy(other.position_y, position_y);
+        copy(other.scale_x, scale_x);
+        copy(other.scale_y, scale_y);
+        copy(other.rotation, rotation);
+        copy(other.rotation_cos, rotation_cos);
+        copy(other.rotation_sin, rotation_sin);
+        copy(other.width, width);
+        copy(other.height, height);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto SpriteTransforms::set(usize              index,
+                               const math::fvec2& position,
+                               const math::fvec2& scale,
+                               f32                _rotation,
+                               const math::fvec2& extent) noexcept -> bool {
+        EXPECTS(index < size());
+
+        const auto changed = position_x[index] != position.x
+                             or position_y[index] != position.y
+                             or scale_x[index] != scale.x
+                             or scale_y[index] != scale.y
+                             or rotation[index] != _rotation
+                             or width[index] != extent.x
+                             or height[index] != extent.y;
+        if (not changed) return false;
+
+        position_x[index] = position.x;
+        position_y[index] = position.y;
+        scale_x[index]    = scale.x;
+        scale_y[index]    = scale.y;
+        width[index]      = extent.x;
+        height[index]     = extent.y;
+
+        // sin / cos are only evaluated when the rotation change, so the kernel stay pure arithmetic
+        if (rotation[index] != _rotation) {
+            rotation[index]     = _rotation;
+            rotation_cos[index] = std::cos(_rotation);
+            rotation_sin[index] = std::sin(_rotation);
+        }
+
+        return true;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto sprite_bounds(const SpriteTransforms& transforms, usize index) noexcept -> math::fbounding_rect {
+        EXPECTS(index < transforms.size());
+
+        const auto width  = transforms.scale_x[index] * transforms.width[index];
+        const auto height = transforms.scale_y[index] * transforms.height[index];
+        const auto cos    = transforms.rotation_cos[index];
+        const auto sin    = transforms.rotation_sin[index];
+
+        // the quad span [0, 1]², its corners are offset from the origin by the two basis vectors
+        const auto ux = cos * width, uy = sin * width;
+        const auto vx = -sin * height, vy = cos * height;
+
+        const auto x = transforms.position_x[index];
+        const auto y = transforms.position_y[index];
+
+        auto bounds   = math::fbounding_rect {};
+        bounds.left   = x + std::min(0.f, ux) + std::min(0.f, vx);
+        bounds.right  = x + std::max(0.f, ux) + std::max(0.f, vx);
+        bounds.top    = y + std::min(0.f, uy) + std::min(0.f, vy);
+        bounds.bottom = y + std::max(0.f, uy) + std::max(0.f, vy);
+
+        return bounds;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto compute_sprite_instances(const SpriteTransforms& transforms, std::span<SpriteInstance> out) noexcept -> void {
+        const auto count = transforms.size();
+        EXPECTS(stdr::size(out) >= count);
+
+        const auto done = kernel().kernel(transforms, count, stdr::data(out));
+        for (auto i = done; i < count; ++i) compute_sprite_instance(transforms, i, out[i]);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto sprite_transforms_kernel_name() noexcept -> std::string_view {
+        return kernel().name;
+    }
+} // namespace stormkit::engine::pipeline_2d
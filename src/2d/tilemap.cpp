@@ -0,0 +1,880 @@
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+#include <stormkit/core/try_expected.hpp>
+
+#include <stormkit/log/log_macro.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :core;
+import :pipeline_2d.tilemap;
+
+namespace stdr  = std::ranges;
+namespace stdfs = std::filesystem;
+
+namespace stormkit::engine::pipeline_2d {
+    LOGGER("tilemap")
+
+    namespace {
+        constexpr auto TILE_CHUNK_SHADER = core::into_bytes({
+        // clang-format off
+#embed <tile_chunk.spv>
+          // clang-format on
+        });
+
+        constexpr auto UPLOAD_CHUNKS_TASK_NAME   = "StormKit:2d_pipeline:upload_tile_chunks";
+        constexpr auto CHUNKS_BUFFER_NAME        = "StormKit:2d_pipeline:render_sprites:tile_chunks_buffer";
+        constexpr auto CHUNK_STAGING_BUFFER_NAME = "StormKit:2d_pipeline:upload_tile_chunks:chunk_staging_buffer:{}";
+
+        constexpr auto MAP_MAGIC   = std::array { 'S', 'K', 'T', 'M' };
+        constexpr auto MAP_VERSION = 1u;
+
+        struct MapHeader {
+            std::array<char, 4> magic;
+            u32                 version;
+            u32                 chunk_size;
+            u32                 chunk_count;
+        };
+
+        struct MapIndexEntry {
+            i32 x;
+            i32 y;
+            u64 offset;
+            u32 size;
+            u32 padding = 0;
+        };
+
+        // must match CHUNK_HEADER_COUNT of tile_chunk.wgsl, origin, tile size, tile uv, columns and tile count
+        constexpr auto CHUNK_HEADER_COUNT = 8_usize;
+        constexpr auto SLOT_SIZE          = sizeof(u32) * (CHUNK_HEADER_COUNT + Tilemap::CHUNK_TILE_COUNT);
+        constexpr auto MAX_GPU_CHUNKS     = 512_usize;
+        constexpr auto CHUNKS_BUFFER_SIZE = SLOT_SIZE * MAX_GPU_CHUNKS;
+        constexpr auto NO_SLOT            = std::numeric_limits<u32>::max();
+
+        // chunks baked per frame, spread the cost of a camera jump over a few frames
+        constexpr auto MAX_CHUNK_UPLOADS = 4_usize;
+        // chunks kept loaded around the camera, so they are baked before being seen
+        constexpr auto STREAM_MARGIN     = 1;
+        constexpr auto MAX_TILESETS      = 16_usize;
+        // a tileset is bound a second time once its async load replace the placeholder
+        constexpr auto MAX_TILESET_VIEWS = 2 * MAX_TILESETS;
+        // a recycled view keep its descriptor set until the new one is allocated
+        constexpr auto MAX_TILESET_SETS  = MAX_TILESET_VIEWS + 1;
+
+        struct TilesetData {
+            static constexpr auto layout_bindings() -> std::array<gpu::DescriptorSetLayoutBinding, 2> {
+                return {
+                    gpu::DescriptorSetLayoutBinding { .binding          = 0,
+                                                     .type             = gpu::DescriptorType::SAMPLED_IMAGE,
+                                                     .stages           = gpu::ShaderStageFlag::FRAGMENT,
+                                                     .descriptor_count = 1 },
+                    gpu::DescriptorSetLayoutBinding { .binding          = 1,
+                                                     .type             = gpu::DescriptorType::SAMPLER,
+                                                     .stages           = gpu::ShaderStageFlag::FRAGMENT,
+                                                     .descriptor_count = 1 },
+                };
+            }
+        };
+
+        struct ChunksData {
+            static constexpr auto layout_binding() -> gpu::DescriptorSetLayoutBinding {
+                return { .binding          = 0,
+                         .type             = gpu::DescriptorType::STORAGE_BUFFER,
+                         .stages           = gpu::ShaderStageFlag::VERTEX,
+                         .descriptor_count = 1 };
+            }
+        };
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        template<typename T>
+        auto read(std::istream& stream, std::span<T> values) noexcept -> bool {
+            stream.read(reinterpret_cast<char*>(stdr::data(values)), as<std::streamsize>(values.size_bytes()));
+            return stream.good();
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto read_at(std::istream& stream, u64 offset, u32 size) noexcept -> std::optional<std::vector<u16>> {
+            auto payload = std::vector<u16>(size / sizeof(u16));
+
+            stream.clear();
+            stream.seekg(as<std::streamoff>(offset));
+            if (not read(stream, std::span { payload })) return std::nullopt;
+
+            return payload;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        template<typename T>
+        auto write(std::ostream& stream, std::span<const T> values) noexcept -> void {
+            stream.write(reinterpret_cast<const char*>(stdr::data(values)), as<std::streamsize>(values.size_bytes()));
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto encode(const std::array<u16, Tilemap::CHUNK_TILE_COUNT>& tiles) noexcept -> std::vector<u16> {
+            // (run length, tile) pairs, levels are mostly made of long runs of the same tile
+            auto out = std::vector<u16> {};
+            for (auto i = 0_usize; i < stdr::size(tiles);) {
+                auto run = 1_usize;
+                while (i + run < stdr::size(tiles) and tiles[i + run] == tiles[i]) ++run;
+
+                out.emplace_back(as<u16>(run));
+                out.emplace_back(tiles[i]);
+                i += run;
+            }
+
+            return out;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto decode(std::span<const u16> payload, std::array<u16, Tilemap::CHUNK_TILE_COUNT>& tiles) noexcept -> bool {
+            if (stdr::size(payload) % 2 != 0) return false;
+
+            auto i = 0_usize;
+            for (auto run = 0_usize; run < stdr::size(payload); run += 2) {
+                const auto count = usize { payload[run] };
+                if (i + count > stdr::size(tiles)) return false;
+
+                stdr::fill_n(stdr::begin(tiles) + i, count, payload[run + 1]);
+                i += count;
+            }
+
+            return i == stdr::size(tiles);
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto local_index(const Tilemap::ChunkCoord& coord, i32 x, i32 y) noexcept -> usize {
+            return as<usize>((y - coord.y * Tilemap::CHUNK_SIZE) * Tilemap::CHUNK_SIZE + x - coord.x * Tilemap::CHUNK_SIZE);
+        }
+    } // namespace
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::open(const stdfs::path& path) noexcept -> bool {
+        // the loads in flight read their own copy of the path and the index entry, their result is just dropped
+        m_loading.clear();
+        m_chunks.clear();
+        m_index.clear();
+        m_file.close();
+        m_path = path;
+
+        if (not stdfs::exists(path)) {
+            dlog("Tilemap {} does not exist yet, open an empty map.", path.string());
+            return true;
+        }
+
+        return read_index(path);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::save(const stdfs::path& path) noexcept -> bool {
+        if (path.empty()) {
+            elog("Tilemap has no file to be saved to!");
+            return false;
+        }
+
+        // the loads in flight must not read the file once replaced
+        finish_loads(true);
+
+        struct Payload {
+            ChunkCoord       coord;
+            std::vector<u16> data;
+        };
+
+        auto payloads = std::vector<Payload> {};
+        payloads.reserve(stdr::size(m_index) + stdr::size(m_chunks));
+        for (const auto& [_, chunk] : m_chunks) {
+            if (stdr::all_of(chunk.tiles, monadic::is_equal(EMPTY_TILE))) continue;
+
+            payloads.emplace_back(Payload { .coord = chunk.coord, .data = encode(chunk.tiles) });
+        }
+
+        // chunks not in memory are copied as is from the current file
+        for (const auto& [key, entry] : m_index) {
+            if (m_chunks.contains(key)) continue;
+
+            auto payload = read_payload(entry);
+            if (not payload) {
+                elog("Failed to read chunk {}, {} of tilemap {}!", entry.coord.x, entry.coord.y, m_path.string());
+                return false;
+            }
+
+            payloads.emplace_back(Payload { .coord = entry.coord, .data = std::move(*payload) });
+        }
+
+        auto temporary = path;
+        temporary += ".tmp";
+        {
+            auto file = std::ofstream { temporary, std::ios::binary | std::ios::trunc };
+
+            const auto header = MapHeader {
+                .magic       = MAP_MAGIC,
+                .version     = MAP_VERSION,
+                .chunk_size  = as<u32>(CHUNK_SIZE),
+                .chunk_count = as<u32>(stdr::size(payloads)),
+            };
+
+            auto entries = std::vector<MapIndexEntry> {};
+            entries.reserve(stdr::size(payloads));
+
+            auto offset = u64 { sizeof(MapHeader) + sizeof(MapIndexEntry) * stdr::size(payloads) };
+            for (const auto& payload : payloads) {
+                const auto size = as<u32>(sizeof(u16) * stdr::size(payload.data));
+                entries.emplace_back(MapIndexEntry { .x = payload.coord.x, .y = payload.coord.y, .offset = offset, .size = size });
+                offset += size;
+            }
+
+            write(file, std::span { &header, 1 });
+            write(file, std::span<const MapIndexEntry> { entries });
+            for (const auto& payload : payloads) write(file, std::span<const u16> { payload.data });
+
+            if (not file) {
+                elog("Failed to write tilemap {}!", temporary.string());
+                return false;
+            }
+        }
+
+        m_file.close();
+
+        auto error = std::error_code {};
+        stdfs::rename(temporary, path, error);
+        if (error) {
+            elog("Failed to replace tilemap {}, reason: {}!", path.string(), error.message());
+            read_index(m_path);
+            return false;
+        }
+
+        for (auto& [_, chunk] : m_chunks) chunk.modified = false;
+        m_path = path;
+
+        ilog("Saved tilemap {} with {} chunks.", path.string(), stdr::size(payloads));
+
+        return read_index(path);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::set_tile(i32 x, i32 y, u16 tile) noexcept -> void {
+        auto& chunk = *find_or_load(chunk_of(x, y), true);
+
+        auto& value = chunk.tiles[local_index(chunk.coord, x, y)];
+        if (value == tile) return;
+
+        value          = tile;
+        chunk.modified = true;
+        chunk.revision = ++m_revision;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::tile(i32 x, i32 y) noexcept -> u16 {
+        const auto* chunk = find_or_load(chunk_of(x, y), false);
+        if (chunk == nullptr) return EMPTY_TILE;
+
+        return chunk->tiles[local_index(chunk->coord, x, y)];
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::fill(i32 x, i32 y, u32 width, u32 height, u16 tile) noexcept -> void {
+        if (width == 0 or height == 0) return;
+
+        const auto last_x = x + as<i32>(width) - 1;
+        const auto last_y = y + as<i32>(height) - 1;
+        const auto first  = chunk_of(x, y);
+        const auto last   = chunk_of(last_x, last_y);
+
+        // chunk by chunk so a large fill cost one lookup per chunk instead of one per tile
+        for (auto chunk_y = first.y; chunk_y <= last.y; ++chunk_y) {
+            for (auto chunk_x = first.x; chunk_x <= last.x; ++chunk_x) {
+                auto& chunk = *find_or_load({ chunk_x, chunk_y }, true);
+
+                const auto min_x = std::max(x, chunk_x * CHUNK_SIZE);
+                const auto min_y = std::max(y, chunk_y * CHUNK_SIZE);
+                const auto max_x = std::min(last_x, chunk_x * CHUNK_SIZE + CHUNK_SIZE - 1);
+                const auto max_y = std::min(last_y, chunk_y * CHUNK_SIZE + CHUNK_SIZE - 1);
+
+                auto changed = false;
+                for (auto tile_y = min_y; tile_y <= max_y; ++tile_y) {
+                    for (auto tile_x = min_x; tile_x <= max_x; ++tile_x) {
+                        auto& value = chunk.tiles[local_index(chunk.coord, tile_x, tile_y)];
+                        changed     = changed or value != tile;
+                        value       = tile;
+                    }
+                }
+
+                if (not changed) continue;
+
+                chunk.modified = true;
+                chunk.revision = ++m_revision;
+            }
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::stream(const ChunkRange& range, ThreadPool& thread_pool) noexcept -> void {
+        finish_loads(false);
+
+        auto unloaded = std::vector<u64> {};
+        for (const auto& [key, chunk] : m_chunks)
+            if (not chunk.modified and not range.contains(chunk.coord)) unloaded.emplace_back(key);
+
+        for (const auto key : unloaded) m_chunks.erase(key);
+
+        // each load open its own stream, m_file stay owned by the calling thread
+        const auto request = [&, this](u64 key, const IndexEntry& entry) noexcept {
+            if (m_chunks.contains(key) or m_loading.contains(key)) return;
+
+            auto tiles = thread_pool.post_task<std::optional<Tiles>>([path = m_path, entry] noexcept -> std::optional<Tiles> {
+                auto       file    = std::ifstream { path, std::ios::binary };
+                const auto payload = read_at(file, entry.offset, entry.size);
+
+                auto out = Tiles {};
+                if (not payload or not decode(*payload, out)) return std::nullopt;
+
+                return out;
+            });
+            m_loading.emplace(key, Loading { .coord = entry.coord, .tiles = std::move(tiles) });
+        };
+
+        const auto width  = i64 { range.max.x } - range.min.x + 1;
+        const auto height = i64 { range.max.y } - range.min.y + 1;
+
+        // a far zoomed out camera cover more chunks than the map has
+        if (width * height > as<i64>(stdr::size(m_index))) {
+            for (const auto& [key, entry] : m_index)
+                if (range.contains(entry.coord)) request(key, entry);
+            return;
+        }
+
+        for (auto y = range.min.y; y <= range.max.y; ++y) {
+            for (auto x = range.min.x; x <= range.max.x; ++x) {
+                const auto key = chunk_key({ x, y });
+                if (const auto it = m_index.find(key); it != stdr::cend(m_index)) request(key, it->second);
+            }
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::read_index(const stdfs::path& path) noexcept -> bool {
+        m_index.clear();
+
+        m_file = std::ifstream { path, std::ios::binary };
+        if (not m_file) {
+            elog("Failed to open tilemap {}!", path.string());
+            return false;
+        }
+
+        auto header = MapHeader {};
+        if (not read(m_file, std::span { &header, 1 })
+            or header.magic != MAP_MAGIC
+            or header.version != MAP_VERSION
+            or header.chunk_size != as<u32>(CHUNK_SIZE)) {
+            elog("{} is not a version {} tilemap!", path.string(), MAP_VERSION);
+            m_file.close();
+            return false;
+        }
+
+        auto entries = std::vector<MapIndexEntry>(header.chunk_count);
+        if (not read(m_file, std::span { entries })) {
+            elog("Failed to read the chunk index of tilemap {}!", path.string());
+            m_file.close();
+            return false;
+        }
+
+        m_index.reserve(stdr::size(entries));
+        for (const auto& entry : entries) {
+            const auto coord = ChunkCoord { entry.x, entry.y };
+            m_index.emplace(chunk_key(coord), IndexEntry { .coord = coord, .offset = entry.offset, .size = entry.size });
+        }
+
+        dlog("Opened tilemap {} with {} chunks.", path.string(), stdr::size(m_index));
+
+        return true;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::read_payload(const IndexEntry& entry) noexcept -> std::optional<std::vector<u16>> {
+        if (not m_file.is_open()) return std::nullopt;
+
+        return read_at(m_file, entry.offset, entry.size);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::find_or_load(const ChunkCoord& coord, bool create) noexcept -> Chunk* {
+        const auto key = chunk_key(coord);
+        if (auto it = m_loading.find(key); it != stdr::end(m_loading)) {
+            finish_load(key, it->second);
+            m_loading.erase(it);
+        }
+        if (auto it = m_chunks.find(key); it != stdr::end(m_chunks)) return &it->second;
+
+        auto chunk = Chunk { .coord = coord };
+        if (auto it = m_index.find(key); it != stdr::end(m_index)) {
+            const auto payload = read_payload(it->second);
+            if (not payload or not decode(*payload, chunk.tiles)) {
+                elog("Failed to load chunk {}, {} of tilemap {}, it is dropped!", coord.x, coord.y, m_path.string());
+                m_index.erase(it);
+                chunk.tiles = {};
+
+                if (not create) return nullptr;
+            }
+        } else if (not create)
+            return nullptr;
+
+        chunk.revision = ++m_revision;
+
+        return &m_chunks.emplace(key, std::move(chunk)).first->second;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::finish_loads(bool wait) noexcept -> void {
+        using namespace std::chrono_literals;
+
+        auto finished = std::vector<u64> {};
+        for (auto& [key, loading] : m_loading) {
+            if (not wait and loading.tiles.wait_for(0s) != std::future_status::ready) continue;
+
+            finish_load(key, loading);
+            finished.emplace_back(key);
+        }
+
+        for (const auto key : finished) m_loading.erase(key);
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto Tilemap::finish_load(u64 key, Loading& loading) noexcept -> void {
+        auto tiles = loading.tiles.get();
+        if (not tiles) {
+            elog("Failed to load chunk {}, {} of tilemap {}, it is dropped!",
+                 loading.coord.x,
+                 loading.coord.y,
+                 m_path.string());
+            m_index.erase(key);
+            return;
+        }
+
+        m_chunks.emplace(key, Chunk { .coord = loading.coord, .tiles = *std::move(tiles), .revision = ++m_revision });
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto TilemapRenderer::do_init(const Renderer&                 renderer,
+                                  const gpu::RasterPipelineState& initial_state,
+                                  const gpu::DescriptorSetLayout& camera_descriptor_layout) noexcept -> gpu::Expected<void> {
+        const auto& device = renderer.device();
+
+        m_render_data
+          .vertex_shader = Try(gpu::Shader::load_from_bytes(device, TILE_CHUNK_SHADER, gpu::ShaderStageFlag::VERTEX));
+        m_render_data
+          .fragment_shader = Try(gpu::Shader::load_from_bytes(device, TILE_CHUNK_SHADER, gpu::ShaderStageFlag::FRAGMENT));
+
+        auto pipeline_state         = auto(initial_state);
+        pipeline_state.shader_state = to_refs(m_render_data.vertex_shader, m_render_data.fragment_shader);
+
+        m_render_data
+          .chunks_descriptor_layout = Try(gpu::DescriptorSetLayout::
+                                            create(device,
+                                                   into_dyn_array<gpu::DescriptorSetLayoutBinding>(ChunksData::layout_binding())));
+        m_render_data
+          .tileset_descriptor_layout = Try(gpu::DescriptorSetLayout::
+                                             create(device,
+                                                    into_dyn_array<gpu::DescriptorSetLayoutBinding>(TilesetData::layout_bindings())));
+
+        m_render_data
+          .pipeline_layout = Try(gpu::PipelineLayout::
+                                   create(device,
+                                          { .descriptor_set_layouts = to_refs(camera_descriptor_layout,
+                                                                              m_render_data.chunks_descriptor_layout,
+                                                                              m_render_data.tileset_descriptor_layout) }));
+
+        const auto rendering_info = gpu::RasterPipelineRenderingInfo {
+            .color_attachment_formats = { gpu::PixelFormat::RGBA8_UNORM }
+        };
+
+        m_render_data
+          .pipeline = Try(gpu::Pipeline::create(device, pipeline_state, m_render_data.pipeline_layout, rendering_info));
+
+        const auto pool_sizes          = to_array<gpu::DescriptorPool::Size>({
+          {
+           .type             = gpu::DescriptorType::STORAGE_BUFFER,
+           .descriptor_count = 1,
+           },
+          {
+           .type             = gpu::DescriptorType::SAMPLED_IMAGE,
+           .descriptor_count = as<u32>(MAX_TILESET_SETS),
+           },
+          {
+           .type             = gpu::DescriptorType::SAMPLER,
+           .descriptor_count = as<u32>(MAX_TILESET_SETS),
+           },
+        });
+        m_render_data.descriptor_pool = Try(gpu::DescriptorPool::create(device, pool_sizes, as<u32>(1 + MAX_TILESET_SETS)));
+
+        // slots are recycled only once the frames drawing them are done, so a single copy is enough
+        m_render_data.chunks_buffer = Try(gpu::Buffer::create(device,
+                                                              {
+                                                                .usages = gpu::BufferUsageFlag::STORAGE
+                                                                          | gpu::BufferUsageFlag::TRANSFER_DST,
+                                                                .size     = CHUNKS_BUFFER_SIZE,
+                                                                .property = gpu::MemoryPropertyFlag::DEVICE_LOCAL,
+                                                              }));
+
+        m_render_data
+          .chunks_descriptor_set = Try(m_render_data.descriptor_pool->create_descriptor_set(m_render_data
+                                                                                              .chunks_descriptor_layout));
+        m_render_data.chunks_descriptor_set->update(into_dyn_array<gpu::Descriptor>(gpu::BufferDescriptor {
+          .type    = gpu::DescriptorType::STORAGE_BUFFER,
+          .binding = 0,
+          .buffer  = as_ref(m_render_data.chunks_buffer),
+          .range   = CHUNKS_BUFFER_SIZE,
+          .offset  = 0,
+        }));
+
+        m_tileset.sampler = Try(gpu::Sampler::create(device, {}));
+
+        m_free_slots.resize(MAX_GPU_CHUNKS);
+        for (auto i = 0u; i < MAX_GPU_CHUNKS; ++i) m_free_slots[i] = as<u32>(MAX_GPU_CHUNKS) - 1 - i;
+
+        Return {};
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto TilemapRenderer::insert_tasks(const Application&          application,
+                                       FrameBuilder&               graph,
+                                       const gpu::DescriptorSet&   camera_descriptor_set,
+                                       u32                         camera_current_offset,
+                                       const math::fbounding_rect& camera_bounds) noexcept -> BackgroundDraws {
+        const auto& renderer = application.renderer();
+
+        if (m_tileset.texture == INVALID_TEXTURE_ID) return {};
+        refresh_tileset(renderer);
+        if (m_tileset.applied != m_tileset.revision) update_tileset(renderer);
+
+        m_frame += 1;
+        release_slots(renderer.buffering_count());
+
+        const auto visible_range  = chunk_range(camera_bounds, 0);
+        const auto streamed_range = chunk_range(camera_bounds, STREAM_MARGIN);
+        m_tilemap.stream(streamed_range, renderer.thread_pool());
+
+        const auto& chunks = m_tilemap.chunks();
+
+        const auto retire = [this](u32 slot) noexcept {
+            if (slot != NO_SLOT) m_retired_slots.emplace_back(slot, m_frame);
+        };
+
+        auto released = std::vector<u64> {};
+        for (const auto& [key, gpu_chunk] : m_gpu_chunks) {
+            const auto it = chunks.find(key);
+            if (it != stdr::cend(chunks) and streamed_range.contains(it->second.coord)) continue;
+
+            retire(gpu_chunk.slot);
+            released.emplace_back(key);
+        }
+        for (const auto key : released) m_gpu_chunks.erase(key);
+
+        // a modified chunk is baked in a new slot, the previous one may still be read by the frames in flight
+        auto uploads = std::vector<std::pair<u32, std::vector<u32>>> {};
+        auto missing = 0_usize;
+        const auto bake_chunk = [&, this](u64 key, const Tilemap::Chunk& chunk) noexcept {
+            const auto it = m_gpu_chunks.find(key);
+            if (it != stdr::end(m_gpu_chunks)
+                and it->second.revision == chunk.revision
+                and it->second.tileset_revision == m_tileset.revision)
+                return;
+
+            auto       tiles      = bake(chunk);
+            const auto tile_count = tiles[CHUNK_HEADER_COUNT - 1];
+
+            auto slot = NO_SLOT;
+            if (tile_count > 0) {
+                if (stdr::empty(m_free_slots)) {
+                    missing += 1;
+                    return;
+                }
+                if (stdr::size(uploads) >= MAX_CHUNK_UPLOADS) return;
+
+                slot = m_free_slots.back();
+                m_free_slots.pop_back();
+                uploads.emplace_back(slot, std::move(tiles));
+            }
+
+            if (it != stdr::end(m_gpu_chunks)) retire(it->second.slot);
+            m_gpu_chunks.insert_or_assign(key,
+                                          GpuChunk { .coord            = chunk.coord,
+                                                     .slot             = slot,
+                                                     .revision         = chunk.revision,
+                                                     .tileset_revision = m_tileset.revision,
+                                                     .tile_count       = tile_count });
+        };
+
+        // visible chunks first, the margin is baked with the upload budget left
+        for (const auto& [key, chunk] : chunks)
+            if (visible_range.contains(chunk.coord)) bake_chunk(key, chunk);
+        for (const auto& [key, chunk] : chunks)
+            if (streamed_range.contains(chunk.coord) and not visible_range.contains(chunk.coord)) bake_chunk(key, chunk);
+
+        // the chunks buffer has a fixed size, a camera covering more chunks than it holds leave some undrawn
+        if (missing > 0 and not m_slots_exhausted)
+            wlog("All {} GPU chunk slots are used, {} streamed chunks are not drawn!", MAX_GPU_CHUNKS, missing);
+        m_slots_exhausted = missing > 0;
+
+        const auto chunks_buffer_id = graph.retain_buffer(CHUNKS_BUFFER_NAME, *m_render_data.chunks_buffer);
+        if (not stdr::empty(uploads)) upload_task(graph, chunks_buffer_id, std::move(uploads));
+
+        struct Draw {
+            u32 first_instance;
+            u32 tile_count;
+        };
+
+        auto draws = std::vector<Draw> {};
+        for (const auto& [_, gpu_chunk] : m_gpu_chunks) {
+            if (gpu_chunk.slot == NO_SLOT or not visible_range.contains(gpu_chunk.coord)) continue;
+
+            // the shader find the slot back from the instance index
+            draws.emplace_back(Draw { .first_instance = gpu_chunk.slot * as<u32>(Tilemap::CHUNK_TILE_COUNT),
+                                      .tile_count     = gpu_chunk.tile_count });
+        }
+
+        if (stdr::empty(draws)) return {};
+
+        // the view may be recycled while the frames in flight record, its descriptor set stay where it is
+        const auto tileset_descriptor_set = as_ref(*m_tileset.views[m_tileset.current].descriptor_set);
+
+        return BackgroundDraws {
+            .buffers = { chunks_buffer_id },
+            .record  = [&camera_descriptor_set,
+                       tileset_descriptor_set,
+                       camera_current_offset,
+                       draws = std::move(draws),
+                       this](const FrameResourcesAccessor&, gpu::CommandBuffer& cmb) noexcept {
+                cmb.bind_pipeline(m_render_data.pipeline)
+                  .bind_descriptor_sets(m_render_data.pipeline,
+                                        m_render_data.pipeline_layout,
+                                        as_refs(camera_descriptor_set,
+                                                m_render_data.chunks_descriptor_set,
+                                                *tileset_descriptor_set),
+                                        to_array<u32>({ camera_current_offset }));
+
+                // one draw per chunk, an instance per non empty tile
+                for (const auto& draw : draws) cmb.draw(4, draw.tile_count, 0, draw.first_instance);
+            },
+        };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto TilemapRenderer::chunk_range(const math::fbounding_rect& bounds, i32 margin) const noexcept -> Tilemap::ChunkRange {
+        const auto chunk_width  = m_tileset.tile_size.width * as<f32>(Tilemap::CHUNK_SIZE);
+        const auto chunk_height = m_tileset.tile_size.height * as<f32>(Tilemap::CHUNK_SIZE);
+
+        const auto to_chunk = [](f32 value, f32 size) static noexcept { return as<i32>(std::floor(value / size)); };
+
+        return {
+            .min = { to_chunk(bounds.left, chunk_width) - margin, to_chunk(bounds.top, chunk_height) - margin },
+            .max = { to_chunk(bounds.right, chunk_width) + margin, to_chunk(bounds.bottom, chunk_height) + margin },
+        };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto TilemapRenderer::update_tileset(const Renderer& renderer) noexcept -> void {
+        m_tileset.applied = m_tileset.revision;
+
+        const auto texture = m_tileset.texture;
+
+        // the tileset in use hold a reference, taken before the previous one is released as they may be the same
+        if (texture != m_tileset.acquired) {
+            renderer.resources().acquire(texture);
+            if (m_tileset.acquired != INVALID_TEXTURE_ID) renderer.resources().release(m_tileset.acquired);
+            m_tileset.acquired = texture;
+        }
+
+        // only the tileset in use reference its view, the others are left to the frames in flight then recycled
+        for (auto& view : m_tileset.views) {
+            if (view.id == INVALID_TEXTURE_ID or view.id == texture) continue;
+
+            view.id      = INVALID_TEXTURE_ID;
+            view.retired = m_frame;
+        }
+
+        auto it = stdr::find(m_tileset.views, texture, &TilesetView::id);
+        if (it == stdr::end(m_tileset.views)) {
+            const auto buffering_count = renderer.buffering_count();
+
+            const auto& image  = renderer.resources().get_image(texture);
+            const auto  extent = image.extent();
+
+            auto view = TryAssert(gpu::ImageView::create(renderer.device(), image),
+                                  std::format("Failed to create image view for tileset: {}!", texture));
+            auto descriptor_set = core::allocate_unsafe<gpu::DescriptorSet>(
+              TryAssert(m_render_data.descriptor_pool->create_descriptor_set(m_render_data.tileset_descriptor_layout),
+                        std::format("Failed to create descriptor set for tileset: {}!", texture)));
+
+            descriptor_set->update(into_dyn_array<gpu::Descriptor>(gpu::ImageDescriptor {
+                                                                    .type       = gpu::DescriptorType::SAMPLED_IMAGE,
+                                                                    .binding    = 0,
+                                                                    .layout     = gpu::ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+                                                                    .image_view = as_ref(view),
+                                                                    .sampler    = as_ref(m_tileset.sampler),
+                                                                  },
+                                                                  gpu::ImageDescriptor {
+                                                                    .type       = gpu::DescriptorType::SAMPLER,
+                                                                    .binding    = 1,
+                                                                    .layout     = gpu::ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+                                                                    .image_view = as_ref(view),
+                                                                    .sampler    = as_ref(m_tileset.sampler),
+                                                                  }));
+
+            auto tileset_view = TilesetView {
+                .id             = texture,
+                .image          = as_ref(image),
+                .view           = std::move(view),
+                .descriptor_set = std::move(descriptor_set),
+                .extent         = { as<f32>(extent.width), as<f32>(extent.height) },
+            };
+
+            it = stdr::find_if(m_tileset.views, [this, buffering_count](const auto& view) noexcept {
+                return view.retired and *view.retired + buffering_count <= m_frame;
+            });
+            if (it != stdr::end(m_tileset.views)) *it = std::move(tileset_view);
+            else {
+                EXPECTS(stdr::size(m_tileset.views) < MAX_TILESET_VIEWS);
+
+                m_tileset.views.emplace_back(std::move(tileset_view));
+                it = stdr::prev(stdr::end(m_tileset.views));
+            }
+
+            dlog("Register tileset {}.", texture);
+        }
+
+        m_tileset.current = as<usize>(stdr::distance(stdr::begin(m_tileset.views), it));
+        m_tileset.columns = std::max(1u, as<u32>(it->extent.width / m_tileset.tile_extent.width));
+        m_tileset.tile_uv = { m_tileset.tile_extent.width / it->extent.width,
+                              m_tileset.tile_extent.height / it->extent.height };
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto TilemapRenderer::refresh_tileset(const Renderer& renderer) noexcept -> void {
+        const auto& resources = renderer.resources();
+
+        const auto revision = resources.revision();
+        if (revision == m_tileset.resources_revision) return;
+        m_tileset.resources_revision = revision;
+
+        // views of a placeholder are left to the frames in flight, update_tileset bind the loaded image in a new one
+        for (auto& view : m_tileset.views) {
+            if (view.id == INVALID_TEXTURE_ID or &resources.get_image(view.id) == &*view.image) continue;
+
+            if (view.id == m_tileset.texture) ++m_tileset.revision;
+            view.id      = INVALID_TEXTURE_ID;
+            view.retired = m_frame;
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto TilemapRenderer::release_slots(usize buffering_count) noexcept -> void {
+        while (not stdr::empty(m_retired_slots) and m_retired_slots.front().second + buffering_count <= m_frame) {
+            m_free_slots.emplace_back(m_retired_slots.front().first);
+            m_retired_slots.pop_front();
+        }
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto TilemapRenderer::bake(const Tilemap::Chunk& chunk) const noexcept -> std::vector<u32> {
+        const auto origin = math::fvec2 {
+            as<f32>(chunk.coord.x * Tilemap::CHUNK_SIZE) * m_tileset.tile_size.width,
+            as<f32>(chunk.coord.y * Tilemap::CHUNK_SIZE) * m_tileset.tile_size.height,
+        };
+
+        auto out = std::vector<u32> {
+            std::bit_cast<u32>(origin.x),
+            std::bit_cast<u32>(origin.y),
+            std::bit_cast<u32>(m_tileset.tile_size.width),
+            std::bit_cast<u32>(m_tileset.tile_size.height),
+            std::bit_cast<u32>(m_tileset.tile_uv.x),
+            std::bit_cast<u32>(m_tileset.tile_uv.y),
+            m_tileset.columns,
+            0u,
+        };
+        out.reserve(CHUNK_HEADER_COUNT + Tilemap::CHUNK_TILE_COUNT);
+
+        // empty tiles are skipped, the tile position in the chunk is packed with its index
+        for (auto i = 0u; i < Tilemap::CHUNK_TILE_COUNT; ++i) {
+            const auto tile = chunk.tiles[i];
+            if (tile == Tilemap::EMPTY_TILE) continue;
+
+            out.emplace_back((i % Tilemap::CHUNK_SIZE) | ((i / Tilemap::CHUNK_SIZE) << 5u) | (u32 { tile } << 16u));
+        }
+
+        out[CHUNK_HEADER_COUNT - 1] = as<u32>(stdr::size(out) - CHUNK_HEADER_COUNT);
+
+        return out;
+    }
+
+    //////////////////////////////////////
+    //////////////////////////////////////
+    auto TilemapRenderer::upload_task(FrameBuilder&                                     graph,
+                                      FrameBuilder::ResourceID                          chunks_buffer_id,
+                                      std::vector<std::pair<u32, std::vector<u32>>> uploads) noexcept -> void {
+        struct UploadChunksTaskData {
+            FrameBuilder::ResourceID                                chunks_buffer_id   = {};
+            std::array<FrameBuilder::ResourceID, MAX_CHUNK_UPLOADS> staging_buffer_ids = {};
+        };
+
+        // sizes are read before the chunks are moved in the execute closure
+        auto staging_sizes = std::array<usize, MAX_CHUNK_UPLOADS> {};
+        for (auto i = 0_usize; i < stdr::size(uploads); ++i) staging_sizes[i] = sizeof(u32) * stdr::size(uploads[i].second);
+        const auto upload_count = stdr::size(uploads);
+
+        graph.add_transfer_task<UploadChunksTaskData>(
+          UPLOAD_CHUNKS_TASK_NAME,
+          [&](auto& builder, auto& data) noexcept {
+              data.chunks_buffer_id = chunks_buffer_id;
+              builder.write_buffer(data.chunks_buffer_id);
+
+              for (auto i = 0_usize; i < upload_count; ++i) {
+                  data.staging_buffer_ids[i] = builder.create_buffer(std::format(CHUNK_STAGING_BUFFER_NAME, i),
+                                                                     {
+                                                                       .usages = gpu::BufferUsageFlag::TRANSFER_SRC,
+                                                                       .size   = staging_sizes[i],
+                                                                     });
+                  builder.write_buffer(data.staging_buffer_ids[i]);
+              }
+          },
+          [uploads = std::move(uploads)](auto& frame_resources, auto& cmb, const auto& data) noexcept {
+              const auto& chunks_buffer = frame_resources.get_buffer(data.chunks_buffer_id);
+
+              for (auto i = 0_usize; i < stdr::size(uploads); ++i) {
+                  const auto& [slot, tiles] = uploads[i];
+                  auto& staging_buffer      = frame_resources.get_buffer(data.staging_buffer_ids[i]);
+
+                  staging_buffer.upload(as_bytes(tiles));
+
+                  cmb.copy_buffer(staging_buffer, chunks_buffer, sizeof(u32) * stdr::size(tiles), slot * SLOT_SIZE);
+              }
+          });
+    }
+} // namespace stormkit::engine::pipeline_2d
@@ -27,30 +27,96 @@ namespace stormkit::engine {
         auto update = opt.get<std::optional<sol::protected_function>>("update");
         expects(update.has_value(), std::format("No update closure supplied for system {}!", name));
 
-        auto _closures = entities::System::Closures {
-            .update =
-              [update = *std::move(update)](auto& world, auto delta, const auto& entities) {
-                  lua::luacall(update, world, delta.count(), sol::as_table(entities));
-              },
+        // hashed once, the matching entities are looked up each tick
+        auto hashed = types
+                      | stdv::transform([](const auto& type) static noexcept -> entities::ComponentType { return hash(type); })
+                      | stdr::to<std::vector>();
+
+        auto labels = std::array { name + ":pre_update", name + ":update", name + ":post_update" };
+        auto system = ScriptSystem {
+            .name        = std::move(name),
+            .types       = std::move(hashed),
+            .update      = *std::move(update),
+            .pre_update  = opt.get<std::optional<sol::protected_function>>("pre_update"),
+            .post_update = opt.get<std::optional<sol::protected_function>>("post_update"),
+            .labels      = std::move(labels),
         };
 
-        auto pre_update = opt.get<std::optional<sol::protected_function>>("pre_update");
-        if (pre_update.has_value())
-            _closures.pre_update = [pre_update = *std::move(pre_update)](auto& world, const auto& entities) {
-                lua::luacall(pre_update, world, sol::as_table(entities));
-            };
-        auto post_update = opt.get<std::optional<sol::protected_function>>("post_update");
-        if (post_update.has_value())
-            _closures.post_update = [post_update = *std::move(post_update)](auto& world, const auto& entities) {
-                lua::luacall(post_update, world, sol::as_table(entities));
+        // m_systems is iterated by tick(), a system added by a script phase runs from the next tick
+        if (m_ticking) {
+            m_pending_systems.emplace_back(std::move(system));
+            return;
+        }
+
+        insert_system(std::move(system));
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto World::insert_system(ScriptSystem&& system) noexcept -> void {
+        // replaced if already registered, as a reloaded script add its systems again
+        std::erase_if(m_systems, [&system](const auto& other) noexcept { return other.name == system.name; });
+        m_systems.emplace_back(std::move(system));
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto World::tick(fsecond delta) noexcept -> void {
+        if (stdr::empty(m_systems)) return;
+
+        const auto start = Clock::now();
+        {
+            auto world    = m_world.write();
+            m_phase_world = &*world;
+            m_ticking     = true;
+
+            const auto all_entities = world->entities();
+            const auto matching     = m_systems
+                                  | stdv::transform([&](const auto& system) noexcept {
+                                        return entities_with(*world, all_entities, system.types);
+                                    })
+                                  | stdr::to<std::vector>();
+
+            const auto timed = [this](const std::string& label, auto&& call) noexcept {
+                const auto call_start = Clock::now();
+                std::invoke(std::forward<decltype(call)>(call));
+                m_profiler->record(label, Clock::now() - call_start);
             };
 
-        auto world = m_world.write();
-        world->add_system(std::move(name),
-                          types | stdv::transform([](const auto& type) static noexcept {
-                              return hash(type);
-                          }) | stdr::to<std::vector>(),
-                          std::move(_closures));
+            // same order as the native systems, every pre_update then every update then every post_update
+            for (auto i = 0_usize; i < stdr::size(m_systems); ++i) {
+                const auto& system = m_systems[i];
+                if (system.pre_update) timed(system.labels[0], [&] {
+                    lua::luacall(*system.pre_update, std::ref(*this), sol::as_table(matching[i]));
+                });
+            }
+            for (auto i = 0_usize; i < stdr::size(m_systems); ++i) {
+                const auto& system = m_systems[i];
+                timed(system.labels[1],
+                      [&] { lua::luacall(system.update, std::ref(*this), delta.count(), sol::as_table(matching[i])); });
+            }
+            for (auto i = 0_usize; i < stdr::size(m_systems); ++i) {
+                const auto& system = m_systems[i];
+                if (system.post_update) timed(system.labels[2], [&] {
+                    lua::luacall(*system.post_update, std::ref(*this), sol::as_table(matching[i]));
+                });
+            }
+
+            m_ticking     = false;
+            m_phase_world = nullptr;
+        }
+
+        for (auto&& pending : std::exchange(m_pending_systems, {}))
+            std::visit(Overloaded {
+                         [this](ScriptSystem&& system) noexcept { insert_system(std::move(system)); },
+                         [this](std::string&& name) noexcept { remove_system(name); },
+                       },
+                       std::move(pending));
+
+        m_script_stats.last     = Clock::now() - start;
+        m_script_stats.average  = (m_script_stats.ticks == 0) ? m_script_stats.last
+                                                              : (m_script_stats.average * 15 + m_script_stats.last) / 16;
+        m_script_stats.ticks   += 1;
     }
 
     ////////////////////////////////////////
@@ -61,13 +127,28 @@ namespace stormkit::engine {
                               std::string&&         window_title) noexcept -> Expected<void> {
         m_application_logger = log::Module { application_name };
 
+        const auto mounted = m_vfs.mount(DEFAULT_ASSET_PACK, stdfs::current_path());
+        // loose files stay readable in devmode so they can be edited without packing them again
+#ifdef STORMKIT_ENGINE_DEVMODE
+        m_vfs.set_loose_files(true);
+#else
+        m_vfs.set_loose_files(not mounted);
+#endif
+        if (not mounted) dlog("No {} found, reading loose files.", DEFAULT_ASSET_PACK);
+
         m_window     = wsi::Window::allocate_and_open(std::move(window_title),
                                                       window_extent,
                                                       wsi::WindowFlag::DEFAULT | wsi::WindowFlag::EXTERNAL_CONTEXT);
-        m_renderer   = Try(Renderer::create(application_name, m_thread_pool, as_opt_ref(m_window))
+        m_renderer   = Try(Renderer::create(application_name, m_thread_pool, m_vfs, as_opt_ref(m_window))
                              .transform_error([](auto) static noexcept { return ApplicationError::FailedToInitializeRenderer; }));
         m_world      = {};
-        m_lua_engine = LuaEngine::create(std::move(lua_dir));
+        m_lua_engine = LuaEngine::create(std::move(lua_dir), m_vfs);
+
+        m_lua_engine->set_bytecode_cache(BYTECODE_CACHE_DIRECTORY);
+#ifndef STORMKIT_ENGINE_DEVMODE
+        // release packs are built with precompiled scripts
+        m_lua_engine->set_bytecode_only(mounted);
+#endif
 
         set_current_thread_name("stormkit:main_thread");
 
@@ -86,8 +167,11 @@ namespace stormkit::engine {
 
             bind_world(engine_table);
 
-            engine_table["world"]     = World { world() };
+            bind_lua_profiler(engine_table);
+
+            engine_table["world"]     = World { world(), m_lua_profiler, m_schemas };
             engine_table["resources"] = std::ref(renderer().resources());
+            engine_table["profiler"]  = std::ref(m_lua_profiler);
 
             bind_common_components(engine_table);
         });
@@ -96,13 +180,18 @@ namespace stormkit::engine {
         m_render_thread     = std::jthread { bind_front(&Application::render_thread, this, std::ref(window_is_open)) };
 
         auto reload_lua = std::atomic_bool { false };
-        m_lua_thread    = std::jthread { bind_front(&Application::lua_thread, this, std::ref(reload_lua)) };
+        // count of the simulation ticks stepped, the lua thread catch up with it
+        auto tick       = std::atomic<u64> { 0 };
+        m_lua_thread    = std::jthread { bind_front(&Application::lua_thread, this, std::ref(reload_lua), std::ref(tick)) };
 
-        m_window->on<wsi::EventType::CLOSED>([this, &window_is_open] noexcept {
+        m_window->on<wsi::EventType::CLOSED>([this, &window_is_open, &tick] noexcept {
             window_is_open = false;
 
             m_render_thread.get_stop_source().request_stop();
             m_lua_thread.get_stop_source().request_stop();
+            // wake the lua thread waiting for the next tick
+            tick += 1;
+            tick.notify_all();
 
             m_render_thread.join();
             m_lua_thread.join();
@@ -115,10 +204,43 @@ namespace stormkit::engine {
                 reload_lua = true;
         });
 
-        m_window->event_loop([&] mutable {
-            m_world.write()->step(fsecond { 0 });
+        using Clock = SimulationClock::Clock;
+
+        // tick and frame build times logged every SIMULATION_STATS_PERIOD ticks
+        static constexpr auto SIMULATION_STATS_PERIOD = 600u;
 
+        m_window->event_loop([&] mutable {
+            // nothing is stepped until a whole tick has elapsed, the frame is then only interpolated
+            const auto ticks = m_simulation.advance();
+            if (ticks > 0) {
+                const auto delta = m_simulation.tick_delta();
+                {
+                    auto world = m_world.write();
+                    for (auto i : range(ticks)) {
+                        const auto tick_start = Clock::now();
+                        world->step(delta);
+                        // the systems which don't conflict run in parallel, on the thread pool, the render state is only
+                        // extracted from the last tick
+                        m_systems.step(*world, delta, m_thread_pool, i + 1 == ticks);
+                        m_simulation.record_tick(Clock::now() - tick_start);
+                    }
+                }
+
+                // the script systems run on the lua thread once the native ones have stepped, for the same ticks
+                tick += ticks;
+                tick.notify_all();
+            }
+
+            const auto render_start = Clock::now();
             m_renderer->build_frame(m_build_frame);
+            m_simulation.record_render(Clock::now() - render_start);
+
+            const auto stats = m_simulation.stats();
+            if (ticks > 0 and stats.ticks % SIMULATION_STATS_PERIOD < ticks)
+                dlog("Simulation: {:.3f} ms per tick, {:.3f} ms per frame build, {} frames without tick.",
+                     std::chrono::duration<f64, std::milli> { stats.tick_time }.count(),
+                     std::chrono::duration<f64, std::milli> { stats.render_time }.count(),
+                     stats.idle_frames);
         });
     }
 
@@ -132,11 +254,19 @@ namespace stormkit::engine {
                 m_renderer->do_render();
         }
 
-        TryAssert(m_renderer->device().wait_idle(), "Failed to wait for device idle!");
+        TryAssert(m_renderer->wait_idle(), "Failed to wait for device idle!");
         dlog("Render thread: stopped. ✓");
     }
 
-    auto Application::lua_thread(std::atomic_bool& reload_lua, std::stop_token stop_token) noexcept -> void {
+    auto Application::lua_thread(std::atomic_bool& reload_lua, std::atomic<u64>& tick, std::stop_token stop_token) noexcept
+      -> void {
+        using Clock = std::chrono::steady_clock;
+
+        // average Lua time logged every LUA_STATS_PERIOD frames
+        static constexpr auto LUA_STATS_PERIOD  = 600u;
+        // changed scripts are looked for every HOT_RELOAD_PERIOD, whatever the tick rate
+        static constexpr auto HOT_RELOAD_PERIOD = std::chrono::milliseconds { 500 };
+
         set_current_thread_name("stormkit:lua_thread");
 
         dlog("Lua thread: started. ✓");
@@ -145,12 +275,61 @@ namespace stormkit::engine {
             auto state = m_lua_engine->boot();
             reload_lua = false;
 
-            while (not reload_lua and not stop_token.stop_requested()) { std::this_thread::yield(); }
+            auto& resources = m_renderer->resources();
+            auto& world     = state["stormkit"]["world"].get<World&>();
+
+            auto seen_tick         = tick.load();
+            auto last_reload_check = Clock::now();
+            while (not reload_lua and not stop_token.stop_requested()) {
+                tick.wait(seen_tick);
+                const auto ticks = tick.load() - seen_tick;
+                seen_tick       += ticks;
+
+                const auto frame_start = Clock::now();
+
+                // callbacks of the async loads started from lua must run on this thread
+                resources.run_deferred_callbacks();
+                m_lua_profiler.record("resources:callbacks", Clock::now() - frame_start);
+
+                // changed modules are run again in the live state, F1 still reboot from an empty world
+                if (frame_start - last_reload_check >= HOT_RELOAD_PERIOD) {
+                    last_reload_check = frame_start;
+                    if (const auto count = m_lua_engine->reload_changed_modules(state); count > 0)
+                        ilog("Lua engine: {} modules hot reloaded. ✓", count);
+                }
+
+                // the simulated time of the ticks stepped since the last wake up, not the wall clock, so the scripts stay
+                // deterministic like the native systems
+                const auto delta = m_simulation.tick_delta() * as<f32>(ticks);
+
+                // only the coroutines due this frame are resumed
+                const auto scheduler_start = Clock::now();
+                m_lua_engine->scheduler().update(delta);
+                m_lua_profiler.record("scheduler:update", Clock::now() - scheduler_start);
+
+                world.tick(delta);
+
+                const auto gc_start = Clock::now();
+                m_lua_engine->heap().step(state.lua_state());
+                m_lua_profiler.record("gc:step", Clock::now() - gc_start);
+
+                m_lua_profiler.end_frame(Clock::now() - frame_start);
+
+                const auto& stats = world.script_stats();
+                if (stats.ticks > 0 and stats.ticks % LUA_STATS_PERIOD == 0)
+                    dlog("Lua systems: {:.3f} ms per frame.", std::chrono::duration<f64, std::milli> { stats.average }.count());
+            }
+            // they capture the state which is about to be destroyed
+            resources.drop_deferred_callbacks();
+            m_lua_engine->scheduler().clear();
+            m_lua_profiler.stop_sampling(state.lua_state());
 
             dlog("World: entities cleared. ✓");
-            auto world = m_world.write();
-            world->destroy_all_entities();
-            world->flush();
+            auto world_lock = m_world.write();
+            world_lock->destroy_all_entities();
+            world_lock->flush();
+            // declared again by the next boot
+            m_schemas.clear();
         }
         dlog("Lua thread: stopped. ✓");
     }
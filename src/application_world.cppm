@@ -7,34 +7,174 @@ module stormkit.engine:application.world;
 import std;
 import stormkit;
 
+import :lua_profiler;
+import :ecs.schema_components;
+import :ecs.entity_commands;
+
 namespace stdr = std::ranges;
 namespace stdv = std::views;
 
 export namespace stormkit::engine {
+    struct World;
+
+    /// Lua view of the row of a schema component, fields are read and written in place under the world lock
+    struct SchemaRef {
+        Ref<World>           world;
+        Ref<ComponentSchema> schema;
+        entities::Entity     entity;
+
+        static auto index(const SchemaRef& self, sol::this_state state, std::string_view key) noexcept -> sol::object;
+        static auto new_index(SchemaRef& self, sol::this_state state, std::string_view key, sol::object value) -> void;
+    };
+
+    /// Field of a schema component over the entities matched by World::query(), read and written in place in the schema
+    /// rows: column[i] is the field of the i-th entity. The field and the rows are resolved by the query, a row moved since
+    /// by a removal is looked up again and an entity which lost the component read as nil
+    struct FieldColumn {
+        Ref<World>                                           world;
+        Ref<ComponentSchema>                                 schema;
+        usize                                                field_index;
+        SchemaField                                          field;
+        std::shared_ptr<const std::vector<entities::Entity>> entities;
+        // row of each entity in the schema, shared by the columns of the fields of the component
+        std::shared_ptr<std::vector<u32>>                    rows;
+
+        /// row of the i-th entity, std::nullopt if it doesn't have the component or the schema was redefined since
+        auto row(usize i) const noexcept -> std::optional<u32>;
+
+        static auto index(const FieldColumn& self, sol::this_state state, usize i) noexcept -> sol::object;
+        static auto new_index(FieldColumn& self, sol::this_state state, usize i, sol::object value) -> void;
+        static auto length(const FieldColumn& self) noexcept -> usize;
+    };
+
+    /// Lua side of an EntityCommands, the components are resolved as by World::add_component() once submitted
+    struct ScriptCommands {
+        Ref<World>     world;
+        EntityCommands commands;
+
+        auto add_component(EntityCommands::Target target, sol::table component) noexcept -> void;
+        /// apply the commands in one world lock, return the made entities in make_entity() order. A component field of the
+        /// wrong type raise a lua error once every command is applied
+        auto submit(sol::this_state state) -> sol::table;
+
+        // errors of the components added by the last submit()
+        std::vector<std::string> errors;
+    };
+
+    auto read_field(sol::state_view state, const ComponentSchema& schema, u32 row, const SchemaField& field) noexcept
+      -> sol::object;
+    /// false, and the field left unchanged, if value doesn't hold the type of the field
+    auto write_field(ComponentSchema& schema, u32 row, const SchemaField& field, const sol::object& value) noexcept -> bool;
+    auto field_type_error(const ComponentSchema& schema, const SchemaField& field, const sol::object& value) noexcept
+      -> std::string;
+
+    /// Lua binding of the world. Script systems are ticked on the lua thread by tick(), which take the world lock
+    /// once for the whole phase, the bindings called from the systems then reuse it instead of locking per call.
     struct World {
-        World(Locked<entities::EntityManager>& world) noexcept : m_world { world } {}
+        using Clock = std::chrono::steady_clock;
+
+        struct ScriptSystem {
+            std::string                            name;
+            std::vector<entities::ComponentType>   types;
+            sol::protected_function                update;
+            std::optional<sol::protected_function> pre_update;
+            std::optional<sol::protected_function> post_update;
+            // profiler entries of pre_update, update and post_update
+            std::array<std::string, 3>             labels;
+        };
+
+        /// component name resolved once to its type and converter, to skip the lookups on each access
+        struct ComponentHandle {
+            std::string             name;
+            entities::ComponentType type;
+            // index in m_components_converter, std::nullopt for the components defined in lua
+            std::optional<usize>    converter;
+            // set for the components declared with define_component()
+            ComponentSchema*        schema = nullptr;
+        };
+
+        struct ScriptStats {
+            Clock::duration last    = {};
+            // exponential moving average of the phase duration
+            Clock::duration average = {};
+            u64             ticks   = 0;
+        };
+
+        World(Locked<entities::EntityManager>& world, LuaProfiler& profiler, SchemaRegistry& schemas) noexcept
+            : m_world { world }, m_profiler { as_ref_mut(profiler) }, m_schemas { as_ref_mut(schemas) } {}
+
+        template<typename F>
+        auto write_world(F&& f) noexcept -> std::invoke_result_t<F, entities::EntityManager&> {
+            // inside a script phase the lock is already held by this thread
+            if (m_phase_world != nullptr) return std::invoke(std::forward<F>(f), *m_phase_world);
 
-        auto make_entity() noexcept -> decltype(auto) {
             auto world = m_world.write();
-            return world->make_entity();
+            return std::invoke(std::forward<F>(f), *world);
+        }
+
+        template<typename F>
+        auto read_world(F&& f) const noexcept -> std::invoke_result_t<F, const entities::EntityManager&> {
+            if (m_phase_world != nullptr) return std::invoke(std::forward<F>(f), std::as_const(*m_phase_world));
+
+            auto world = m_world.read();
+            return std::invoke(std::forward<F>(f), *world);
+        }
+
+        auto make_entity() noexcept -> decltype(auto) {
+            return write_world([](auto& world) static noexcept { return world.make_entity(); });
         }
 
         auto destroy_entity(entities::Entity e) noexcept -> decltype(auto) {
-            auto world = m_world.write();
-            world->destroy_entity(e);
+            write_world([this, e](auto& world) noexcept {
+                m_schemas->remove(e);
+                world.destroy_entity(e);
+            });
         }
 
         auto destroy_all_entities() noexcept -> decltype(auto) {
-            auto world = m_world.write();
-            world->destroy_all_entities();
+            write_world([this](auto& world) noexcept {
+                m_schemas->clear_rows();
+                world.destroy_all_entities();
+            });
+        }
+
+        /// fields is a table of name = "f32" | "f64" | "i32" | "u32" | "bool" | "vec2" | "vec3" | "vec4" | "entity"
+        auto define_component(sol::this_state state, std::string name, sol::table fields) -> void {
+            // a malformed declaration is a script error, raised in the caller
+            auto declared = std::vector<std::pair<std::string, FieldType>> {};
+            for (auto&& [key, value] : fields) {
+                if (not key.is<std::string>() or not value.is<std::string>())
+                    luaL_error(state, "Fields of component %s must be declared as name = \"type\"", name.c_str());
+
+                const auto type = field_type_from_string(value.as<std::string_view>());
+                if (not type)
+                    luaL_error(state,
+                               "Unknown type %s of field %s.%s",
+                               value.as<std::string>().c_str(),
+                               name.c_str(),
+                               key.as<std::string>().c_str());
+                declared.emplace_back(key.as<std::string>(), *type);
+            }
+
+            write_world([&](auto&) noexcept { m_schemas->define(std::move(name), declared); });
         }
 
         auto has_entity(entities::Entity e) noexcept -> decltype(auto) {
-            auto world = m_world.read();
-            return world->has_entity(e);
+            return read_world([e](const auto& world) noexcept { return world.has_entity(e); });
         }
 
-        auto add_component(entities::Entity e, sol::table component) noexcept -> decltype(auto) {
+        auto add_component(sol::this_state state, entities::Entity e, sol::table component) -> void {
+            // raised once the world is unlocked
+            const auto error = write_world([&](auto& world) noexcept {
+                return add_component_to(world, e, std::move(component));
+            });
+            if (error) luaL_error(state, "%s", error->c_str());
+        }
+
+        /// add component to e in an entity manager already locked, the fields of a schema component holding a value of
+        /// the wrong type are left zeroed and reported
+        auto add_component_to(entities::EntityManager& world, entities::Entity e, sol::table component) noexcept
+          -> std::optional<std::string> {
             const auto type_closure = component.get<std::optional<sol::protected_function>>("type");
             ensures(type_closure.has_value(), "Missing type() function on lua component");
 
@@ -49,82 +189,218 @@ export namespace stormkit::engine {
             auto it = stdr::find_if(m_components_converter, [&name](const auto& converter) noexcept {
                 return converter.name == name;
             });
-            if (it != stdr::cend(m_components_converter)) {
-                const auto& converter = *it;
-                auto        world     = m_world.write();
-
-                converter.add(*world, e, component);
-            } else {
-                auto world = m_world.write();
-                world->add_component<entities::lua::LuaComponent>(e,
-                                                                  entities::lua::LuaComponent { .data  = std::move(component),
-                                                                                                ._type = _type });
-            }
+            auto error = std::optional<std::string> {};
+            if (it != stdr::cend(m_components_converter)) it->add(world, e, component);
+            else if (auto schema = m_schemas->find(name); schema != nullptr) {
+                // only the declared fields are kept, in the native row
+                const auto row = schema->add(e);
+                for (const auto& field : schema->fields()) {
+                    const auto field_value = component.get<sol::object>(field.name);
+                    if (not field_value.valid() or write_field(*schema, row, field, field_value) or error) continue;
+
+                    error = field_type_error(*schema, field, field_value);
+                }
+
+                world.template add_component<SchemaComponent>(e, SchemaComponent { ._type = _type });
+            } else
+                world.template add_component<entities::lua::LuaComponent>(e,
+                                                                          entities::lua::LuaComponent {
+                                                                            .data  = std::move(component),
+                                                                            ._type = _type });
+
+            return error;
         }
 
-        auto get_component(sol::this_state state, entities::Entity e, std::string_view name) noexcept -> sol::reference {
-            auto it = stdr::find_if(m_components_converter, [&name](const auto& converter) noexcept {
-                return converter.name == name;
+        /// record structural changes to submit them together, instead of locking the world for each of them
+        auto commands() noexcept -> ScriptCommands { return { .world = as_ref_mut(*this), .commands = {} }; }
+
+        auto submit(EntityCommands& commands) noexcept -> std::vector<entities::Entity> {
+            return write_world([&](auto& world) noexcept {
+                return commands.apply(world, [this](auto e) noexcept { m_schemas->remove(e); });
             });
-            if (it != stdr::cend(m_components_converter)) {
-                const auto& converter = *it;
-                auto        world     = m_world.write();
+        }
 
-                return converter.get(sol::state_view { state }, *world, e);
-            }
+        auto component_handle(std::string_view name) const noexcept -> ComponentHandle {
+            const auto it = stdr::find_if(m_components_converter, [&name](const auto& converter) noexcept {
+                return converter.name == name;
+            });
+            if (it == stdr::cend(m_components_converter))
+                return { .name      = std::string { name },
+                         .type      = hash(name),
+                         .converter = std::nullopt,
+                         .schema    = read_world([&](const auto&) noexcept { return m_schemas->find(name); }) };
+
+            return { .name      = std::string { name },
+                     .type      = hash(name),
+                     .converter = as<usize>(stdr::distance(stdr::cbegin(m_components_converter), it)) };
+        }
 
-            auto world = m_world.write();
-            return world->get_component<entities::lua::LuaComponent>(e, name).data;
+        auto get_component(sol::this_state state, entities::Entity e, std::string_view name) noexcept -> sol::reference {
+            return get_component(state, e, component_handle(name));
         }
 
         auto get_component(sol::this_state state, entities::Entity e, std::string_view name) const noexcept -> sol::reference {
-            auto it = stdr::find_if(m_components_converter, [&name](const auto& converter) noexcept {
-                return converter.name == name;
-            });
-            if (it != stdr::cend(m_components_converter)) {
-                const auto& converter = *it;
-                auto        world     = m_world.read();
+            return get_component(state, e, component_handle(name));
+        }
+
+        auto get_component(sol::this_state state, entities::Entity e, const ComponentHandle& handle) noexcept
+          -> sol::reference {
+            return write_world([&](auto& world) noexcept { return resolve(sol::state_view { state }, world, e, handle); });
+        }
+
+        auto get_component(sol::this_state state, entities::Entity e, const ComponentHandle& handle) const noexcept
+          -> sol::reference {
+            return read_world([&](const auto& world) noexcept { return resolve(sol::state_view { state }, world, e, handle); });
+        }
 
-                return converter.get_const(sol::state_view { state }, *world, e);
+        template<typename EntityManager>
+            requires(std::same_as<std::remove_const_t<EntityManager>, entities::EntityManager>)
+        auto resolve(sol::state_view        state,
+                     EntityManager&         world,
+                     entities::Entity       e,
+                     const ComponentHandle& handle) const noexcept -> sol::reference {
+            if (handle.converter) {
+                const auto& converter = m_components_converter[*handle.converter];
+                if constexpr (std::is_const_v<EntityManager>) return converter.get_const(state, world, e);
+                else
+                    return converter.get(state, world, e);
             }
 
-            auto world = m_world.read();
-            return world->get_component<entities::lua::LuaComponent>(e, name).data;
+            if (handle.schema != nullptr) {
+                if (not handle.schema->row_of(e)) return sol::make_reference(state, sol::lua_nil);
+
+                return sol::make_reference(state,
+                                           SchemaRef { .world  = as_ref_mut(const_cast<World&>(*this)),
+                                                       .schema = as_ref_mut(*handle.schema),
+                                                       .entity = e });
+            }
+
+            return world.template get_component<entities::lua::LuaComponent>(e, handle.type).data;
+        }
+
+        /// entities having every component of the set, in one lock, with a column per name:
+        /// { count = n, entities = { e1, ... }, [name] = column, ... }
+        /// A component declared with define_component() get a table of FieldColumn, one per field, reading the schema rows
+        /// in place (query.Velocity.x[i]). The native and table components can't be laid out as columns, they get a table
+        /// of references to the components, one per entity.
+        auto query(sol::this_state state, std::vector<std::string> names) noexcept -> sol::table {
+            const auto handles = names
+                                 | stdv::transform([this](const auto& name) noexcept { return component_handle(name); })
+                                 | stdr::to<std::vector>();
+            const auto types = handles | stdv::transform(&ComponentHandle::type) | stdr::to<std::vector>();
+
+            return write_world([&](auto& world) noexcept {
+                auto lua = sol::state_view { state };
+
+                // the smallest schema of the set bound the candidates, instead of every entity of the world
+                auto candidates = std::span<const entities::Entity> {};
+                auto narrowed   = false;
+                for (const auto& handle : handles) {
+                    if (handle.schema == nullptr) continue;
+                    if (narrowed and handle.schema->size() >= stdr::size(candidates)) continue;
+
+                    candidates = handle.schema->entities();
+                    narrowed   = true;
+                }
+                const auto all_entities = narrowed ? std::vector<entities::Entity> {} : world.entities();
+                if (not narrowed) candidates = all_entities;
+
+                const auto matching = std::make_shared<const std::vector<entities::Entity>>(
+                  entities_with(world, candidates, types));
+                const auto count = stdr::size(*matching);
+
+                auto entities = lua.create_table(as<i32>(count), 0);
+                for (auto i = 0_usize; i < count; ++i) entities[i + 1] = (*matching)[i];
+
+                auto result        = lua.create_table(0, as<i32>(stdr::size(handles)) + 2);
+                result["count"]    = count;
+                result["entities"] = entities;
+
+                for (const auto& handle : handles) {
+                    if (handle.schema != nullptr) {
+                        auto rows = std::make_shared<std::vector<u32>>(*matching
+                                                                       | stdv::transform([&](const auto e) noexcept {
+                                                                             return *handle.schema->row_of(e);
+                                                                         })
+                                                                       | stdr::to<std::vector>());
+
+                        const auto fields  = handle.schema->fields();
+                        auto       columns = lua.create_table(0, as<i32>(stdr::size(fields)));
+                        for (auto i = 0_usize; i < stdr::size(fields); ++i)
+                            columns[fields[i].name] = FieldColumn { .world       = as_ref_mut(*this),
+                                                                    .schema      = as_ref_mut(*handle.schema),
+                                                                    .field_index = i,
+                                                                    .field       = fields[i],
+                                                                    .entities    = matching,
+                                                                    .rows        = rows };
+                        result[handle.name] = columns;
+                        continue;
+                    }
+
+                    auto column = lua.create_table(as<i32>(count), 0);
+                    for (auto i = 0_usize; i < count; ++i) column[i + 1] = resolve(lua, world, (*matching)[i], handle);
+                    result[handle.name] = column;
+                }
+
+                return result;
+            });
+        }
+
+        static auto entities_with(const entities::EntityManager&         world,
+                                  std::span<const entities::Entity>        candidates,
+                                  std::span<const entities::ComponentType> types) noexcept -> std::vector<entities::Entity> {
+            return candidates
+                   | stdv::filter([&](const auto& e) noexcept {
+                         return stdr::all_of(types, [&](const auto type) noexcept { return world.has_component(e, type); });
+                     })
+                   | stdr::to<std::vector>();
         }
 
         auto has_component(entities::Entity entity, std::string_view name) noexcept -> decltype(auto) {
-            auto world = m_world.read();
-            return world->has_component(entity, name);
+            return read_world([&](const auto& world) noexcept { return world.has_component(entity, name); });
         }
 
         auto entities() noexcept -> decltype(auto) {
-            auto world = m_world.read();
-            return world->entities();
+            return read_world([](const auto& world) static noexcept { return world.entities(); });
         }
 
         auto entity_count() noexcept -> decltype(auto) {
-            auto world = m_world.read();
-            return world->entity_count();
+            return read_world([](const auto& world) static noexcept { return world.entity_count(); });
         }
 
         auto components_types_of(entities::Entity e) noexcept -> decltype(auto) {
-            auto world = m_world.read();
-            return world->components_types_of(e);
+            return read_world([e](const auto& world) noexcept { return world.components_types_of(e); });
         }
 
         auto add_system(std::string name, std::vector<std::string> types, sol::table opt) noexcept -> void;
+        auto insert_system(ScriptSystem&& system) noexcept -> void;
 
-        auto has_system(std::string_view name) noexcept -> decltype(auto) {
-            auto world = m_world.read();
-            return world->has_system(name);
+        auto has_system(std::string_view name) noexcept -> bool {
+            if (stdr::contains(m_systems, name, &ScriptSystem::name)) return true;
+
+            return read_world([name](const auto& world) noexcept { return world.has_system(name); });
         }
 
-        auto remove_system(std::string_view name) noexcept -> decltype(auto) {
-            auto world = m_world.write();
-            world->remove_system(name);
+        auto remove_system(std::string_view name) noexcept -> void {
+            // m_systems is iterated by tick(), a system removed by a script phase is removed after post_update
+            if (m_ticking) {
+                m_pending_systems.emplace_back(std::string { name });
+                return;
+            }
+
+            if (std::erase_if(m_systems, [name](const auto& system) noexcept { return system.name == name; }) > 0) return;
+
+            write_world([name](auto& world) noexcept { world.remove_system(name); });
         }
 
+        /// run the script systems, called once per frame on the lua thread
+        auto tick(fsecond delta) noexcept -> void;
+
+        auto script_stats() const noexcept -> const ScriptStats& { return m_script_stats; }
+
         Locked<entities::EntityManager>& m_world;
+        Ref<LuaProfiler>                 m_profiler;
+        Ref<SchemaRegistry>              m_schemas;
 
         struct ComponentConverter {
             std::string                                                                                      name;
@@ -136,9 +412,65 @@ export namespace stormkit::engine {
         using ComponentConverters = std::vector<ComponentConverter>;
 
         ComponentConverters m_components_converter;
+
+        std::vector<ScriptSystem> m_systems;
+        // systems added (or removed by name) while tick() runs the phases, applied in order once they are done
+        std::vector<std::variant<ScriptSystem, std::string>> m_pending_systems;
+        bool                                                 m_ticking = false;
+        ScriptStats                                          m_script_stats;
+        // world locked by tick(), only set on the lua thread
+        entities::EntityManager*  m_phase_world = nullptr;
     };
 
     auto bind_world(sol::table& entities) noexcept -> void {
+        entities.new_usertype<World::ComponentHandle>("component_handle",
+                                                      sol::no_constructor,
+                                                      "name",
+                                                      sol::readonly(&World::ComponentHandle::name));
+
+        entities.new_usertype<SchemaRef>("schema_component",
+                                         sol::no_constructor,
+                                         sol::meta_function::index,
+                                         &SchemaRef::index,
+                                         sol::meta_function::new_index,
+                                         &SchemaRef::new_index);
+
+        entities.new_usertype<FieldColumn>("field_column",
+                                           sol::no_constructor,
+                                           sol::meta_function::index,
+                                           &FieldColumn::index,
+                                           sol::meta_function::new_index,
+                                           &FieldColumn::new_index,
+                                           sol::meta_function::length,
+                                           &FieldColumn::length);
+
+        entities.new_usertype<PendingEntity>("pending_entity",
+                                             sol::no_constructor,
+                                             "index",
+                                             sol::readonly(&PendingEntity::index));
+
+        auto commands = entities.new_usertype<ScriptCommands>("entity_commands", sol::no_constructor);
+
+        commands["make_entity"]    = [](ScriptCommands& self) static noexcept { return self.commands.make_entity(); };
+        commands["destroy_entity"] = [](ScriptCommands& self, entities::Entity e) static noexcept {
+            self.commands.destroy_entity(e);
+        };
+        commands.set_function("add_component",
+                              sol::overload(
+                                [](sol::this_state state, ScriptCommands& self, PendingEntity e, sol::table component) static {
+                                    if (not self.commands.owns(e))
+                                        luaL_error(state,
+                                                   "pending entity %u was not made by these commands, or they were already "
+                                                   "submitted",
+                                                   e.index);
+                                    self.add_component(e, std::move(component));
+                                },
+                                [](ScriptCommands& self, entities::Entity e, sol::table component) static noexcept {
+                                    self.add_component(e, std::move(component));
+                                }));
+        commands["submit"] = &ScriptCommands::submit;
+        commands["size"]   = [](const ScriptCommands& self) static noexcept { return self.commands.size(); };
+
         auto world = [&entities]() { return entities.new_usertype<World>("world", sol::no_constructor); }();
 
         world["make_entity"]          = &World::make_entity;
@@ -146,12 +478,19 @@ export namespace stormkit::engine {
         world["destroy_all_entities"] = &World::destroy_all_entities;
         world["has_entity"]           = &World::has_entity;
         world["add_component"]        = &World::add_component;
+        world["define_component"]     = &World::define_component;
+        world["commands"]             = &World::commands;
         world.set_function("get_component",
                            sol::overload(sol::resolve<sol::reference(sol::this_state,
                                                                      entities::Entity,
                                                                      std::string_view)>(&World::get_component),
                                          sol::resolve<sol::reference(sol::this_state, entities::Entity, std::string_view)
-                                                        const>(&World::get_component)));
+                                                        const>(&World::get_component),
+                                         sol::resolve<sol::reference(sol::this_state,
+                                                                     entities::Entity,
+                                                                     const World::ComponentHandle&)>(&World::get_component)));
+        world["component"]           = &World::component_handle;
+        world["query"]               = &World::query;
         world["has_component"]       = &World::has_component;
         world["entities"]            = &World::entities;
         world["entity_count"]        = &World::entity_count;
@@ -159,6 +498,176 @@ export namespace stormkit::engine {
         world["add_system"]          = &World::add_system;
         world["has_system"]          = &World::has_system;
         world["remove_system"]       = &World::remove_system;
+        world["script_time"]         = [](const World& world) static noexcept {
+            return std::chrono::duration<f64, std::milli> { world.script_stats().average }.count();
+        };
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto read_field(sol::state_view state, const ComponentSchema& schema, u32 row, const SchemaField& field) noexcept
+      -> sol::object {
+        switch (field.type) {
+            case FieldType::F32: return sol::make_object(state, schema.get<f32>(row, field));
+            case FieldType::F64: return sol::make_object(state, schema.get<f64>(row, field));
+            case FieldType::I32: return sol::make_object(state, schema.get<i32>(row, field));
+            case FieldType::U32: return sol::make_object(state, schema.get<u32>(row, field));
+            case FieldType::BOOL: return sol::make_object(state, schema.get<bool>(row, field));
+            case FieldType::VEC2: return sol::make_object(state, schema.get<math::fvec2>(row, field));
+            case FieldType::VEC3: return sol::make_object(state, schema.get<math::fvec3>(row, field));
+            case FieldType::VEC4: return sol::make_object(state, schema.get<math::fvec4>(row, field));
+            case FieldType::ENTITY: return sol::make_object(state, schema.get<entities::Entity>(row, field));
+        }
+        std::unreachable();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto write_field(ComponentSchema& schema, u32 row, const SchemaField& field, const sol::object& value) noexcept
+      -> bool {
+        const auto write = [&]<typename T>(std::type_identity<T>) noexcept {
+            if (not value.is<T>()) return false;
+
+            schema.get<T>(row, field) = value.as<T>();
+            return true;
+        };
+
+        switch (field.type) {
+            case FieldType::F32: return write(std::type_identity<f32> {});
+            case FieldType::F64: return write(std::type_identity<f64> {});
+            case FieldType::I32: return write(std::type_identity<i32> {});
+            case FieldType::U32: return write(std::type_identity<u32> {});
+            case FieldType::BOOL: return write(std::type_identity<bool> {});
+            case FieldType::VEC2: return write(std::type_identity<math::fvec2> {});
+            case FieldType::VEC3: return write(std::type_identity<math::fvec3> {});
+            case FieldType::VEC4: return write(std::type_identity<math::fvec4> {});
+            case FieldType::ENTITY: return write(std::type_identity<entities::Entity> {});
+        }
+        std::unreachable();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto field_type_error(const ComponentSchema& schema, const SchemaField& field, const sol::object& value) noexcept
+      -> std::string {
+        return std::format("Field {}.{} can't hold a {} value",
+                           schema.name(),
+                           field.name,
+                           sol::type_name(value.lua_state(), value.get_type()));
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto SchemaRef::index(const SchemaRef& self, sol::this_state state, std::string_view key) noexcept
+      -> sol::object {
+        if (key == "entity") return sol::make_object(state, self.entity);
+
+        return self.world->read_world([&](const auto&) noexcept -> sol::object {
+            const auto* field = self.schema->field(key);
+            const auto  row   = self.schema->row_of(self.entity);
+            if (field == nullptr or not row) return sol::lua_nil;
+
+            return read_field(state, *self.schema, *row, *field);
+        });
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto SchemaRef::new_index(SchemaRef& self, sol::this_state state, std::string_view key, sol::object value) -> void {
+        // raised once the world is unlocked
+        const auto error = self.world->write_world([&](auto&) noexcept -> std::optional<std::string> {
+            const auto* field = self.schema->field(key);
+            if (field == nullptr) return std::format("{} has no field {}", self.schema->name(), key);
+
+            const auto row = self.schema->row_of(self.entity);
+            if (row and not write_field(*self.schema, *row, *field, value))
+                return field_type_error(*self.schema, *field, value);
+
+            return std::nullopt;
+        });
+        if (error) luaL_error(state, "%s", error->c_str());
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto FieldColumn::row(usize i) const noexcept -> std::optional<u32> {
+        // a redefinition may have moved the field, its new layout isn't the one the column was made for
+        const auto fields = schema->fields();
+        if (field_index >= stdr::size(fields) or fields[field_index].type != field.type
+            or fields[field_index].offset != field.offset)
+            return std::nullopt;
+
+        const auto e               = (*entities)[i];
+        auto&      cached          = (*rows)[i];
+        const auto schema_entities = schema->entities();
+        if (cached < stdr::size(schema_entities) and schema_entities[cached] == e) return cached;
+
+        const auto row = schema->row_of(e);
+        if (row) cached = *row;
+
+        return row;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto FieldColumn::index(const FieldColumn& self, sol::this_state state, usize i) noexcept -> sol::object {
+        if (i < 1 or i > stdr::size(*self.entities)) return sol::lua_nil;
+
+        return self.world->read_world([&](const auto&) noexcept -> sol::object {
+            const auto row = self.row(i - 1);
+            if (not row) return sol::lua_nil;
+
+            return read_field(state, *self.schema, *row, self.field);
+        });
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto FieldColumn::new_index(FieldColumn& self, sol::this_state state, usize i, sol::object value) -> void {
+        if (i < 1 or i > stdr::size(*self.entities))
+            luaL_error(state, "Index %zu out of the %zu entities of the column", i, stdr::size(*self.entities));
+
+        // raised once the world is unlocked
+        const auto error = self.world->write_world([&](auto&) noexcept -> std::optional<std::string> {
+            const auto row = self.row(i - 1);
+            if (row and not write_field(*self.schema, *row, self.field, value))
+                return field_type_error(*self.schema, self.field, value);
+
+            return std::nullopt;
+        });
+        if (error) luaL_error(state, "%s", error->c_str());
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto FieldColumn::length(const FieldColumn& self) noexcept -> usize {
+        return stdr::size(*self.entities);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto ScriptCommands::add_component(EntityCommands::Target target, sol::table component) noexcept -> void {
+        // this is the lua userdata, it outlive the commands it holds
+        commands.add_component(target, [this, component = std::move(component)](auto& manager, auto e) noexcept {
+            if (auto error = world->add_component_to(manager, e, component); error) errors.emplace_back(*std::move(error));
+        });
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    inline auto ScriptCommands::submit(sol::this_state state) -> sol::table {
+        const auto made = world->submit(commands);
+
+        if (not stdr::empty(errors)) {
+            const auto message = std::format("{} component errors, first: {}", stdr::size(errors), errors.front());
+            errors.clear();
+            luaL_error(state, "%s", message.c_str());
+        }
+
+        auto out = sol::state_view { state }.create_table(as<i32>(stdr::size(made)), 0);
+        for (auto i = 0_usize; i < stdr::size(made); ++i) out[i + 1] = made[i];
+
+        return out;
     }
 
     template<entities::meta::IsComponentType T>
@@ -0,0 +1,62 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :ecs.entity_commands;
+
+namespace stdr = std::ranges;
+
+namespace stormkit::engine {
+    namespace {
+        // 0 is never given, a value initialized PendingEntity is owned by no commands
+        constinit auto next_commands_id = std::atomic<u32> { 1 };
+    } // namespace
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    EntityCommands::EntityCommands() noexcept : m_id { next_commands_id.fetch_add(1, std::memory_order_relaxed) } {
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto EntityCommands::apply(entities::EntityManager& world, FunctionRef<void(entities::Entity)> on_destroy) noexcept
+      -> std::vector<entities::Entity> {
+        auto made = std::vector<entities::Entity> {};
+        made.reserve(m_made);
+        for (auto _ : range(m_made)) made.emplace_back(world.make_entity());
+
+        for (auto& [target, add] : m_adds) {
+            const auto e = std::visit(Overloaded {
+                                        [](entities::Entity e) static noexcept { return e; },
+                                        [&made](PendingEntity pending) noexcept { return made[pending.index]; },
+                                      },
+                                      target);
+            std::invoke(add, world, e);
+        }
+
+        for (const auto e : m_destroyed) {
+            on_destroy(e);
+            world.destroy_entity(e);
+        }
+
+        clear();
+
+        return made;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto EntityCommands::clear() noexcept -> void {
+        // the pending entities handed out so far can't be resolved anymore
+        m_generation += 1;
+        m_made        = 0;
+        m_adds.clear();
+        m_destroyed.clear();
+    }
+} // namespace stormkit::engine
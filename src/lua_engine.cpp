@@ -0,0 +1,297 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+
+#include <stormkit/log/log_macro.hpp>
+
+#include <stormkit/lua/lua.hpp>
+
+#include <luacode.h>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :vfs;
+import :lua_engine;
+
+namespace stdfs = std::filesystem;
+namespace stdr  = std::ranges;
+
+namespace stormkit::engine {
+    LOGGER("lua")
+
+    namespace {
+        // registry key of the table of the modules already run by require()
+        constexpr auto LOADED_MODULES     = "stormkit.loaded_modules";
+        constexpr auto OPTIMIZATION_LEVEL = 1;
+        // line info is kept for the error messages and the tracebacks
+        constexpr auto DEBUG_LEVEL        = 1;
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto fnv1a(std::string_view bytes, u64 hash = u64 { 0xcbf29ce484222325 }) noexcept -> u64 {
+            for (const auto character : bytes) {
+                hash ^= as<u8>(character);
+                hash *= u64 { 0x100000001b3 };
+            }
+
+            return hash;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto bytecode_key(std::string_view source) noexcept -> u64 {
+            // the bytecode of an empty chunk carries the bytecode version, a compiler upgrade invalidate the cache
+            static const auto COMPILER_HASH = [] static noexcept {
+                const auto options = std::format("O{}g{}", OPTIMIZATION_LEVEL, DEBUG_LEVEL);
+                return fnv1a(LuaEngine::compile("").value_or(""), fnv1a(options));
+            }();
+
+            return fnv1a(source, COMPILER_HASH);
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto write_time_of(const stdfs::path& path) noexcept -> stdfs::file_time_type {
+            auto       error      = std::error_code {};
+            const auto write_time = stdfs::last_write_time(path, error);
+
+            return error ? stdfs::file_time_type {} : write_time;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto as_file_data(std::string&& bytes) noexcept -> FileData {
+            auto       storage = std::make_shared<const std::string>(std::move(bytes));
+            const auto data    = std::as_bytes(std::span { *storage });
+            return FileData { .storage = std::move(storage), .data = data };
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto write_file(const stdfs::path& path, std::string_view bytes) noexcept -> bool {
+            // written aside then renamed, a crash never leave a truncated file in the cache
+            auto temporary  = path;
+            temporary      += ".tmp";
+            {
+                auto file = std::ofstream { temporary, std::ios::binary | std::ios::trunc };
+                file.write(stdr::data(bytes), as<std::streamsize>(stdr::size(bytes)));
+                if (not file) return false;
+            }
+
+            auto error = std::error_code {};
+            stdfs::rename(temporary, path, error);
+
+            return not error;
+        }
+    } // namespace
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaEngine::boot() -> sol::state {
+        m_modules.clear();
+        m_scheduler.clear();
+        // the previous state is closed, its pools can be released
+        m_heap.reset();
+
+        // the state is created by lua_newstate(&LuaHeap::allocate, &m_heap), its first allocation come from the heap too
+        auto global_state = sol::state { sol::default_at_panic, &LuaHeap::allocate, &m_heap };
+        global_state.open_libraries();
+        lua::Engine::bind_modules(global_state,
+                                  {
+                                    .log      = true,
+                                    .image    = true,
+                                    .entities = true,
+                                    .wsi      = true,
+                                    .gpu      = true,
+                                  });
+
+        bind_require(global_state);
+        m_scheduler.bind(global_state);
+        m_heap.bind(global_state);
+        for (auto&& binder : m_binders) binder(global_state);
+
+        m_heap.attach(global_state.lua_state());
+
+        // boot.lua goes through require() like any module, so it is loaded from the bytecode too
+        if (const auto result = global_state["require"].get<sol::protected_function>()("boot"); not result.valid())
+            ensures(false, std::format("Failed to boot lua: {}", result.get<sol::error>().what()));
+
+        return global_state;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaEngine::compile(std::string_view source) noexcept -> std::expected<std::string, std::string> {
+        auto options              = lua_CompileOptions {};
+        options.optimizationLevel = OPTIMIZATION_LEVEL;
+        options.debugLevel        = DEBUG_LEVEL;
+
+        auto  size = std::size_t { 0 };
+        auto* data = luau_compile(stdr::data(source), stdr::size(source), &options, &size);
+        if (data == nullptr) return std::unexpected { std::string { "out of memory" } };
+
+        auto bytecode = std::string { data, size };
+        std::free(data);
+
+        // a failed compilation is encoded as a 0 version byte followed by the error message
+        if (stdr::empty(bytecode) or bytecode.front() == '\0') return std::unexpected { bytecode.substr(1) };
+
+        return bytecode;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaEngine::reload_changed_modules(sol::state& global_state) noexcept -> usize {
+        // packed or precompiled scripts can't change
+        if (m_bytecode_only or not m_vfs->loose_files()) return 0;
+
+        auto changed = std::vector<std::string> {};
+        for (auto& [name, module] : m_modules) {
+            const auto write_time = write_time_of(module.path);
+            if (write_time == module.write_time) continue;
+
+            module.write_time = write_time;
+            changed.emplace_back(name);
+        }
+        if (stdr::empty(changed)) return 0;
+
+        auto loaded = global_state.registry().get<sol::table>(LOADED_MODULES);
+        auto engine = global_state["stormkit"].get_or_create<sol::table>();
+        auto count  = 0_usize;
+
+        engine["reloading"] = true;
+        for (const auto& name : changed) {
+            // the module may have required new modules, m_modules can't be iterated here
+            const auto path   = m_modules[name].path;
+            const auto result = run_module(global_state, path);
+            if (not result) {
+                elog("Failed to reload lua module {}, the previous version is kept: {}", name, result.error());
+                continue;
+            }
+
+            // tables are patched in place, so the modules which required this one see the new functions
+            auto previous = loaded.get<sol::object>(name);
+            if (previous.is<sol::table>() and result->is<sol::table>()) {
+                auto table = previous.as<sol::table>();
+                for (auto&& [key, value] : result->as<sol::table>()) table[key] = value;
+            } else
+                loaded[name] = *result;
+
+            dlog("Lua module {} reloaded.", name);
+            ++count;
+        }
+        engine["reloading"] = false;
+
+        return count;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaEngine::bind_require(sol::state& global_state) noexcept -> void {
+        // a module run once per state, later require() return the cached result
+        auto loaded = global_state.create_table();
+        global_state.registry()[LOADED_MODULES] = loaded;
+        global_state.set_function("require",
+                                  [this, loaded](sol::this_state state, const std::string& name) mutable -> sol::object {
+                                      if (auto module = loaded.get<sol::object>(name); module != sol::lua_nil) return module;
+
+                                      auto file_name = name;
+                                      stdr::replace(file_name, '.', '/');
+                                      auto path  = m_lua_dir / file_name;
+                                      path      += ".lua";
+
+                                      // raised in the caller, a missing or broken module doesn't take the engine down
+                                      const auto module = run_module(state, path);
+                                      if (not module)
+                                          luaL_error(state,
+                                                     "Failed to run lua module %s: %s",
+                                                     name.c_str(),
+                                                     module.error().c_str());
+
+                                      loaded[name]    = *module;
+                                      m_modules[name] = { .path = path, .write_time = write_time_of(path) };
+
+                                      return *module;
+                                  });
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaEngine::run_module(sol::state_view state, const stdfs::path& path) const
+      -> std::expected<sol::object, std::string> {
+        const auto chunk = load_chunk(state, path);
+        if (not chunk) return std::unexpected { chunk.error() };
+
+        const auto result = (*chunk)();
+        if (not result.valid()) return std::unexpected { std::string { result.get<sol::error>().what() } };
+
+        return result.return_count() > 0 ? result.get<sol::object>() : sol::make_object(state, true);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaEngine::load_chunk(sol::state_view state, const stdfs::path& path) const
+      -> std::expected<sol::protected_function, std::string> {
+        const auto bytecode = read_bytecode(path);
+        if (not bytecode) return std::unexpected { bytecode.error() };
+
+        auto*      lua_state  = state.lua_state();
+        const auto chunk_name = std::format("@{}", path.generic_string());
+        const auto source     = bytecode->as_string_view();
+        if (luau_load(lua_state, chunk_name.c_str(), stdr::data(source), stdr::size(source), 0) != 0) {
+            auto error = std::string { lua_tostring(lua_state, -1) };
+            lua_pop(lua_state, 1);
+            return std::unexpected { std::move(error) };
+        }
+
+        auto chunk = sol::protected_function { lua_state, -1 };
+        lua_pop(lua_state, 1);
+
+        return chunk;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaEngine::read_bytecode(const stdfs::path& path) const noexcept -> std::expected<FileData, std::string> {
+        if (m_bytecode_only) {
+            auto bytecode_path = path;
+            bytecode_path.replace_extension(BYTECODE_EXTENSION);
+
+            auto bytecode = m_vfs->read(bytecode_path);
+            if (not bytecode) return std::unexpected { std::format("{} not found", bytecode_path.string()) };
+
+            return *std::move(bytecode);
+        }
+
+        const auto source = m_vfs->read(path);
+        if (not source) return std::unexpected { std::format("{} not found", path.string()) };
+
+        const auto cached = m_bytecode_cache.empty()
+                              ? stdfs::path {}
+                              : m_bytecode_cache
+                                  / std::format("{:016x}{}", bytecode_key(source->as_string_view()), BYTECODE_EXTENSION);
+        if (not cached.empty())
+            if (auto bytecode = map_file(cached); bytecode) return *std::move(bytecode);
+
+        auto bytecode = compile(source->as_string_view());
+        if (not bytecode) return std::unexpected { std::move(bytecode).error() };
+
+        if (not cached.empty()) {
+            auto error = std::error_code {};
+            stdfs::create_directories(m_bytecode_cache, error);
+            if (error or not write_file(cached, *bytecode)) wlog("Failed to write bytecode cache {}!", cached.string());
+            else
+                dlog("Compiled {} in {}.", path.string(), cached.string());
+        }
+
+        return as_file_data(*std::move(bytecode));
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,206 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/log/log_macro.hpp>
+
+#include <stormkit/lua/lua.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :lua_heap;
+
+namespace stormkit::engine {
+    LOGGER("lua")
+
+    namespace {
+        constexpr auto NO_SIZE_CLASS = LuaHeap::SIZE_CLASS_COUNT;
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto size_class_of(usize size) noexcept -> usize {
+            if (size > LuaHeap::MAX_BLOCK_SIZE) return NO_SIZE_CLASS;
+
+            return as<usize>(std::bit_width(std::max(size, LuaHeap::MIN_BLOCK_SIZE) - 1))
+                   - as<usize>(std::countr_zero(LuaHeap::MIN_BLOCK_SIZE));
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto block_size_of(usize size_class) noexcept -> usize {
+            return LuaHeap::MIN_BLOCK_SIZE << size_class;
+        }
+
+        static_assert(size_class_of(1) == 0);
+        static_assert(size_class_of(16) == 0);
+        static_assert(size_class_of(17) == 1);
+        static_assert(size_class_of(LuaHeap::MAX_BLOCK_SIZE) == LuaHeap::SIZE_CLASS_COUNT - 1);
+        static_assert(block_size_of(LuaHeap::SIZE_CLASS_COUNT - 1) == LuaHeap::MAX_BLOCK_SIZE);
+    } // namespace
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaHeap::allocate(void* user_data, void* pointer, std::size_t old_size, std::size_t new_size) noexcept -> void* {
+        auto& heap = *static_cast<LuaHeap*>(user_data);
+
+        if (new_size == 0) {
+            if (pointer != nullptr) heap.free_block(pointer, old_size);
+            return nullptr;
+        }
+
+        if (pointer == nullptr) return heap.allocate_block(new_size);
+
+        // the block already fits, or both are big enough to let realloc grow them in place
+        const auto old_class = size_class_of(old_size);
+        const auto new_class = size_class_of(new_size);
+        if (old_class == new_class) {
+            if (old_class == NO_SIZE_CLASS) {
+                pointer = std::realloc(pointer, new_size);
+                if (pointer == nullptr) return nullptr;
+            }
+
+            heap.m_stats.live_bytes = heap.m_stats.live_bytes - old_size + new_size;
+            heap.m_stats.peak_bytes = std::max(heap.m_stats.peak_bytes, heap.m_stats.live_bytes);
+            return pointer;
+        }
+
+        auto* result = heap.allocate_block(new_size);
+        if (result == nullptr) return nullptr;
+
+        std::memcpy(result, pointer, std::min(old_size, new_size));
+        heap.free_block(pointer, old_size);
+
+        return result;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaHeap::attach(lua_State* state) noexcept -> void {
+        lua_gc(state, LUA_GCSTOP, 0);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaHeap::reset() noexcept -> void {
+        m_free_lists = {};
+        m_chunks.clear();
+
+        m_stats              = {};
+        *m_published.write() = {};
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaHeap::step(lua_State* state) noexcept -> void {
+        const auto start = Clock::now();
+
+        if (m_stats.live_bytes > m_gc_limit) {
+            lua_gc(state, LUA_GCCOLLECT, 0);
+            m_stats.collections += 1;
+            m_stats.forced      += 1;
+        } else
+            // a step collect about DEFAULT_GC_STEP KB, the cycle is never restarted in the same frame
+            while (Clock::now() - start < m_gc_budget)
+                if (lua_gc(state, LUA_GCSTEP, DEFAULT_GC_STEP) != 0) {
+                    m_stats.collections += 1;
+                    break;
+                }
+
+        // LUA_GCSTEP and LUA_GCCOLLECT set GCthreshold back to a reachable value, the automatic collector is stopped again
+        attach(state);
+
+        m_stats.last_pause = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        m_stats.max_pause  = std::max(m_stats.max_pause, m_stats.last_pause);
+
+        *m_published.write() = m_stats;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaHeap::bind(sol::state& global_state) noexcept -> void {
+        auto engine = global_state["stormkit"].get_or_create<sol::table>();
+        auto memory = engine["memory"].get_or_create<sol::table>();
+
+        memory.set_function("stats", [this](sol::this_state state) noexcept {
+            const auto stats = this->stats();
+
+            auto table            = sol::state_view { state }.create_table();
+            table["live_bytes"]   = stats.live_bytes;
+            table["peak_bytes"]   = stats.peak_bytes;
+            table["pooled_bytes"] = stats.pooled_bytes;
+            table["allocations"]  = stats.allocations;
+            table["collections"]  = stats.collections;
+            table["forced"]       = stats.forced;
+            table["last_pause"]   = stats.last_pause.count();
+            table["max_pause"]    = stats.max_pause.count();
+
+            return table;
+        });
+        memory.set_function("gc_budget", [this] noexcept { return gc_budget().count(); });
+        memory.set_function("set_gc_budget",
+                            [this](i64 microseconds) noexcept { set_gc_budget(std::chrono::microseconds { microseconds }); });
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaHeap::allocate_block(usize size) noexcept -> void* {
+        const auto size_class = size_class_of(size);
+
+        auto* block = static_cast<void*>(nullptr);
+        if (size_class == NO_SIZE_CLASS) block = std::malloc(size);
+        else if (m_free_lists[size_class] != nullptr or refill(size_class)) {
+            auto* free_block         = m_free_lists[size_class];
+            m_free_lists[size_class] = free_block->next;
+            block                    = free_block;
+        }
+        if (block == nullptr) return nullptr;
+
+        m_stats.live_bytes  += size;
+        m_stats.peak_bytes   = std::max(m_stats.peak_bytes, m_stats.live_bytes);
+        m_stats.allocations += 1;
+
+        return block;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaHeap::free_block(void* pointer, usize size) noexcept -> void {
+        m_stats.live_bytes -= size;
+
+        const auto size_class = size_class_of(size);
+        if (size_class == NO_SIZE_CLASS) {
+            std::free(pointer);
+            return;
+        }
+
+        auto* block              = static_cast<FreeBlock*>(pointer);
+        block->next              = m_free_lists[size_class];
+        m_free_lists[size_class] = block;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaHeap::refill(usize size_class) noexcept -> bool {
+        auto chunk = std::unique_ptr<std::byte[]> { new (std::nothrow) std::byte[CHUNK_SIZE] };
+        if (chunk == nullptr) return false;
+
+        // the blocks are threaded from the end so they are handed out in address order
+        const auto block_size = block_size_of(size_class);
+        for (auto offset = CHUNK_SIZE; offset >= block_size; offset -= block_size) {
+            auto* block              = std::bit_cast<FreeBlock*>(chunk.get() + offset - block_size);
+            block->next              = m_free_lists[size_class];
+            m_free_lists[size_class] = block;
+        }
+
+        m_chunks.emplace_back(std::move(chunk));
+        m_stats.pooled_bytes += CHUNK_SIZE;
+
+        return true;
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,250 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/log/log_macro.hpp>
+
+#include <stormkit/lua/lua.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :lua_profiler;
+
+namespace stdfs = std::filesystem;
+namespace stdr  = std::ranges;
+namespace stdv  = std::views;
+
+namespace stormkit::engine {
+    LOGGER("lua")
+
+    namespace {
+        // deeper frames are dropped, a runaway recursion would make the samples huge
+        constexpr auto MAX_SAMPLE_DEPTH      = 64;
+        // at 60 fps, one warning per second while the frames stay over budget
+        constexpr auto BUDGET_WARNING_PERIOD = 60u;
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto as_milliseconds(LuaProfiler::Clock::duration duration) noexcept -> f64 {
+            return std::chrono::duration<f64, std::milli> { duration }.count();
+        }
+    } // namespace
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::record(std::string_view name, Clock::duration duration) noexcept -> void {
+        auto data = m_data.write();
+
+        auto it = data->stats.find(name);
+        if (it == stdr::end(data->stats)) it = data->stats.emplace(std::string { name }, Stats {}).first;
+
+        auto& stats    = it->second;
+        stats.last     = duration;
+        stats.average  = (stats.calls == 0) ? duration : (stats.average * 15 + duration) / 16;
+        stats.max      = std::max(stats.max, duration);
+        stats.calls   += 1;
+
+        if (duration > data->slowest_duration) {
+            data->slowest          = name;
+            data->slowest_duration = duration;
+        }
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::end_frame(Clock::duration duration) noexcept -> void {
+        auto data = m_data.write();
+
+        data->frames += 1;
+        if (duration > data->budget and data->over_budget++ % BUDGET_WARNING_PERIOD == 0)
+            wlog("Lua frame took {:.3f} ms, over the {:.3f} ms budget, slowest: {} ({:.3f} ms).",
+                 as_milliseconds(duration),
+                 as_milliseconds(data->budget),
+                 stdr::empty(data->slowest) ? "none" : data->slowest,
+                 as_milliseconds(data->slowest_duration));
+
+        data->slowest.clear();
+        data->slowest_duration = {};
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::stats() const noexcept -> std::vector<std::pair<std::string, Stats>> {
+        auto stats = [this] {
+            auto data = m_data.read();
+            return data->stats | stdr::to<std::vector<std::pair<std::string, Stats>>>();
+        }();
+        stdr::sort(stats, std::greater {}, [](const auto& entry) static noexcept { return entry.second.average; });
+
+        return stats;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::reset() noexcept -> void {
+        auto data = m_data.write();
+        data->stats.clear();
+        data->stacks.clear();
+        data->frames      = 0;
+        data->over_budget = 0;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::start_sampling(lua_State* state, Clock::duration period) noexcept -> void {
+        // the callbacks are shared by the main state and its threads
+        auto* callbacks      = lua_callbacks(state);
+        callbacks->userdata  = this;
+        callbacks->interrupt = &LuaProfiler::interrupt;
+
+        m_sample_period = period;
+        m_next_sample   = Clock::now() + period;
+        m_sampling      = true;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::stop_sampling(lua_State* state) noexcept -> void {
+        auto* callbacks = lua_callbacks(state);
+        if (callbacks->userdata == this) {
+            callbacks->interrupt = nullptr;
+            callbacks->userdata  = nullptr;
+        }
+
+        m_sampling = false;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::folded_stacks() const noexcept -> std::string {
+        auto lines = [this] {
+            auto data = m_data.read();
+            return data->stacks
+                   | stdv::transform([](const auto& entry) static noexcept {
+                         return std::format("{} {}", entry.first, entry.second);
+                     })
+                   | stdr::to<std::vector>();
+        }();
+        stdr::sort(lines);
+
+        auto folded = std::string {};
+        for (const auto& line : lines) {
+            folded += line;
+            folded += '\n';
+        }
+
+        return folded;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::write_folded_stacks(const stdfs::path& path) const noexcept -> bool {
+        auto file = std::ofstream { path, std::ios::trunc };
+        if (not file) {
+            elog("Failed to open {}!", path.string());
+            return false;
+        }
+
+        file << folded_stacks();
+
+        return static_cast<bool>(file);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::interrupt(lua_State* state, int gc) -> void {
+        // called with the gc state on the collector steps, only the safepoints of the running code are sampled
+        if (gc >= 0) return;
+
+        auto* profiler = static_cast<LuaProfiler*>(lua_callbacks(state)->userdata);
+        if (profiler != nullptr) profiler->sample(state);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto LuaProfiler::sample(lua_State* state) noexcept -> void {
+        const auto now = Clock::now();
+        if (now < m_next_sample) return;
+        m_next_sample = now + m_sample_period;
+
+        auto frames = std::vector<std::string> {};
+        auto debug  = lua_Debug {};
+        for (auto level = 0; level < MAX_SAMPLE_DEPTH and lua_getinfo(state, level, "sn", &debug) != 0; ++level) {
+            auto frame = std::format("{}@{}:{}",
+                                     debug.name != nullptr ? debug.name : "?",
+                                     debug.short_src != nullptr ? debug.short_src : "?",
+                                     debug.linedefined);
+            // ';' separate the frames and ' ' the count in the folded format
+            stdr::replace(frame, ';', '_');
+            stdr::replace(frame, ' ', '_');
+            frames.emplace_back(std::move(frame));
+        }
+        if (stdr::empty(frames)) return;
+
+        // outermost frame first
+        auto stack = std::string {};
+        for (const auto& frame : frames | stdv::reverse) {
+            if (not stdr::empty(stack)) stack += ';';
+            stack += frame;
+        }
+
+        m_data.write()->stacks[std::move(stack)] += 1;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto bind_lua_profiler(sol::table& engine) noexcept -> void {
+        using Milliseconds = std::chrono::duration<f64, std::milli>;
+
+        engine.new_usertype<LuaProfiler>(
+          "lua_profiler",
+          sol::no_constructor,
+          "stats",
+          +[](const LuaProfiler* profiler, sol::this_state state) static noexcept {
+              auto lua   = sol::state_view { state };
+              auto table = lua.create_table();
+              for (const auto& [name, stats] : profiler->stats()) {
+                  auto entry       = lua.create_table();
+                  entry["last"]    = as_milliseconds(stats.last);
+                  entry["average"] = as_milliseconds(stats.average);
+                  entry["max"]     = as_milliseconds(stats.max);
+                  entry["calls"]   = stats.calls;
+                  table[name]      = entry;
+              }
+
+              return table;
+          },
+          "budget",
+          +[](const LuaProfiler* profiler) static noexcept { return as_milliseconds(profiler->budget()); },
+          "set_budget",
+          +[](LuaProfiler* profiler, f64 milliseconds) static noexcept {
+              profiler->set_budget(std::chrono::duration_cast<LuaProfiler::Clock::duration>(Milliseconds { milliseconds }));
+          },
+          "reset",
+          &LuaProfiler::reset,
+          "start_sampling",
+          +[](LuaProfiler* profiler, sol::this_state state, sol::optional<f64> period_milliseconds) static noexcept {
+              const auto period = period_milliseconds
+                                    ? std::chrono::duration_cast<LuaProfiler::Clock::duration>(Milliseconds {
+                                        *period_milliseconds })
+                                    : LuaProfiler::DEFAULT_SAMPLE_PERIOD;
+              profiler->start_sampling(state.lua_state(), period);
+          },
+          "stop_sampling",
+          +[](LuaProfiler* profiler, sol::this_state state) static noexcept { profiler->stop_sampling(state.lua_state()); },
+          "sampling",
+          &LuaProfiler::sampling,
+          "folded_stacks",
+          &LuaProfiler::folded_stacks,
+          "write_folded_stacks",
+          +[](const LuaProfiler* profiler, std::string_view path) static noexcept {
+              return profiler->write_folded_stacks(stdfs::path { path });
+          });
+    }
+} // namespace stormkit::engine
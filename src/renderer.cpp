@@ -33,6 +33,45 @@ namespace stormkit::engine {
 
         constexpr auto SWAPCHAIN_EXTENSIONS = std::array { "VK_KHR_swapchain"sv };
 
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto buffer_stages(FrameBuilder::Task::Type type) noexcept -> gpu::PipelineStageFlag {
+            switch (type) {
+                case FrameBuilder::Task::Type::RASTER:
+                    return gpu::PipelineStageFlag::DRAW_INDIRECT
+                           | gpu::PipelineStageFlag::VERTEX_INPUT
+                           | gpu::PipelineStageFlag::VERTEX_SHADER
+                           | gpu::PipelineStageFlag::FRAGMENT_SHADER;
+                case FrameBuilder::Task::Type::COMPUTE: return gpu::PipelineStageFlag::COMPUTE_SHADER;
+                case FrameBuilder::Task::Type::TRANSFER: return gpu::PipelineStageFlag::TRANSFER;
+                default: break;
+            }
+
+            return gpu::PipelineStageFlag::ALL_COMMANDS;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto buffer_accesses(FrameBuilder::Task::Type type, bool write) noexcept -> gpu::AccessFlag {
+            switch (type) {
+                case FrameBuilder::Task::Type::RASTER:
+                    if (write) return gpu::AccessFlag::SHADER_WRITE;
+                    return gpu::AccessFlag::INDIRECT_COMMAND_READ
+                           | gpu::AccessFlag::VERTEX_ATTRIBUTE_READ
+                           | gpu::AccessFlag::UNIFORM_READ
+                           | gpu::AccessFlag::SHADER_READ;
+                case FrameBuilder::Task::Type::COMPUTE:
+                    if (write) return gpu::AccessFlag::SHADER_READ | gpu::AccessFlag::SHADER_WRITE;
+                    return gpu::AccessFlag::UNIFORM_READ | gpu::AccessFlag::SHADER_READ;
+                case FrameBuilder::Task::Type::TRANSFER:
+                    if (write) return gpu::AccessFlag::TRANSFER_WRITE;
+                    return gpu::AccessFlag::TRANSFER_READ;
+                default: break;
+            }
+
+            return gpu::AccessFlag::MEMORY_READ | gpu::AccessFlag::MEMORY_WRITE;
+        }
+
         /////////////////////////////////////
         /////////////////////////////////////
         auto pick_physical_device(std::span<const gpu::PhysicalDevice> physical_devices) noexcept
@@ -105,7 +144,7 @@ namespace stormkit::engine {
         Try(do_init_render_surface(std::move(window)));
         dlog("GPU windowed render surface successfully initialized. ✓");
 
-        m_resource_store       = ResourceStore { *this };
+        m_resource_store       = Try(ResourceStore::create(*this));
         m_frame_resource_cache = FrameResourceCache { *m_device };
         m_frame_resources.resize(m_surface->buffering_count());
 
@@ -155,6 +194,9 @@ namespace stormkit::engine {
     /////////////////////////////////////
     /////////////////////////////////////
     auto Renderer::do_render() noexcept -> void {
+        m_resource_store->update();
+        poll_completed_frames();
+
         auto frame = TryAssert(m_surface->begin_frame(*m_device), "Failed to start frame!");
         TryAssert(do_render(frame), "Failed to render frame!");
         TryAssert(m_surface->present_frame(m_raster_queue, frame), "Failed to present frame!");
@@ -192,12 +234,15 @@ namespace stormkit::engine {
             frame_builders->pop();
         }
 
-        auto old                               = std::move(m_frame_resources[frame.current_frame]);
-        m_frame_resources[frame.current_frame] = realize_frame(frame_builder);
+        auto old                                      = std::move(m_frame_resources[frame.current_frame]);
+        m_frame_resources[frame.current_frame]        = realize_frame(frame_builder);
+        m_frame_resources[frame.current_frame]->index = m_realized_frames++;
 
-        if (old.initialized())
+        if (old.initialized()) {
             if (not(old->fence.status() == gpu::Fence::Status::SIGNALED))
                 TryAssert(old->fence.wait(), std::format("Failed to wait on old frame {} fence!", frame.current_frame));
+            complete_frames(old->index + 1);
+        }
 
         auto&       frame_resources = m_frame_resources[frame.current_frame];
         const auto& present_image   = m_surface->images()[frame.image_index];
@@ -242,6 +287,39 @@ namespace stormkit::engine {
         Return {};
     }
 
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto Renderer::wait_idle() noexcept -> gpu::Expected<void> {
+        Try(m_device->wait_idle());
+
+        // nothing is rendered anymore, a frame built now has no frame in flight to wait for
+        complete_frames(std::numeric_limits<u64>::max());
+
+        Return {};
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto Renderer::poll_completed_frames() noexcept -> void {
+        // frames finish in submission order, the latest signaled fence tell every frame before it is done too
+        auto count = u64 { 0 };
+        for (const auto& frame_resources : m_frame_resources) {
+            if (not frame_resources.initialized() or frame_resources->index < count) continue;
+            if (frame_resources->fence.status() == gpu::Fence::Status::SIGNALED) count = frame_resources->index + 1;
+        }
+
+        complete_frames(count);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto Renderer::complete_frames(u64 count) noexcept -> void {
+        if (count <= m_completed_frames->load()) return;
+
+        m_completed_frames->store(count);
+        m_completed_frames->notify_all();
+    }
+
     /////////////////////////////////////
     /////////////////////////////////////
     auto Renderer::realize_frame(const FrameBuilder& frame_builder) noexcept -> FrameResources {
@@ -341,6 +419,9 @@ namespace stormkit::engine {
 
         // auto roots = tasks | stdv::filter([](const auto& pair) static noexcept { return pair.second.root; });
 
+        // last task type which wrote each buffer, a task accessing one of them wait for the write to complete
+        auto written_buffers = std::vector<std::pair<FrameBuilder::ResourceID, FrameBuilder::Task::Type>> {};
+
         auto& main_cmb = frame_resources.main_cmb;
         TryAssert(main_cmb.begin(true), "Failed to record main frame command buffer!");
         for (const auto& task_id : ordered_tasks) {
@@ -356,6 +437,36 @@ namespace stormkit::engine {
                                                      frame_resources.buffers };
 
             main_cmb.begin_debug_region(std::format("StormKit:frame:{}", task.name));
+
+            auto src_stages = gpu::PipelineStageFlag {};
+            auto barriers   = std::vector<gpu::BufferMemoryBarrier> {};
+            for (auto& [buffer_id, buffer] : frame_resources.buffers) {
+                const auto read  = (buffer_id & task.reads) == buffer_id;
+                const auto write = (buffer_id & task.writes) == buffer_id;
+                if (not read and not write) continue;
+
+                auto it = stdr::find_if(written_buffers, [&buffer_id](const auto& pair) noexcept {
+                    return pair.first == buffer_id;
+                });
+                if (it != stdr::end(written_buffers)) {
+                    src_stages |= buffer_stages(it->second);
+                    barriers.emplace_back(gpu::BufferMemoryBarrier {
+                      .src    = buffer_accesses(it->second, true),
+                      .dst    = buffer_accesses(task.type, write),
+                      .buffer = as_ref(*buffer),
+                      .size   = buffer->size(),
+                      .offset = 0,
+                    });
+                }
+
+                if (not write) continue;
+                if (it != stdr::end(written_buffers)) it->second = task.type;
+                else
+                    written_buffers.emplace_back(buffer_id, task.type);
+            }
+            if (not stdr::empty(barriers))
+                main_cmb.pipeline_barrier(src_stages, buffer_stages(task.type), gpu::DependencyFlag::NONE, {}, barriers, {});
+
             switch (task.type) {
                 case FrameBuilder::Task::Type::RASTER: {
                     const auto extent         = m_extent.to<i32>();
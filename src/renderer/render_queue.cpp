@@ -0,0 +1,74 @@
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :renderer.render_queue;
+
+namespace stdr = std::ranges;
+
+namespace stormkit::engine {
+    namespace {
+        constexpr auto RADIX_BITS   = 8u;
+        constexpr auto RADIX_SIZE   = 1u << RADIX_BITS;
+        constexpr auto RADIX_PASSES = 64u / RADIX_BITS;
+    } // namespace
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto RenderQueue::sort() noexcept -> void {
+        const auto count = stdr::size(m_packets);
+        if (count < 2) return;
+
+        // one read of the keys build the histograms of every pass
+        auto histograms = std::array<std::array<u32, RADIX_SIZE>, RADIX_PASSES> {};
+        for (const auto& packet : m_packets)
+            for (auto pass = 0u; pass < RADIX_PASSES; ++pass) ++histograms[pass][(packet.key >> (pass * RADIX_BITS)) & 0xffu];
+
+        m_scratch.resize(count);
+
+        auto* from = &m_packets;
+        auto* to   = &m_scratch;
+        for (auto pass = 0u; pass < RADIX_PASSES; ++pass) {
+            auto& histogram = histograms[pass];
+
+            // every key share this digit, the pass would not move anything
+            if (stdr::any_of(histogram, [count](auto bucket) noexcept { return bucket == count; })) continue;
+
+            auto offset = 0u;
+            for (auto& bucket : histogram) offset += std::exchange(bucket, offset);
+
+            const auto shift = pass * RADIX_BITS;
+            for (const auto& packet : *from) (*to)[histogram[(packet.key >> shift) & 0xffu]++] = packet;
+
+            std::swap(from, to);
+        }
+
+        if (from != &m_packets) m_packets.swap(m_scratch);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto RenderQueue::batches() const noexcept -> std::vector<DrawBatch> {
+        auto out = std::vector<DrawBatch> {};
+
+        for (auto i = 0u; i < stdr::size(m_packets); ++i) {
+            const auto key      = m_packets[i].key;
+            const auto pipeline = SortKey::pipeline(key);
+            const auto texture  = SortKey::texture(key);
+
+            if (not stdr::empty(out)) {
+                auto& last = out.back();
+                if (last.pipeline == pipeline and last.texture == texture) {
+                    ++last.count;
+                    continue;
+                }
+            }
+
+            out.emplace_back(DrawBatch { .pipeline = pipeline, .texture = texture, .first = i, .count = 1 });
+        }
+
+        return out;
+    }
+} // namespace stormkit::engine
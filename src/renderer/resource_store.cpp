@@ -4,7 +4,9 @@
 
 module;
 
+#include <stormkit/core/contract_macro.hpp>
 #include <stormkit/core/try_expected.hpp>
+#include <stormkit/log/log_macro.hpp>
 
 #include <stormkit/lua/lua.hpp>
 
@@ -15,69 +17,612 @@ import std;
 import stormkit;
 
 import :core;
+import :renderer;
+
+using namespace std::literals;
 
 namespace stdfs = std::filesystem;
+namespace stdr  = std::ranges;
+namespace stdv  = std::views;
 
 namespace stormkit::engine {
+    LOGGER("resource_store")
+
+    namespace {
+        // buffer_offset of a buffer to image copy must be a multiple of the texel size and of 4
+        constexpr auto STAGING_ALIGNMENT = 16_usize;
+
+        using Levels = std::span<const CachedTexture::Level>;
+
+        struct Submission {
+            gpu::Buffer        staging_buffer;
+            gpu::CommandBuffer cmb;
+            gpu::Fence         fence;
+        };
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto align(usize value, usize alignment) noexcept -> usize {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto staging_size(Levels levels) noexcept -> usize {
+            auto size = 0_usize;
+            for (const auto& level : levels) size = align(size, STAGING_ALIGNMENT) + stdr::size(level.data);
+
+            return size;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto stage_levels(gpu::Buffer& staging_buffer, usize offset, Levels levels) noexcept
+          -> gpu::Expected<std::vector<gpu::BufferImageCopy>> {
+            auto copies = std::vector<gpu::BufferImageCopy> {};
+            copies.reserve(stdr::size(levels));
+
+            // mips are packed one after the other, each at an offset valid for the copy
+            for (auto mip_level = 0u; mip_level < stdr::size(levels); ++mip_level) {
+                const auto& level = levels[mip_level];
+
+                offset = align(offset, STAGING_ALIGNMENT);
+                Try(staging_buffer.upload(level.data, offset));
+                copies.emplace_back(gpu::BufferImageCopy {
+                  .buffer_offset       = offset,
+                  .buffer_row_length   = 0,
+                  .buffer_image_height = 0,
+                  .subresource_layers  = { .mip_level = mip_level },
+                  .offset              = {},
+                  .extent              = level.extent,
+                });
+                offset += stdr::size(level.data);
+            }
+
+            Return copies;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto mip_range(Levels levels) noexcept -> gpu::ImageSubresourceRange {
+            return { .level_count = as<u32>(stdr::size(levels)) };
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto submit_upload(const gpu::Device&      device,
+                           const gpu::CommandPool& command_pool,
+                           const gpu::Queue&       queue,
+                           Levels                  levels,
+                           const gpu::Image&       texture) noexcept -> gpu::Expected<Submission> {
+            auto staging_buffer = Try(gpu::Buffer::create(device,
+                                                          { .usages = gpu::BufferUsageFlag::TRANSFER_SRC,
+                                                            .size   = staging_size(levels) }));
+            const auto copies   = Try(stage_levels(staging_buffer, 0, levels));
+
+            auto cmb = Try(command_pool.create_command_buffer());
+            Try(cmb.begin(true));
+            cmb.transition_image_layout(texture,
+                                        gpu::ImageLayout::UNDEFINED,
+                                        gpu::ImageLayout::TRANSFER_DST_OPTIMAL,
+                                        mip_range(levels));
+            cmb.copy_buffer_to_image(staging_buffer, texture, copies);
+            cmb.transition_image_layout(texture,
+                                        gpu::ImageLayout::TRANSFER_DST_OPTIMAL,
+                                        gpu::ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+                                        mip_range(levels));
+            Try(cmb.end());
+
+            auto fence = Try(gpu::Fence::create(device));
+            Try(cmb.submit(queue, {}, {}, {}, as_ref(fence)));
+
+            Return Submission { .staging_buffer = std::move(staging_buffer), .cmb = std::move(cmb), .fence = std::move(fence) };
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto texture_create_info(const CachedTexture& texture) noexcept -> gpu::Image::CreateInfo {
+            return {
+                .extent     = texture.extent(),
+                .format     = texture.format,
+                .mip_levels = as<u32>(stdr::size(texture.levels)),
+                .usages     = gpu::ImageUsageFlag::SAMPLED | gpu::ImageUsageFlag::TRANSFER_DST,
+            };
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto megabytes_per_second(usize bytes, std::chrono::steady_clock::duration time) noexcept -> f64 {
+            const auto seconds = std::chrono::duration<f64> { time }.count();
+            if (seconds <= 0.) return 0.;
+
+            return as<f64>(bytes) / (1024. * 1024.) / seconds;
+        }
+    } // namespace
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::do_init() noexcept -> gpu::Expected<void> {
+        const auto& device = m_renderer->device();
+
+        m_upload_command_pool = Try(gpu::CommandPool::create(device));
+        device.set_object_name(*m_upload_command_pool, "StormKit:resource_store:upload_command_pool");
+
+        // bound in place of the images still loading, transparent so pending sprites are just not visible yet
+        m_placeholder = Try(gpu::Image::create(device,
+                                               {
+                                                 .extent = { 1, 1, 1 },
+                                                 .format = gpu::PixelFormat::RGBA8_UNORM,
+                                                 .usages = gpu::ImageUsageFlag::SAMPLED | gpu::ImageUsageFlag::TRANSFER_DST,
+                                               }));
+        device.set_object_name(*m_placeholder, "StormKit:resource_store:placeholder");
+
+        const auto pixel      = std::array<Byte, 4> {};
+        const auto levels     = std::array { CachedTexture::Level { .data = pixel, .extent = { 1, 1, 1 } } };
+        auto       submission = Try(submit_upload(device,
+                                                  m_renderer->main_command_pool(),
+                                                  m_renderer->raster_queue(),
+                                                  levels,
+                                                  *m_placeholder));
+        Try(submission.fence.wait());
+
+        Return {};
+    }
 
     /////////////////////////////////////
     /////////////////////////////////////
     auto ResourceStore::load_image(const stdfs::path& path) -> TextureID {
         const auto id = hash(path.string());
 
-        if (m_textures.contains(id)) return id;
+        if (is_requested(id)) return id;
 
-        auto image = image::Image {};
-        TryAssert(image.load_from_file(path), std::format("Failed to load image {}, reason: !", path.string()));
+        const auto image = m_texture_cache.load(path);
+        ensures(image.has_value(), std::format("Failed to load image {}!", path.string()));
 
-        const auto& device       = m_renderer->device();
-        const auto& command_pool = m_renderer->main_command_pool();
-        const auto& raster_queue = m_renderer->raster_queue();
+        const auto& device = m_renderer->device();
 
-        std::println("AAAAAAAAAAAAAAAAAAAAAAAAAA {}", std::bit_cast<uptr>(device.device_table().vkCreateImage));
-        const auto& [it, _] = m_textures
-                                .emplace(id,
-                                         TryAssert(gpu::Image::create(device,
-                                                                      {
-                                                                        .extent = image.extent(),
-                                                                        .format = gpu::from_image(image.format()),
-                                                                        .usages = gpu::ImageUsageFlag::SAMPLED
-                                                                                  | gpu::ImageUsageFlag::TRANSFER_DST,
-                                                                      }),
-                                                   std::format("Failed to allocate gpu resources for image {}!", path.string())));
-        const auto& [_, texture] = *it;
+        auto texture = TryAssert(gpu::Image::allocate(device, texture_create_info(*image)),
+                                 std::format("Failed to allocate gpu resources for image {}!", path.string()));
 
-        const auto end_str   = std::format("for texture {}", path.string());
-        const auto error_str = std::format("upload and layout transition command buffer {}", end_str);
+        auto submission = TryAssert(submit_upload(device,
+                                                  m_renderer->main_command_pool(),
+                                                  m_renderer->raster_queue(),
+                                                  image->levels,
+                                                  *texture),
+                                    std::format("Failed to upload texture {}!", path.string()));
+        TryAssert(submission.fence.wait(), std::format("Failed to wait for texture {} upload!", path.string()));
+
+        store(id, path, image->size(), std::move(texture));
+
+        return id;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::load_images(std::span<const stdfs::path> paths) -> std::vector<TextureID> {
+        using Clock = std::chrono::steady_clock;
+
+        auto ids = paths
+                   | stdv::transform([](const auto& path) static noexcept { return hash(path.string()); })
+                   | stdr::to<std::vector>();
+
+        struct Pending {
+            usize                                     index;
+            std::future<std::optional<CachedTexture>> decoded;
+        };
+
+        auto pending = std::vector<Pending> {};
+        for (auto i = 0_usize; i < stdr::size(ids); ++i) {
+            if (is_requested(ids[i])) continue;
+            // a path may be listed twice
+            if (stdr::any_of(pending, [&](const auto& other) noexcept { return ids[other.index] == ids[i]; })) continue;
+
+            pending.emplace_back(i);
+        }
+        if (stdr::empty(pending)) return ids;
+
+        const auto decode_start = Clock::now();
+        for (auto& [index, decoded] : pending)
+            decoded = m_renderer->thread_pool()
+                        .post_task<std::optional<CachedTexture>>([&cache = m_texture_cache, &path = paths[index]] noexcept {
+                            return cache.load(path);
+                        });
+
+        struct Decoded {
+            usize            index;
+            TextureID        id;
+            CachedTexture    image;
+            usize            offset;
+            Heap<gpu::Image> texture = nullptr;
+        };
+
+        // every image is packed in the same staging buffer
+        auto decoded      = std::vector<Decoded> {};
+        auto failed       = std::vector<TextureID> {};
+        auto batch_size   = 0_usize;
+        auto pixels_size  = 0_usize;
+        decoded.reserve(stdr::size(pending));
+        for (auto& [index, future] : pending) {
+            auto image = future.get();
+            if (not image) {
+                elog("Failed to load image {}!", paths[index].string());
+                failed.emplace_back(ids[index]);
+                continue;
+            }
+
+            batch_size   = align(batch_size, STAGING_ALIGNMENT);
+            pixels_size += image->size();
+            decoded.emplace_back(index, ids[index], *std::move(image), batch_size);
+            batch_size += staging_size(decoded.back().image.levels);
+        }
+        const auto decode_time = Clock::now() - decode_start;
+
+        for (auto& id : ids)
+            if (stdr::contains(failed, id)) id = INVALID_TEXTURE_ID;
+        if (stdr::empty(decoded)) return ids;
+
+        const auto upload_start = Clock::now();
+
+        const auto& device = m_renderer->device();
 
         auto staging_buffer = TryAssert(gpu::Buffer::create(device,
                                                             { .usages = gpu::BufferUsageFlag::TRANSFER_SRC,
-                                                              .size   = image.size() }),
-                                        std::format("Failed to allocate gpu texture staging buffer {}!", end_str));
-        TryAssert(staging_buffer.upload(image.data()),
-                  std::format("Failed to upload texture data to staging buffer {}!", end_str));
-
-        const auto copy = {
-            gpu::BufferImageCopy {
-                                  .buffer_offset       = 0,
-                                  .buffer_row_length   = 0,
-                                  .buffer_image_height = 0,
-                                  .subresource_layers  = {},
-                                  .offset              = {},
-                                  .extent              = texture.extent() }
-        };
+                                                              .size   = batch_size }),
+                                        std::format("Failed to allocate staging buffer for {} images!", stdr::size(decoded)));
+        auto copies = std::vector<std::vector<gpu::BufferImageCopy>> {};
+        copies.reserve(stdr::size(decoded));
+        for (auto& [_, id, image, offset, texture] : decoded) {
+            texture = TryAssert(gpu::Image::allocate(device, texture_create_info(image)),
+                                std::format("Failed to allocate gpu resources for image {}!", id));
+            copies.emplace_back(TryAssert(stage_levels(staging_buffer, offset, image.levels),
+                                          std::format("Failed to upload image {} to staging buffer!", id)));
+        }
+
+        const auto to_transfer = decoded
+                                 | stdv::transform([](const auto& image) static noexcept {
+                                       return gpu::ImageMemoryBarrier {
+                                           .src        = gpu::AccessFlag {},
+                                           .dst        = gpu::AccessFlag::TRANSFER_WRITE,
+                                           .old_layout = gpu::ImageLayout::UNDEFINED,
+                                           .new_layout = gpu::ImageLayout::TRANSFER_DST_OPTIMAL,
+                                           .image      = as_ref(*image.texture),
+                                           .range      = mip_range(image.image.levels),
+                                       };
+                                   })
+                                 | stdr::to<std::vector>();
+        const auto to_shader_read = decoded
+                                    | stdv::transform([](const auto& image) static noexcept {
+                                          return gpu::ImageMemoryBarrier {
+                                              .src        = gpu::AccessFlag::TRANSFER_WRITE,
+                                              .dst        = gpu::AccessFlag::SHADER_READ,
+                                              .old_layout = gpu::ImageLayout::TRANSFER_DST_OPTIMAL,
+                                              .new_layout = gpu::ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+                                              .image      = as_ref(*image.texture),
+                                              .range      = mip_range(image.image.levels),
+                                          };
+                                      })
+                                    | stdr::to<std::vector>();
+
+        const auto error_str = std::format("upload command buffer for {} images", stdr::size(decoded));
 
-        auto cmb = TryAssert(command_pool.create_command_buffer(), std::format("Failed to create {}!", error_str));
+        // one barrier batch before and after the copies, instead of two transitions per image
+        auto cmb = TryAssert(m_renderer->main_command_pool().create_command_buffer(),
+                             std::format("Failed to create {}!", error_str));
         TryAssert(cmb.begin(true), std::format("Failed to begin recording of {}!", error_str));
-        cmb.transition_image_layout(texture, gpu::ImageLayout::UNDEFINED, gpu::ImageLayout::TRANSFER_DST_OPTIMAL);
-        cmb.copy_buffer_to_image(staging_buffer, texture, as_view(copy));
-        cmb.transition_image_layout(texture, gpu::ImageLayout::TRANSFER_DST_OPTIMAL, gpu::ImageLayout::SHADER_READ_ONLY_OPTIMAL);
+        cmb.pipeline_barrier(gpu::PipelineStageFlag::TOP_OF_PIPE,
+                             gpu::PipelineStageFlag::TRANSFER,
+                             gpu::DependencyFlag::NONE,
+                             {},
+                             {},
+                             to_transfer);
+        for (auto i = 0_usize; i < stdr::size(decoded); ++i)
+            cmb.copy_buffer_to_image(staging_buffer, *decoded[i].texture, copies[i]);
+        cmb.pipeline_barrier(gpu::PipelineStageFlag::TRANSFER,
+                             gpu::PipelineStageFlag::FRAGMENT_SHADER,
+                             gpu::DependencyFlag::NONE,
+                             {},
+                             {},
+                             to_shader_read);
         TryAssert(cmb.end(), std::format("Failed to end recording of {}!", error_str));
 
-        auto fence = TryAssert(gpu::Fence::create(device), std::format("Failed to create fence for ", error_str));
-        TryAssert(cmb.submit(raster_queue, {}, {}, {}, as_ref(fence)), std::format("Failed to submit {}!", error_str));
+        auto fence = TryAssert(gpu::Fence::create(device), std::format("Failed to create fence for {}!", error_str));
+        TryAssert(cmb.submit(m_renderer->raster_queue(), {}, {}, {}, as_ref(fence)),
+                  std::format("Failed to submit {}!", error_str));
         TryAssert(fence.wait(), std::format("Failed to wait for {}!", error_str));
 
-        return id;
+        const auto upload_time = Clock::now() - upload_start;
+
+        for (auto& [index, id, image, _, texture] : decoded) store(id, paths[index], image.size(), std::move(texture));
+
+        ilog("Loaded {} images ({:.2f} MB), decoded at {:.2f} MB/s, uploaded at {:.2f} MB/s.",
+             stdr::size(decoded),
+             as<f64>(pixels_size) / (1024. * 1024.),
+             megabytes_per_second(pixels_size, decode_time),
+             megabytes_per_second(pixels_size, upload_time));
+
+        return ids;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::store(TextureID id, const stdfs::path& path, usize size, Heap<gpu::Image>&& image) noexcept
+      -> void {
+        auto loaded = std::promise<bool> {};
+        loaded.set_value(true);
+
+        m_async.write()->futures.insert_or_assign(id, loaded.get_future().share());
+
+        auto  textures = m_textures.write();
+        auto& texture  = textures->entries[id];
+        if (texture.evicted) ++textures->reloads;
+
+        texture.image             = std::move(image);
+        texture.path              = path;
+        texture.size              = size;
+        texture.last_used         = textures->frame;
+        texture.evicted           = false;
+        textures->resident_bytes += size;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::is_requested(TextureID id) const noexcept -> bool {
+        const auto textures = m_textures.read();
+
+        const auto it = textures->entries.find(id);
+        return it != stdr::cend(textures->entries) and not it->second.evicted;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::load_image_async(const stdfs::path& path,
+                                         OnImageLoaded      on_loaded,
+                                         CallbackThread     callback_thread) noexcept -> AsyncImage {
+        const auto id = hash(path.string());
+
+        auto async = m_async.write();
+
+        if (const auto it = async->futures.find(id); it != stdr::end(async->futures) and is_requested(id)) {
+            const auto& loaded = it->second;
+            if (on_loaded) {
+                // already loaded, the callback is still run on the requested thread
+                if (loaded.wait_for(0s) == std::future_status::ready) {
+                    auto& queue = (callback_thread == CallbackThread::DEFERRED) ? async->deferred : async->completed;
+                    queue.emplace_back(id, std::move(on_loaded), loaded.get());
+                } else
+                    async->callbacks.emplace_back(id, std::move(on_loaded), callback_thread);
+            }
+
+            return { id, loaded };
+        }
+
+        if (on_loaded) async->callbacks.emplace_back(id, std::move(on_loaded), callback_thread);
+
+        return { id, request(id, path, *async) };
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::request(TextureID id, const stdfs::path& path, AsyncState& async) noexcept
+      -> std::shared_future<bool> {
+        auto promise = std::promise<bool> {};
+        auto loaded  = promise.get_future().share();
+        async.futures.insert_or_assign(id, loaded);
+
+        // decoding, or mapping the cached mips, runs on the pool while the render thread keep the placeholder bound
+        auto decoded = m_renderer->thread_pool()
+                         .post_task<std::optional<CachedTexture>>([cache = m_texture_cache, path] noexcept {
+                             return cache.load(path);
+                         });
+
+        async.requests.emplace_back(id, path, std::move(promise), std::move(decoded));
+
+        auto  textures = m_textures.write();
+        auto& texture  = textures->entries[id];
+        if (texture.evicted) ++textures->reloads;
+
+        texture.path    = path;
+        texture.evicted = false;
+
+        return loaded;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::update() noexcept -> void {
+        {
+            auto async = m_async.write();
+            stdr::move(async->requests, std::back_inserter(m_decoding));
+            async->requests.clear();
+        }
+
+        const auto& device = m_renderer->device();
+
+        for (auto& request : m_decoding) {
+            if (request.decoded.wait_for(0s) != std::future_status::ready) continue;
+
+            const auto image = request.decoded.get();
+            if (not image) {
+                elog("Failed to load image {}!", request.path.string());
+                finish(request.id, false, request.promise);
+                continue;
+            }
+
+            // submitted without waiting, the fence is polled on the next frames
+            auto upload = gpu::Image::allocate(device, texture_create_info(*image))
+                            .and_then([&, this](auto&& texture) noexcept {
+                                return submit_upload(device,
+                                                     *m_upload_command_pool,
+                                                     m_renderer->raster_queue(),
+                                                     image->levels,
+                                                     *texture)
+                                  .transform([&](auto&& submission) noexcept {
+                                      return Upload { .id             = request.id,
+                                                      .promise        = std::move(request.promise),
+                                                      .size           = image->size(),
+                                                      .image          = std::move(texture),
+                                                      .staging_buffer = std::move(submission.staging_buffer),
+                                                      .cmb            = std::move(submission.cmb),
+                                                      .fence          = std::move(submission.fence) };
+                                  });
+                            });
+            if (not upload) {
+                elog("Failed to upload image {}, reason: {}", request.path.string(), upload.error());
+                finish(request.id, false, request.promise);
+                continue;
+            }
+
+            m_uploading.emplace_back(std::move(*upload));
+        }
+        // future::get() leave the future invalid
+        std::erase_if(m_decoding, [](const auto& request) static noexcept { return not request.decoded.valid(); });
+
+        for (auto& upload : m_uploading) {
+            if (upload.fence.status() != gpu::Fence::Status::SIGNALED) continue;
+
+            {
+                auto  textures            = m_textures.write();
+                auto& texture             = textures->entries[upload.id];
+                texture.image             = std::move(upload.image);
+                texture.size              = upload.size;
+                texture.last_used         = textures->frame;
+                textures->resident_bytes += upload.size;
+                ++textures->revision;
+            }
+
+            finish(upload.id, true, upload.promise);
+        }
+        std::erase_if(m_uploading, [](const auto& upload) static noexcept { return upload.image == nullptr; });
+
+        evict();
+
+        auto completed = std::vector<Completion> {};
+        std::swap(completed, m_async.write()->completed);
+        for (auto& [id, on_loaded, success] : completed) std::invoke(on_loaded, id, success);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::acquire(TextureID id) const noexcept -> void {
+        auto textures = m_textures.write();
+
+        const auto it = textures->entries.find(id);
+        if (it == stdr::end(textures->entries)) return;
+
+        ++it->second.references;
+        it->second.last_used = textures->frame;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::release(TextureID id) const noexcept -> void {
+        auto textures = m_textures.write();
+
+        const auto it = textures->entries.find(id);
+        if (it == stdr::end(textures->entries)) return;
+
+        EXPECTS(it->second.references > 0);
+        --it->second.references;
+        it->second.last_used = textures->frame;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::texture_stats() const noexcept -> TextureStats {
+        const auto textures = m_textures.read();
+
+        return {
+            .resident_bytes = textures->resident_bytes,
+            .budget         = textures->budget,
+            .resident_count = as<usize>(stdr::count_if(textures->entries,
+                                                       [](const auto& entry) static noexcept {
+                                                           return entry.second.image != nullptr;
+                                                       })),
+            .evictions      = textures->evictions,
+            .reloads        = textures->reloads,
+        };
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::evict() noexcept -> void {
+        // an image released on this frame may still be sampled by the frames already recorded
+        const auto delay = as<u64>(m_renderer->buffering_count()) + 1;
+
+        auto frame   = u64 { 0 };
+        auto reloads = std::vector<std::pair<TextureID, stdfs::path>> {};
+        {
+            auto textures = m_textures.write();
+            frame         = ++textures->frame;
+
+            if (textures->resident_bytes > textures->budget) {
+                auto candidates = std::vector<std::pair<u64, TextureID>> {};
+                for (const auto& [id, texture] : textures->entries)
+                    if (texture.image != nullptr and texture.references == 0 and texture.last_used + delay <= frame)
+                        candidates.emplace_back(texture.last_used, id);
+                stdr::sort(candidates);
+
+                for (const auto& [_, id] : candidates) {
+                    if (textures->resident_bytes <= textures->budget) break;
+
+                    auto& texture = textures->entries[id];
+                    m_evicted.emplace_back(std::move(texture.image), frame);
+                    texture.evicted           = true;
+                    textures->resident_bytes -= texture.size;
+                    ++textures->evictions;
+                    ++textures->revision;
+
+                    dlog("Evicted texture {} ({} bytes).", id, texture.size);
+                }
+            }
+
+            for (const auto& [id, texture] : textures->entries)
+                if (texture.evicted and texture.references > 0) reloads.emplace_back(id, texture.path);
+        }
+
+        // the users rebind the placeholder when the revision change, the evicted image outlive their last frames
+        std::erase_if(m_evicted, [frame, delay](const auto& evicted) noexcept { return evicted.second + delay <= frame; });
+
+        if (stdr::empty(reloads)) return;
+
+        auto async = m_async.write();
+        for (const auto& [id, path] : reloads) {
+            dlog("Reloading evicted texture {} from {}.", id, path.string());
+            request(id, path, *async);
+        }
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::finish(TextureID id, bool success, std::promise<bool>& promise) noexcept -> void {
+        promise.set_value(success);
+
+        auto async = m_async.write();
+        for (auto& callback : async->callbacks) {
+            if (callback.id != id) continue;
+
+            auto& queue = (callback.thread == CallbackThread::DEFERRED) ? async->deferred : async->completed;
+            queue.emplace_back(id, std::move(callback.on_loaded), success);
+        }
+        std::erase_if(async->callbacks, [id](const auto& callback) noexcept { return callback.id == id; });
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::run_deferred_callbacks() noexcept -> void {
+        auto deferred = std::vector<Completion> {};
+        std::swap(deferred, m_async.write()->deferred);
+
+        for (auto& [id, on_loaded, success] : deferred) std::invoke(on_loaded, id, success);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto ResourceStore::drop_deferred_callbacks() noexcept -> void {
+        auto async = m_async.write();
+        async->deferred.clear();
+        std::erase_if(async->callbacks, [](const auto& callback) static noexcept {
+            return callback.thread == CallbackThread::DEFERRED;
+        });
     }
 } // namespace stormkit::engine
@@ -0,0 +1,286 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <ktx.h>
+
+#include <stormkit/log/log_macro.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :vfs;
+import :renderer.texture_cache;
+
+namespace stdfs = std::filesystem;
+namespace stdr  = std::ranges;
+
+namespace stormkit::engine {
+    LOGGER("texture cache")
+
+    namespace {
+        constexpr auto KTX2_IDENTIFIER = std::array<u8, 12> { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+                                                              0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+        struct Ktx2Header {
+            std::array<u8, 12> identifier;
+            u32                vk_format;
+            u32                type_size;
+            u32                pixel_width;
+            u32                pixel_height;
+            u32                pixel_depth;
+            u32                layer_count;
+            u32                face_count;
+            u32                level_count;
+            u32                supercompression_scheme;
+            u32                dfd_byte_offset;
+            u32                dfd_byte_length;
+            u32                kvd_byte_offset;
+            u32                kvd_byte_length;
+            u64                sgd_byte_offset;
+            u64                sgd_byte_length;
+        };
+        static_assert(sizeof(Ktx2Header) == 80);
+
+        struct Ktx2Level {
+            u64 byte_offset;
+            u64 byte_length;
+            u64 uncompressed_byte_length;
+        };
+        static_assert(sizeof(Ktx2Level) == 24);
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto hash_bytes(std::span<const Byte> bytes, u64 hash = 0xcbf29ce484222325) noexcept -> u64 {
+            // FNV-1a
+            for (const auto byte : bytes) {
+                hash ^= std::to_integer<u64>(byte);
+                hash *= u64 { 0x100000001b3 };
+            }
+
+            return hash;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto source_key(const stdfs::path& source, const FileStatus& status) noexcept -> u64 {
+            const auto name     = source.generic_string();
+            const auto size     = status.size;
+            const auto modified = status.modified.time_since_epoch().count();
+
+            auto hash = hash_bytes(std::as_bytes(std::span { name }));
+            hash      = hash_bytes(std::as_bytes(std::span { &size, 1 }), hash);
+            return hash_bytes(std::as_bytes(std::span { &modified, 1 }), hash);
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto level_extent(const math::uextent3& extent, usize level) noexcept -> math::uextent3 {
+            return {
+                std::max(1u, extent.width >> level),
+                std::max(1u, extent.height >> level),
+                std::max(1u, extent.depth >> level),
+            };
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto level_count(const math::uextent3& extent) noexcept -> usize {
+            return as<usize>(std::bit_width(std::max(extent.width, extent.height)));
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto downsample(std::span<const Byte> source,
+                        const math::uextent3& source_extent,
+                        const math::uextent3& extent,
+                        usize                 pixel_size,
+                        std::vector<Byte>&    output) noexcept -> void {
+            // 2x2 box filter per 8 bit channel, odd edges repeat their last texel
+            for (auto y = 0u; y < extent.height; ++y) {
+                const auto y0 = std::min(y * 2, source_extent.height - 1);
+                const auto y1 = std::min(y * 2 + 1, source_extent.height - 1);
+                for (auto x = 0u; x < extent.width; ++x) {
+                    const auto x0 = std::min(x * 2, source_extent.width - 1);
+                    const auto x1 = std::min(x * 2 + 1, source_extent.width - 1);
+                    for (auto c = 0_usize; c < pixel_size; ++c) {
+                        const auto texel = [&](u32 tx, u32 ty) noexcept {
+                            return std::to_integer<u32>(source[(as<usize>(ty) * source_extent.width + tx) * pixel_size + c]);
+                        };
+                        const auto sum = texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1);
+                        output.emplace_back(Byte { as<u8>((sum + 2) / 4) });
+                    }
+                }
+            }
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto write_ktx2(const stdfs::path& path, const CachedTexture& texture) noexcept -> bool {
+            const auto& extent = texture.extent();
+
+            auto create_info            = ktxTextureCreateInfo {};
+            // gpu::PixelFormat values are the VkFormat ones
+            create_info.vkFormat        = as<u32>(texture.format);
+            create_info.baseWidth       = extent.width;
+            create_info.baseHeight      = extent.height;
+            create_info.baseDepth       = 1;
+            create_info.numDimensions   = 2;
+            create_info.numLevels       = as<u32>(stdr::size(texture.levels));
+            create_info.numLayers       = 1;
+            create_info.numFaces        = 1;
+            create_info.isArray         = KTX_FALSE;
+            create_info.generateMipmaps = KTX_FALSE;
+
+            auto* ktx = static_cast<ktxTexture2*>(nullptr);
+            if (ktxTexture2_Create(&create_info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &ktx) != KTX_SUCCESS) return false;
+
+            auto result = KTX_SUCCESS;
+            for (auto level = 0u; level < stdr::size(texture.levels) and result == KTX_SUCCESS; ++level) {
+                const auto& data = texture.levels[level].data;
+                result           = ktxTexture_SetImageFromMemory(ktxTexture(ktx),
+                                                       level,
+                                                       0,
+                                                       0,
+                                                       reinterpret_cast<const ktx_uint8_t*>(stdr::data(data)),
+                                                       stdr::size(data));
+            }
+
+            // written aside then renamed, a crash never leave a truncated file in the cache
+            auto temporary = path;
+            temporary += ".tmp";
+            if (result == KTX_SUCCESS) result = ktxTexture_WriteToNamedFile(ktxTexture(ktx), temporary.string().c_str());
+            ktxTexture_Destroy(ktxTexture(ktx));
+            if (result != KTX_SUCCESS) return false;
+
+            auto error = std::error_code {};
+            stdfs::rename(temporary, path, error);
+
+            return not error;
+        }
+    } // namespace
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto TextureCache::load(const stdfs::path& source) const noexcept -> std::optional<CachedTexture> {
+        // textures baked offline are used as is, straight from the pack mapping
+        if (source.extension() == ".ktx2") return m_vfs->read(source).and_then([this](auto&& file) noexcept {
+            return parse(std::forward<decltype(file)>(file));
+        });
+
+        const auto status = m_vfs->status(source);
+        if (not status) return std::nullopt;
+
+        const auto path = m_directory / std::format("{:016x}.ktx2", source_key(source, *status));
+
+        auto error = std::error_code {};
+        if (stdfs::exists(path, error)) {
+            if (auto cached = map_file(path); cached)
+                if (auto texture = parse(*std::move(cached)); texture) return texture;
+
+            wlog("Cached texture {} of {} is invalid, baking it again.", path.string(), source.string());
+        }
+
+        // only a miss read the source
+        const auto file = m_vfs->read(source);
+        if (not file) return std::nullopt;
+
+        return bake(file->data, path);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto TextureCache::parse(FileData&& file) const noexcept -> std::optional<CachedTexture> {
+        const auto data = file.data;
+        if (stdr::size(data) < sizeof(Ktx2Header)) return std::nullopt;
+
+        auto header = Ktx2Header {};
+        std::memcpy(&header, stdr::data(data), sizeof(Ktx2Header));
+
+        // only uncompressed 2D textures as bake() write them are accepted, a rejected cache file is baked again
+        if (header.identifier != KTX2_IDENTIFIER
+            or header.supercompression_scheme != 0
+            or header.level_count == 0
+            or header.layer_count > 1
+            or header.face_count != 1
+            or header.pixel_depth > 1)
+            return std::nullopt;
+
+        const auto index_size = sizeof(Ktx2Level) * header.level_count;
+        if (stdr::size(data) < sizeof(Ktx2Header) + index_size) return std::nullopt;
+
+        const auto extent = math::uextent3 { header.pixel_width, header.pixel_height, 1u };
+
+        auto texture = CachedTexture {
+            .format  = as<gpu::PixelFormat>(header.vk_format),
+            .levels  = {},
+            .storage = std::move(file.storage),
+        };
+        texture.levels.reserve(header.level_count);
+        for (auto level = 0_usize; level < header.level_count; ++level) {
+            auto entry = Ktx2Level {};
+            std::memcpy(&entry, stdr::data(data) + sizeof(Ktx2Header) + level * sizeof(Ktx2Level), sizeof(Ktx2Level));
+            if (entry.byte_offset + entry.byte_length > stdr::size(data)) return std::nullopt;
+
+            // the mip is copied straight from the mapping to the staging buffer
+            texture.levels.emplace_back(data.subspan(as<usize>(entry.byte_offset), as<usize>(entry.byte_length)),
+                                        level_extent(extent, level));
+        }
+
+        return texture;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto TextureCache::bake(std::span<const Byte> source, const stdfs::path& path) const noexcept
+      -> std::optional<CachedTexture> {
+        auto image = image::Image {};
+        if (not image.load_from_memory(source)) return std::nullopt;
+
+        const auto extent     = image.extent();
+        const auto pixel_size = image.size() / (as<usize>(extent.width) * extent.height * extent.depth);
+        // mips are box filtered per byte, wider channels keep a single level
+        const auto levels     = (pixel_size <= 4 and extent.depth == 1) ? level_count(extent) : 1_usize;
+
+        auto chain   = std::make_shared<std::vector<Byte>>();
+        auto offsets = std::vector<usize> {};
+        offsets.reserve(levels);
+
+        offsets.emplace_back(0);
+        chain->append_range(image.data());
+        for (auto level = 1_usize; level < levels; ++level) {
+            const auto source_offset = offsets.back();
+            const auto source_extent = level_extent(extent, level - 1);
+            offsets.emplace_back(stdr::size(*chain));
+            // copied as the output grow
+            const auto previous = std::vector<Byte> { stdr::begin(*chain) + as<isize>(source_offset),
+                                                      stdr::begin(*chain) + as<isize>(offsets.back()) };
+            downsample(previous, source_extent, level_extent(extent, level), pixel_size, *chain);
+        }
+        offsets.emplace_back(stdr::size(*chain));
+
+        auto texture = CachedTexture {
+            .format  = gpu::from_image(image.format()),
+            .levels  = {},
+            .storage = chain,
+        };
+        texture.levels.reserve(levels);
+        for (auto level = 0_usize; level < levels; ++level)
+            texture.levels.emplace_back(std::span<const Byte> { *chain }.subspan(offsets[level],
+                                                                                  offsets[level + 1] - offsets[level]),
+                                        level_extent(extent, level));
+
+        auto error = std::error_code {};
+        stdfs::create_directories(m_directory, error);
+        if (error or not write_ktx2(path, texture)) wlog("Failed to write texture cache {}!", path.string());
+        else
+            dlog("Baked {} mip levels in {}.", levels, path.string());
+
+        return texture;
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,138 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :ecs.schema_components;
+
+namespace stdr = std::ranges;
+namespace stdv = std::views;
+
+namespace stormkit::engine {
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    ComponentSchema::ComponentSchema(std::string name, std::span<const std::pair<std::string, FieldType>> fields) noexcept
+        : m_name { std::move(name) }, m_type { hash(m_name) } {
+        // biggest alignment first, the fields are then packed without padding between them
+        auto sorted = fields | stdr::to<std::vector>();
+        stdr::stable_sort(sorted, std::greater {}, [](const auto& field) static noexcept { return alignment_of(field.second); });
+
+        auto alignment = 1_usize;
+        m_fields.reserve(stdr::size(sorted));
+        for (auto&& [field_name, type] : sorted) {
+            m_stride = (m_stride + alignment_of(type) - 1) & ~(alignment_of(type) - 1);
+            m_fields.push_back({ .name = std::move(field_name), .type = type, .offset = as<u32>(m_stride) });
+
+            m_stride += size_of(type);
+            alignment = std::max(alignment, alignment_of(type));
+        }
+        m_stride = std::max((m_stride + alignment - 1) & ~(alignment - 1), alignment);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ComponentSchema::add(entities::Entity entity) noexcept -> u32 {
+        if (const auto row = row_of(entity); row) return *row;
+
+        const auto row = as<u32>(stdr::size(m_entities));
+        m_data.resize(m_data.size() + m_stride, Byte { 0 });
+        m_entities.emplace_back(entity);
+        m_rows.emplace(entity, row);
+
+        return row;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ComponentSchema::remove(entities::Entity entity) noexcept -> bool {
+        const auto it = m_rows.find(entity);
+        if (it == stdr::end(m_rows)) return false;
+
+        const auto row  = it->second;
+        const auto last = as<u32>(stdr::size(m_entities) - 1);
+        m_rows.erase(it);
+
+        // the last row fill the hole, rows stay packed
+        if (row != last) {
+            std::memcpy(stdr::data(m_data) + row * m_stride, stdr::data(m_data) + last * m_stride, m_stride);
+            m_entities[row]         = m_entities[last];
+            m_rows[m_entities[row]] = row;
+        }
+        m_entities.pop_back();
+        m_data.resize(m_data.size() - m_stride);
+
+        return true;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ComponentSchema::clear() noexcept -> void {
+        m_data.clear();
+        m_entities.clear();
+        m_rows.clear();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SchemaRegistry::define(std::string name, std::span<const std::pair<std::string, FieldType>> fields) noexcept
+      -> ComponentSchema& {
+        auto schema = allocate_unsafe<ComponentSchema>(std::move(name), fields);
+
+        const auto it = stdr::find_if(m_schemas, [&schema](const auto& other) noexcept {
+            return other->name() == schema->name();
+        });
+        if (it == stdr::end(m_schemas)) return *m_schemas.emplace_back(std::move(schema));
+
+        // declared again by a reloaded script, the rows are kept if the layout didn't change. Replaced in place, the
+        // schemas are referenced by address
+        auto&      previous    = **it;
+        const auto same_layout = stdr::equal(previous.fields(), schema->fields(), [](const auto& a, const auto& b) noexcept {
+            return a.name == b.name and a.type == b.type;
+        });
+        if (same_layout) return previous;
+
+        // the entities keep their SchemaComponent marker, so each row is migrated: the fields kept with the same type are
+        // copied, the others start zeroed
+        for (const auto [row, entity] : stdv::enumerate(previous.entities())) {
+            const auto migrated = schema->add(entity);
+            for (const auto& field : schema->fields()) {
+                const auto* from = previous.field(field.name);
+                if (from == nullptr or from->type != field.type) continue;
+
+                std::memcpy(stdr::data(schema->data()) + migrated * schema->stride() + field.offset,
+                            stdr::data(previous.data()) + as<usize>(row) * previous.stride() + from->offset,
+                            size_of(field.type));
+            }
+        }
+        previous = std::move(*schema);
+
+        return previous;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SchemaRegistry::remove(entities::Entity entity) noexcept -> void {
+        for (auto& schema : m_schemas) schema->remove(entity);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SchemaRegistry::clear() noexcept -> void {
+        m_schemas.clear();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SchemaRegistry::clear_rows() noexcept -> void {
+        for (auto& schema : m_schemas) schema->clear();
+    }
+} // namespace stormkit::engine
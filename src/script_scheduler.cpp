@@ -0,0 +1,228 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/log/log_macro.hpp>
+
+#include <stormkit/lua/lua.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :script_scheduler;
+
+namespace stdr = std::ranges;
+
+namespace stormkit::engine {
+    LOGGER("lua")
+
+    namespace {
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto as_objects(const sol::variadic_args& args) noexcept -> std::vector<sol::object> {
+            return std::vector<sol::object> { stdr::begin(args), stdr::end(args) };
+        }
+    } // namespace
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::bind(sol::state& global_state) noexcept -> void {
+        auto engine    = global_state["stormkit"].get_or_create<sol::table>();
+        auto scheduler = engine["scheduler"].get_or_create<sol::table>();
+
+        scheduler.set_function("spawn",
+                               [this](sol::this_state state, sol::protected_function function, sol::variadic_args args) noexcept {
+                                   return spawn(state, std::move(function), as_objects(args));
+                               });
+        scheduler.set_function("cancel", [this](TaskID id) noexcept { cancel(id); });
+        scheduler.set_function("emit", [this](std::string_view event, sol::variadic_args args) noexcept {
+            return emit(event, as_objects(args));
+        });
+        scheduler.set_function("on_message",
+                               [this](std::string event, sol::protected_function function) noexcept -> HandlerID {
+                                   const auto id = m_next_handler++;
+                                   m_handlers[std::move(event)].emplace_back(id, std::move(function));
+                                   return id;
+                               });
+        scheduler.set_function("off_message", [this](HandlerID id) noexcept {
+            for (auto& [_, handlers] : m_handlers)
+                std::erase_if(handlers, [id](const auto& handler) noexcept { return handler.id == id; });
+        });
+        scheduler.set_function("task_count", [this] noexcept { return task_count(); });
+
+        // the wait primitives register the wake up then yield, the values passed to resume() are returned to the script
+        scheduler.set_function("wait", sol::yielding([this](sol::this_state state, f64 seconds) noexcept {
+                                   const auto id = current(state);
+                                   if (id) wait(*id, fsecond { as<f32>(seconds) });
+                                   else
+                                       elog("scheduler.wait() called outside of a scheduled coroutine!");
+                               }));
+        scheduler.set_function("wait_frames", sol::yielding([this](sol::this_state state, u64 frames) noexcept {
+                                   const auto id = current(state);
+                                   if (id) wait_frames(*id, frames);
+                                   else
+                                       elog("scheduler.wait_frames() called outside of a scheduled coroutine!");
+                               }));
+        scheduler.set_function("wait_until", sol::yielding([this](sol::this_state state, std::string event) noexcept {
+                                   const auto id = current(state);
+                                   if (id) wait_until(*id, std::move(event));
+                                   else
+                                       elog("scheduler.wait_until() called outside of a scheduled coroutine!");
+                               }));
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::spawn(sol::state_view state, sol::protected_function function, std::vector<sol::object> args) noexcept
+      -> TaskID {
+        const auto id = m_next_task++;
+
+        auto thread    = sol::thread::create(state);
+        auto coroutine = sol::coroutine { thread.thread_state(), function };
+        m_threads.emplace(thread.thread_state(), id);
+        m_tasks.emplace(id, Task { .thread = std::move(thread), .coroutine = std::move(coroutine) });
+
+        resume(id, args);
+
+        return id;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::cancel(TaskID id) noexcept -> void {
+        // the timers and the subscriptions of the task are dropped lazily, when they fire
+        finish(id);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::emit(std::string_view event, const std::vector<sol::object>& args) noexcept -> usize {
+        auto count = 0_usize;
+
+        // resumed coroutines may wait on the same event again, they are woken up by the next emit only
+        if (auto it = m_waiting.find(std::string { event }); it != stdr::end(m_waiting)) {
+            const auto waiting = std::exchange(it->second, {});
+            for (const auto id : waiting) {
+                if (not m_tasks.contains(id)) continue;
+
+                resume(id, args);
+                ++count;
+            }
+        }
+
+        // every message run in its own coroutine, so handlers can wait too
+        if (auto it = m_handlers.find(std::string { event }); it != stdr::end(m_handlers)) {
+            const auto functions = it->second
+                                   | std::views::transform([](const auto& handler) static noexcept { return handler.function; })
+                                   | stdr::to<std::vector>();
+            for (const auto& function : functions) {
+                spawn(function.lua_state(), function, args);
+                ++count;
+            }
+        }
+
+        return count;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::update(fsecond delta) noexcept -> void {
+        auto due = std::vector<TaskID> {};
+
+        // only the slots between the previous and the current time are visited, timers a revolution or more ahead stay
+        m_elapsed       += delta.count();
+        const auto time  = as<u64>(m_elapsed / RESOLUTION.count());
+        const auto last  = std::min(time, m_time + TIME_SLOTS);
+        for (auto tick = m_time + 1; tick <= last; ++tick)
+            std::erase_if(m_time_wheel[tick % TIME_SLOTS], [&](const auto& timer) noexcept {
+                if (timer.due > time) return false;
+
+                due.emplace_back(timer.task);
+                return true;
+            });
+        m_time = time;
+
+        m_frame += 1;
+        std::erase_if(m_frame_wheel[m_frame % FRAME_SLOTS], [&](const auto& timer) noexcept {
+            if (timer.due > m_frame) return false;
+
+            due.emplace_back(timer.task);
+            return true;
+        });
+
+        for (const auto id : due) resume(id);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::clear() noexcept -> void {
+        m_tasks.clear();
+        m_threads.clear();
+        for (auto& slot : m_time_wheel) slot.clear();
+        for (auto& slot : m_frame_wheel) slot.clear();
+        m_waiting.clear();
+        m_handlers.clear();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::resume(TaskID id, const std::vector<sol::object>& args) noexcept -> void {
+        const auto it = m_tasks.find(id);
+        if (it == stdr::end(m_tasks)) return;
+
+        // copied, the coroutine may spawn tasks and rehash m_tasks
+        auto       coroutine = it->second.coroutine;
+        const auto suspended = std::exchange(m_suspended, false);
+        const auto result    = coroutine(sol::as_args(args));
+        const auto waiting   = std::exchange(m_suspended, suspended);
+
+        if (result.status() == sol::call_status::yielded) {
+            // a bare coroutine.yield()
+            if (not waiting) wait_frames(id, 1);
+            return;
+        }
+
+        if (not result.valid()) elog("Lua coroutine {} failed: {}", id, result.get<sol::error>().what());
+
+        finish(id);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::finish(TaskID id) noexcept -> void {
+        const auto it = m_tasks.find(id);
+        if (it == stdr::end(m_tasks)) return;
+
+        m_threads.erase(it->second.thread.thread_state());
+        m_tasks.erase(it);
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::wait(TaskID id, fsecond delay) noexcept -> void {
+        const auto ticks = std::max(as<u64>(std::ceil(delay / RESOLUTION)), u64 { 1 });
+        const auto due   = m_time + ticks;
+        m_time_wheel[due % TIME_SLOTS].emplace_back(due, id);
+        m_suspended = true;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::wait_frames(TaskID id, u64 frames) noexcept -> void {
+        const auto due = m_frame + std::max(frames, u64 { 1 });
+        m_frame_wheel[due % FRAME_SLOTS].emplace_back(due, id);
+        m_suspended = true;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto ScriptScheduler::wait_until(TaskID id, std::string event) noexcept -> void {
+        m_waiting[std::move(event)].emplace_back(id);
+        m_suspended = true;
+    }
+} // namespace stormkit::engine
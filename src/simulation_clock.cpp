@@ -0,0 +1,63 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :simulation_clock;
+
+namespace stormkit::engine {
+    namespace {
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto moving_average(std::chrono::steady_clock::duration average,
+                                      std::chrono::steady_clock::duration last,
+                                      u64                                 count) noexcept -> std::chrono::steady_clock::duration {
+            return (count == 0) ? last : (average * 15 + last) / 16;
+        }
+    } // namespace
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SimulationClock::advance() noexcept -> u32 {
+        const auto now     = Clock::now();
+        const auto elapsed = m_last ? now - *m_last : Clock::duration {};
+        m_last             = now;
+
+        m_accumulator += elapsed;
+        auto ticks     = as<u32>(m_accumulator / m_tick);
+        if (ticks > m_max_catch_up) {
+            m_stats.dropped += m_accumulator - m_tick * m_max_catch_up;
+            m_accumulator    = m_tick * m_max_catch_up;
+            ticks            = m_max_catch_up;
+        }
+        m_accumulator -= m_tick * ticks;
+
+        m_alpha = std::chrono::duration<f32> { m_accumulator } / std::chrono::duration<f32> { m_tick };
+
+        m_stats.frames += 1;
+        if (ticks == 0) m_stats.idle_frames += 1;
+
+        return ticks;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SimulationClock::record_tick(Clock::duration duration) noexcept -> void {
+        m_stats.tick_time  = moving_average(m_stats.tick_time, duration, m_stats.ticks);
+        m_stats.ticks     += 1;
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SimulationClock::record_render(Clock::duration duration) noexcept -> void {
+        // advance() already counted the frame
+        m_stats.render_time = moving_average(m_stats.render_time, duration, m_stats.frames - 1);
+
+        *m_published.write() = m_stats;
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,142 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#include <stormkit/core/contract_macro.hpp>
+
+#include <stormkit/log/log_macro.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :ecs.system_scheduler;
+
+namespace stdr = std::ranges;
+namespace stdv = std::views;
+
+namespace stormkit::engine {
+    LOGGER("ecs")
+
+    namespace {
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto conflicts(const SystemScheduler::Access& a, const SystemScheduler::Access& b) noexcept -> bool {
+            const auto touched_by = [](const auto& access) noexcept {
+                return [&access](const auto type) noexcept {
+                    return stdr::contains(access.reads, type) or stdr::contains(access.writes, type);
+                };
+            };
+
+            return stdr::any_of(a.writes, touched_by(b)) or stdr::any_of(b.writes, touched_by(a));
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto matching(const entities::EntityManager& world, std::span<const entities::ComponentType> types) noexcept
+          -> std::vector<entities::Entity> {
+            return world.entities()
+                   | stdv::filter([&](const auto e) noexcept {
+                         return stdr::all_of(types, [&](const auto type) noexcept { return world.has_component(e, type); });
+                     })
+                   | stdr::to<std::vector>();
+        }
+    } // namespace
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SystemScheduler::add_system(std::string                          name,
+                                     std::vector<entities::ComponentType> types,
+                                     Access                               access,
+                                     Update                               update,
+                                     Phase                                phase) noexcept -> void {
+        expects(phase == Phase::UPDATE or stdr::empty(access.writes),
+                std::format("Extract system {} can't write components!", name));
+
+        // the matched components are read by the system
+        for (const auto type : types)
+            if (not stdr::contains(access.reads, type) and not stdr::contains(access.writes, type))
+                access.reads.emplace_back(type);
+
+        std::erase_if(m_systems, [&name](const auto& system) noexcept { return system.name == name; });
+        m_systems.emplace_back(System {
+          .name   = std::move(name),
+          .types  = std::move(types),
+          .access = std::move(access),
+          .update = std::move(update),
+          .phase  = phase,
+        });
+
+        build_waves();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SystemScheduler::remove_system(std::string_view name) noexcept -> void {
+        std::erase_if(m_systems, [&name](const auto& system) noexcept { return system.name == name; });
+
+        build_waves();
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SystemScheduler::step(entities::EntityManager& world, fsecond delta, ThreadPool& thread_pool, bool extract) noexcept
+      -> void {
+        m_extract_delta += delta;
+
+        auto pending = std::vector<std::future<void>> {};
+        for (const auto& wave : m_waves) {
+            // the intermediate ticks of a frame are never rendered, there is nothing to extract from them
+            const auto extract_wave = m_systems[wave.front()].phase == Phase::EXTRACT;
+            if (extract_wave and not extract) continue;
+
+            const auto run = [this, &world, delta = extract_wave ? m_extract_delta : delta](usize index) noexcept {
+                const auto& system   = m_systems[index];
+                const auto  entities = matching(world, system.types);
+                system.update(world, delta, entities);
+            };
+
+            // the last system of the wave runs on this thread instead of waiting idle
+            pending.clear();
+            for (const auto index : wave | stdv::take(stdr::size(wave) - 1))
+                pending.emplace_back(thread_pool.template post_task<void>([&run, index] noexcept { run(index); }));
+
+            run(wave.back());
+
+            for (auto& task : pending) task.wait();
+        }
+
+        if (extract) m_extract_delta = {};
+    }
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    auto SystemScheduler::build_waves() noexcept -> void {
+        m_waves.clear();
+
+        // an update system runs in the wave after the last one holding a conflicting system registered before it
+        auto wave_of = std::vector<usize>(stdr::size(m_systems), 0_usize);
+        for (auto i = 0_usize; i < stdr::size(m_systems); ++i) {
+            if (m_systems[i].phase != Phase::UPDATE) continue;
+
+            for (auto j = 0_usize; j < i; ++j)
+                if (m_systems[j].phase == Phase::UPDATE and conflicts(m_systems[i].access, m_systems[j].access))
+                    wave_of[i] = std::max(wave_of[i], wave_of[j] + 1);
+
+            if (wave_of[i] == stdr::size(m_waves)) m_waves.emplace_back();
+            m_waves[wave_of[i]].emplace_back(i);
+        }
+
+        // the extract systems only read, they share the last wave
+        auto extract = std::vector<usize> {};
+        for (auto i = 0_usize; i < stdr::size(m_systems); ++i)
+            if (m_systems[i].phase == Phase::EXTRACT) extract.emplace_back(i);
+        if (not stdr::empty(extract)) m_waves.emplace_back(std::move(extract));
+
+        dlog("{} native systems scheduled in {} waves.", stdr::size(m_systems), stdr::size(m_waves));
+    }
+} // namespace stormkit::engine
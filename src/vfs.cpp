@@ -0,0 +1,392 @@
+// Copyright (C) 2024 Arthur LAURENT <arthur.laurent4@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level of this distribution
+
+module;
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <stormkit/log/log_macro.hpp>
+
+module stormkit.engine;
+
+import std;
+
+import stormkit;
+
+import :vfs;
+
+namespace stdfs = std::filesystem;
+namespace stdr  = std::ranges;
+namespace stdv  = std::views;
+
+namespace stormkit::engine {
+    LOGGER("vfs")
+
+    namespace {
+        constexpr auto PACK_MAGIC     = std::array<u8, 4> { 'S', 'K', 'P', 'K' };
+        constexpr auto PACK_VERSION   = 1u;
+        // blobs start on a cache line, so they can be read in place with any alignment requirement up to it
+        constexpr auto PACK_ALIGNMENT = 64_usize;
+
+        struct PackHeader {
+            std::array<u8, 4> magic;
+            u32               version;
+            u32               entry_count;
+            u32               names_size;
+        };
+        static_assert(sizeof(PackHeader) == 16);
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto name_hash(std::string_view name) noexcept -> u64 {
+            // FNV-1a, stable across builds and platforms
+            auto hash = u64 { 0xcbf29ce484222325 };
+            for (const auto character : name) {
+                hash ^= as<u8>(character);
+                hash *= u64 { 0x100000001b3 };
+            }
+
+            return hash;
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        constexpr auto align(usize offset) noexcept -> usize {
+            return (offset + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+        }
+
+        /////////////////////////////////////
+        /////////////////////////////////////
+        auto read_file(const stdfs::path& path) noexcept -> std::optional<FileData> {
+            auto file = std::ifstream { path, std::ios::binary | std::ios::ate };
+            if (not file) return std::nullopt;
+
+            auto bytes = std::make_shared<std::vector<Byte>>(as<usize>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(stdr::data(*bytes)), as<std::streamsize>(stdr::size(*bytes)));
+            if (not file) return std::nullopt;
+
+            const auto data = std::span<const Byte> { *bytes };
+            return FileData { .storage = std::move(bytes), .data = data };
+        }
+    } // namespace
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto map_file(const stdfs::path& path) noexcept -> std::optional<FileData> {
+#if defined(_WIN32)
+        const auto file = ::CreateFileW(path.c_str(),
+                                        GENERIC_READ,
+                                        FILE_SHARE_READ,
+                                        nullptr,
+                                        OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL,
+                                        nullptr);
+        if (file == INVALID_HANDLE_VALUE) return std::nullopt;
+
+        auto file_size = LARGE_INTEGER {};
+        if (not ::GetFileSizeEx(file, &file_size) or file_size.QuadPart <= 0) {
+            ::CloseHandle(file);
+            return std::nullopt;
+        }
+
+        const auto mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        ::CloseHandle(file);
+        if (mapping == nullptr) return std::nullopt;
+
+        const auto data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ::CloseHandle(mapping);
+        if (data == nullptr) return std::nullopt;
+
+        const auto size = as<usize>(file_size.QuadPart);
+        return FileData {
+            .storage = std::shared_ptr<const void> { data,
+                                                    [](const void* data) static noexcept { ::UnmapViewOfFile(data); } },
+            .data    = { std::bit_cast<const Byte*>(data), size },
+        };
+#else
+        const auto file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) return std::nullopt;
+
+        struct stat status;
+        if (::fstat(file, &status) != 0 or status.st_size <= 0) {
+            ::close(file);
+            return std::nullopt;
+        }
+
+        const auto size = as<usize>(status.st_size);
+        const auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);
+        if (data == MAP_FAILED) return std::nullopt;
+
+        return FileData {
+            .storage = std::shared_ptr<const void> { data,
+                                                    [size](const void* data) noexcept {
+                                                        ::munmap(const_cast<void*>(data), size);
+                                                    } },
+            .data    = { std::bit_cast<const Byte*>(data), size },
+        };
+#endif
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto AssetPack::open(const stdfs::path& path) noexcept -> std::optional<AssetPack> {
+        auto file = map_file(path);
+        if (not file) return std::nullopt;
+
+        const auto data = file->data;
+        if (stdr::size(data) < sizeof(PackHeader)) return std::nullopt;
+
+        auto header = PackHeader {};
+        std::memcpy(&header, stdr::data(data), sizeof(PackHeader));
+        if (header.magic != PACK_MAGIC or header.version != PACK_VERSION) {
+            elog("{} is not a version {} asset pack!", path.string(), PACK_VERSION);
+            return std::nullopt;
+        }
+
+        const auto index_size = sizeof(Entry) * header.entry_count;
+        if (stdr::size(data) < sizeof(PackHeader) + index_size + header.names_size) return std::nullopt;
+
+        // the index is small, a copy keep the lookups free of unaligned reads
+        auto entries = std::vector<Entry>(header.entry_count);
+        std::memcpy(stdr::data(entries), stdr::data(data) + sizeof(PackHeader), index_size);
+
+        const auto names_end = sizeof(PackHeader) + index_size + header.names_size;
+        for (const auto& entry : entries) {
+            if (entry.offset + entry.size > stdr::size(data) or entry.name_offset + entry.name_size > names_end) {
+                elog("Asset pack {} is truncated!", path.string());
+                return std::nullopt;
+            }
+        }
+
+        ilog("Mounted asset pack {} ({} files, {} bytes).", path.string(), header.entry_count, stdr::size(data));
+
+        return AssetPack { *std::move(file), std::move(entries) };
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto AssetPack::build(const stdfs::path&           root,
+                          std::span<const stdfs::path> directories,
+                          const stdfs::path&           output,
+                          const Transform&             transform) noexcept -> bool {
+        auto names = std::vector<std::string> {};
+        for (const auto& directory : directories) {
+            auto error = std::error_code {};
+            for (auto it = stdfs::recursive_directory_iterator { root / directory, error };
+                 not error and it != stdfs::recursive_directory_iterator {};
+                 it.increment(error)) {
+                if (not it->is_regular_file()) continue;
+
+                names.emplace_back(it->path().lexically_relative(root).generic_string());
+            }
+
+            if (error) {
+                elog("Failed to list {}: {}", (root / directory).string(), error.message());
+                return false;
+            }
+        }
+        stdr::sort(names);
+        const auto [first, last] = stdr::unique(names);
+        names.erase(first, last);
+
+        struct Blob {
+            std::string_view name;
+            u64              hash;
+            FileData         file;
+        };
+
+        auto blobs = std::vector<Blob> {};
+        blobs.reserve(stdr::size(names));
+        for (auto& name : names) {
+            auto file = read_file(root / name);
+            if (not file) {
+                elog("Failed to read {}!", (root / name).string());
+                return false;
+            }
+            if (transform and not transform(name, *file)) {
+                elog("Failed to pack {}!", (root / name).string());
+                return false;
+            }
+            blobs.emplace_back(name, name_hash(name), *std::move(file));
+        }
+        // lookups binary search the hash, then compare the names of the colliding entries
+        stdr::sort(blobs, [](const auto& a, const auto& b) static noexcept {
+            return std::tie(a.hash, a.name) < std::tie(b.hash, b.name);
+        });
+
+        auto names_size = 0_usize;
+        for (const auto& blob : blobs) names_size += stdr::size(blob.name);
+
+        const auto names_offset = sizeof(PackHeader) + sizeof(Entry) * stdr::size(blobs);
+
+        auto entries     = std::vector<Entry> {};
+        auto name_offset = names_offset;
+        auto offset      = align(names_offset + names_size);
+        entries.reserve(stdr::size(blobs));
+        for (const auto& blob : blobs) {
+            const auto size = stdr::size(blob.file.data);
+            entries.push_back({
+              .hash        = blob.hash,
+              .offset      = offset,
+              .size        = size,
+              .name_offset = as<u32>(name_offset),
+              .name_size   = as<u32>(stdr::size(blob.name)),
+            });
+            name_offset += stdr::size(blob.name);
+            offset       = align(offset + size);
+        }
+
+        const auto header = PackHeader {
+            .magic       = PACK_MAGIC,
+            .version     = PACK_VERSION,
+            .entry_count = as<u32>(stdr::size(entries)),
+            .names_size  = as<u32>(names_size),
+        };
+
+        // written aside then renamed, a crash never leave a truncated pack
+        auto temporary = output;
+        temporary += ".tmp";
+        {
+            auto file = std::ofstream { temporary, std::ios::binary | std::ios::trunc };
+            if (not file) {
+                elog("Failed to open {}!", temporary.string());
+                return false;
+            }
+
+            const auto write = [&file](const void* data, usize size) noexcept {
+                file.write(static_cast<const char*>(data), as<std::streamsize>(size));
+            };
+            const auto pad = [&file](usize offset) noexcept {
+                static constexpr auto ZEROS = std::array<char, PACK_ALIGNMENT> {};
+                file.write(stdr::data(ZEROS), as<std::streamsize>(align(offset) - offset));
+            };
+
+            write(&header, sizeof(PackHeader));
+            write(stdr::data(entries), sizeof(Entry) * stdr::size(entries));
+            for (const auto& blob : blobs) write(stdr::data(blob.name), stdr::size(blob.name));
+            pad(names_offset + names_size);
+            for (const auto& blob : blobs) {
+                write(stdr::data(blob.file.data), stdr::size(blob.file.data));
+                pad(as<usize>(file.tellp()));
+            }
+
+            if (not file) {
+                elog("Failed to write {}!", temporary.string());
+                return false;
+            }
+        }
+
+        auto error = std::error_code {};
+        stdfs::rename(temporary, output, error);
+        if (error) {
+            elog("Failed to write {}: {}", output.string(), error.message());
+            return false;
+        }
+
+        ilog("Packed {} files in {} ({} bytes).", stdr::size(entries), output.string(), offset);
+
+        return true;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto AssetPack::find(std::string_view name) const noexcept -> std::optional<FileData> {
+        const auto hash = name_hash(name);
+
+        for (const auto& entry : stdr::equal_range(m_entries, hash, {}, &Entry::hash)) {
+            if (this->name(entry) != name) continue;
+
+            return FileData {
+                .storage = m_file.storage,
+                .data    = m_file.data.subspan(as<usize>(entry.offset), as<usize>(entry.size)),
+            };
+        }
+
+        return std::nullopt;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto VirtualFileSystem::mount(const stdfs::path& pack, const stdfs::path& mount_point) noexcept -> bool {
+        auto error = std::error_code {};
+        auto point = stdfs::absolute(mount_point, error).lexically_normal();
+        if (error) return false;
+
+        auto asset_pack = AssetPack::open(pack);
+        if (not asset_pack) return false;
+
+        const auto modified = stdfs::last_write_time(pack, error);
+        if (error) return false;
+
+        m_mounts.emplace_back(std::move(point), *std::move(asset_pack), modified);
+
+        return true;
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto VirtualFileSystem::read(const stdfs::path& path) const noexcept -> std::optional<FileData> {
+        if (auto found = find(path); found) return std::move(found->file);
+        if (not m_loose_files) return std::nullopt;
+
+        return read_file(path);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto VirtualFileSystem::exists(const stdfs::path& path) const noexcept -> bool {
+        if (find(path)) return true;
+        if (not m_loose_files) return false;
+
+        auto error = std::error_code {};
+        return stdfs::is_regular_file(path, error);
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto VirtualFileSystem::status(const stdfs::path& path) const noexcept -> std::optional<FileStatus> {
+        if (const auto found = find(path); found)
+            return FileStatus { .size = stdr::size(found->file.data), .modified = found->mount->modified };
+        if (not m_loose_files) return std::nullopt;
+
+        auto       error    = std::error_code {};
+        const auto size     = stdfs::file_size(path, error);
+        if (error) return std::nullopt;
+        const auto modified = stdfs::last_write_time(path, error);
+        if (error) return std::nullopt;
+
+        return FileStatus { .size = size, .modified = modified };
+    }
+
+    /////////////////////////////////////
+    /////////////////////////////////////
+    auto VirtualFileSystem::find(const stdfs::path& path) const noexcept -> std::optional<Found> {
+        if (stdr::empty(m_mounts)) return std::nullopt;
+
+        auto       error    = std::error_code {};
+        const auto absolute = stdfs::absolute(path, error).lexically_normal();
+        if (error) return std::nullopt;
+
+        for (const auto& mount : m_mounts | stdv::reverse) {
+            const auto relative = absolute.lexically_relative(mount.point);
+            if (relative.empty() or *relative.begin() == "..") continue;
+
+            if (auto file = mount.pack.find(relative.generic_string()); file)
+                return Found { .mount = as_ref(mount), .file = *std::move(file) };
+        }
+
+        return std::nullopt;
+    }
+} // namespace stormkit::engine
@@ -0,0 +1,142 @@
+#include <cstdlib>
+
+import std;
+
+import stormkit;
+import stormkit.engine;
+
+#include <stormkit/main/main_macro.hpp>
+
+using namespace stormkit;
+
+namespace stdr = std::ranges;
+namespace stdv = std::views;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr auto DEFAULT_SPRITE_COUNT = 100'000_usize;
+    constexpr auto RUN_COUNT            = 100_usize;
+
+    struct Timing {
+        std::chrono::duration<f64, std::milli> best;
+        std::chrono::duration<f64, std::milli> average;
+    };
+
+    ////////////////////////////////////////
+    ////////////////////////////////////////
+    template<typename F>
+    auto measure(F&& run) noexcept -> Timing {
+        // one run to fault the output pages in
+        std::invoke(run);
+
+        auto best  = Clock::duration::max();
+        auto total = Clock::duration::zero();
+        for (auto _ : range(RUN_COUNT)) {
+            const auto start   = Clock::now();
+            std::invoke(run);
+            const auto elapsed = Clock::now() - start;
+
+            best   = std::min(best, elapsed);
+            total += elapsed;
+        }
+
+        return { .best = best, .average = total / RUN_COUNT };
+    }
+} // namespace
+
+////////////////////////////////////////
+////////////////////////////////////////
+auto main(std::span<const std::string_view> args) -> int {
+    auto sprite_count = DEFAULT_SPRITE_COUNT;
+    if (stdr::size(args) > 1) {
+        const auto argument = args[1];
+        if (std::from_chars(stdr::data(argument), stdr::data(argument) + stdr::size(argument), sprite_count).ec != std::errc {}) {
+            std::println(std::cerr, "usage: stormkit-bench-sprites [sprite count]");
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto generator = std::mt19937 { 42u };
+    auto position  = std::uniform_real_distribution { -1000.f, 1000.f };
+    auto scale     = std::uniform_real_distribution { 0.5f, 2.f };
+    auto angle     = std::uniform_real_distribution { 0.f, std::numbers::pi_v<f32> * 2.f };
+    auto extent    = std::uniform_real_distribution { 8.f, 64.f };
+
+    auto transforms = engine::pipeline_2d::SpriteTransforms {};
+    transforms.resize(sprite_count);
+
+    // the same sprites as entities, for the path replaced by the kernel
+    auto world           = Locked<entities::EntityManager> {};
+    auto sprite_entities = std::vector<entities::Entity> {};
+    sprite_entities.reserve(sprite_count);
+    {
+        auto locked = world.write();
+        for (auto i : range(sprite_count)) {
+            const auto sprite_position = math::fvec2 { position(generator), position(generator) };
+            const auto sprite_scale    = math::fvec2 { scale(generator), scale(generator) };
+            const auto sprite_angle    = angle(generator);
+            const auto sprite_extent   = math::fvec2 { extent(generator), extent(generator) };
+            transforms.set(i, sprite_position, sprite_scale, sprite_angle, sprite_extent);
+
+            auto bounds   = math::fbounding_rect {};
+            bounds.right  = sprite_extent.x;
+            bounds.bottom = sprite_extent.y;
+
+            const auto e = locked->make_entity();
+            locked->add_component(e, engine::pipeline_2d::TransformComponent { .position = sprite_position });
+            locked->add_component(e, engine::pipeline_2d::StaticSpriteComponent { engine::INVALID_TEXTURE_ID, bounds });
+            sprite_entities.emplace_back(e);
+        }
+    }
+
+    // the update replaced by the kernel, the world locked and the components fetched for each sprite then one matrix
+    // product chain
+    const auto previous = measure([&] noexcept {
+        const auto matrices = sprite_entities
+                              | stdv::transform([&world](auto e) noexcept {
+                                    auto        locked   = world.read();
+                                    const auto& position = locked->get_component<engine::pipeline_2d::TransformComponent>(e)
+                                                             .position;
+                                    const auto& sprite   = locked->get_component<engine::pipeline_2d::StaticSpriteComponent>(e);
+                                    locked.lock.unlock();
+
+                                    const auto width  = sprite.texture_bounds.right - sprite.texture_bounds.left;
+                                    const auto height = sprite.texture_bounds.bottom - sprite.texture_bounds.top;
+
+                                    auto transform = math::fmat4::identity();
+                                    transform      = math::scale(transform, { width, height, 1.f });
+                                    transform      = math::translate(transform, math::fvec3 { position.x, position.y, 0.f });
+
+                                    return math::transpose(transform);
+                                })
+                              | stdr::to<std::vector>();
+        std::ignore = matrices;
+    });
+
+    // only the matrix product chains of that update, from the same arrays as the kernel
+    auto matrices     = std::vector<math::fmat4>(sprite_count);
+    const auto legacy = measure([&] noexcept {
+        for (auto i : range(sprite_count)) {
+            auto transform = math::fmat4::identity();
+            transform      = math::scale(transform, { transforms.width[i], transforms.height[i], 1.f });
+            transform      = math::translate(transform, math::fvec3 { transforms.position_x[i], transforms.position_y[i], 0.f });
+            matrices[i]    = math::transpose(transform);
+        }
+    });
+
+    auto       instances = std::vector<engine::pipeline_2d::SpriteInstance>(sprite_count);
+    const auto kernel    = measure([&] noexcept { engine::pipeline_2d::compute_sprite_instances(transforms, instances); });
+
+    std::println("{} sprites, {} runs", sprite_count, RUN_COUNT);
+    std::println("previous update (world lock, component fetches, matrices): best {:.3f} ms, average {:.3f} ms",
+                 previous.best.count(),
+                 previous.average.count());
+    std::println("per sprite matrices only: best {:.3f} ms, average {:.3f} ms", legacy.best.count(), legacy.average.count());
+    std::println("{} kernel: best {:.3f} ms, average {:.3f} ms",
+                 engine::pipeline_2d::sprite_transforms_kernel_name(),
+                 kernel.best.count(),
+                 kernel.average.count());
+
+    return EXIT_SUCCESS;
+}
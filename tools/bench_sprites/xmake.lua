@@ -0,0 +1,13 @@
+target("bench_sprites", function()
+    set_kind("binary")
+    set_languages("cxxlatest", "clatest")
+
+    set_basename("stormkit-bench-sprites")
+
+    add_rules(stormkit_rule_prefix .. "stormkit::application")
+    set_values("stormkit.components", { "stormkit", "log", "entities", "image", "wsi", "gpu", "lua" })
+
+    add_files("src/**.cpp")
+
+    add_deps("stormkit::engine")
+end)
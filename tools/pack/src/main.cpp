@@ -0,0 +1,61 @@
+#include <cstdlib>
+
+import std;
+
+import stormkit;
+import stormkit.engine;
+
+#include <stormkit/main/main_macro.hpp>
+
+using namespace stormkit;
+
+namespace stdfs = std::filesystem;
+namespace stdr  = std::ranges;
+namespace stdv  = std::views;
+
+////////////////////////////////////////
+////////////////////////////////////////
+auto main(std::span<const std::string_view> args) -> int {
+    auto logger_singleton = log::Logger::create_logger_instance<log::ConsoleLogger>();
+
+    auto arguments = args | stdv::drop(1) | stdr::to<std::vector>();
+
+    // scripts are compiled to Luau bytecode, the game then never parse their source
+    const auto bytecode = not stdr::empty(arguments) and arguments.front() == "--bytecode";
+    if (bytecode) arguments.erase(stdr::begin(arguments));
+
+    if (stdr::size(arguments) < 3) {
+        std::println(std::cerr, "usage: stormkit-pack [--bytecode] <root> <output> <directory>...");
+        return EXIT_FAILURE;
+    }
+
+    const auto root        = stdfs::path { arguments[0] };
+    const auto output      = stdfs::path { arguments[1] };
+    const auto directories = arguments
+                             | stdv::drop(2)
+                             | stdv::transform([](const auto& arg) static noexcept { return stdfs::path { arg }; })
+                             | stdr::to<std::vector>();
+
+    const auto compile = [](std::string& name, engine::FileData& file) static noexcept {
+        auto path = stdfs::path { name };
+        if (path.extension() != ".lua") return true;
+
+        auto compiled = engine::LuaEngine::compile(file.as_string_view());
+        if (not compiled) {
+            std::println(std::cerr, "{}: {}", name, compiled.error());
+            return false;
+        }
+
+        auto       storage = std::make_shared<const std::string>(*std::move(compiled));
+        const auto data    = std::as_bytes(std::span { *storage });
+        file               = { .storage = std::move(storage), .data = data };
+        name               = path.replace_extension(engine::LuaEngine::BYTECODE_EXTENSION).generic_string();
+
+        return true;
+    };
+
+    const auto transform = bytecode ? engine::AssetPack::Transform { compile } : engine::AssetPack::Transform {};
+    if (not engine::AssetPack::build(root, directories, output, transform)) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
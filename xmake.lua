@@ -169,12 +169,15 @@ namespace("stormkit", function()
         add_files("shaders/**.wgsl")
 
         add_defines("STORMKIT_ENGINE_BUILD", { public = false })
+        if get_config("devmode") then add_defines("STORMKIT_ENGINE_DEVMODE", { public = false }) end
 
         add_embeddirs("$(builddir)/shaders")
         add_cxflags("--embed-dir=$(builddir)/shaders")
 
-        add_packages("slang")
+        add_packages("libktx", "slang", "luau")
     end)
 
+    includes("tools/pack/xmake.lua")
+    includes("tools/bench_sprites/xmake.lua")
     includes("game/xmake.lua")
 end)